@@ -102,11 +102,24 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
   char *iTuple, *oTuple;
   FILE *out; char *proj;
   int nPercentBefore, nPercent;
-  int last_tri = -1;
+  double *vx, *vy, *vh; int nvsize; // vertices of a shape
+  GEO_CTX ctx;
+  GEO_PLAN plan;
+  GEO_GRID grid;
 
   if (inpurl == NULL) return 1;
   if (msg != NULL) msg[0] = '\0';
 
+  // Take current settings and resolve transformation once for the whole
+  // file (later changes of settings don't affect this conversion)
+  geo_ctx_init(&ctx);
+  if (geo_plan_init(&plan, tr, &ctx) != 0) {
+    snprintf(err, MAXS, "Unknown transformation: %d\n", tr);
+    if (msg == NULL) fprintf(stderr, "%s", err);
+    else xstrncat(msg, err, MAXL);
+    return 1;
+  }
+
   xstrncpy(inpname, inpurl, MAXS);
   if (outurl == NULL) outurl = inpurl;
 
@@ -185,6 +198,18 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
     return 4;
   }
 
+  // Interpolation grid instead of exact conversion (if tolerance is set)
+  grid.val = NULL;
+  if (ctx.gtol > 0.0) {
+    if (geo_grid_init(&grid, &plan, ctx.gtol) != 0) {
+      snprintf(err, MAXS, "Interpolation grid not possible for transformation %d, using exact conversion\n", tr);
+      if (msg == NULL) fprintf(stderr, "%s", err);
+      else xstrncat(msg, err, MAXL);
+    }
+    else if (debug) fprintf(stderr, "Interpolation grid %dx%d, max. deviation %.3e m\n",
+                            grid.nx, grid.ny, grid.maxerr);
+  }
+
   // determine output projection
   switch (tr) {
     case 1: // xy (d96tm) --> fila (etrs89)
@@ -207,6 +232,9 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
       proj = prj[EPSG_4326]; break; // WGS84
     case 10: // fila (etrs89) --> xy (d48gk), affine trans.
       proj = prj[EPSG_3787]; break; // D48/GK
+    case 11: // fila h --> fila H (etrs89), geoid only
+    case 12: // fila H --> fila h (etrs89), geoid only
+      proj = prj[EPSG_4326]; break; // WGS84
     default: // xy (d96tm) --> fila (etrs89)
       proj = prj[EPSG_4326]; break; // WGS84
   }
@@ -228,6 +256,7 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
   }
 
   // process entitites (shapes) in input shapefile
+  vx = NULL; vy = NULL; vh = NULL; nvsize = 0;
   warn = 1; nPercentBefore = -1;
   for (nEntity = 0; nEntity < nEntities; nEntity++) {
     psShape = SHPReadObject(iSHP, nEntity);
@@ -269,25 +298,36 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
       // ignore
     }
 
-    // process vertices in a shape
-    nPart = 1;
-    for (nVertex = 0; nVertex < psShape->nVertices; nVertex++) {
-      pszPartType = "";
-      if (nVertex == 0 && psShape->nParts > 0)
-        pszPartType = (char *)SHPPartTypeName(psShape->panPartType[0]);
-
-      if (nPart < psShape->nParts && psShape->panPartStart[nPart] == nVertex) {
-        pszPartType = (char *)SHPPartTypeName(psShape->panPartType[nPart]);
-        nPart++; pszPlus = "+";
+    // grow vertex buffers if needed
+    if (psShape->nVertices > nvsize) {
+      nvsize = psShape->nVertices;
+      free(vx);
+      vx = (double *)malloc(3*nvsize*sizeof(double));
+      if (vx == NULL) {
+        errtxt = xstrerror();
+        if (errtxt != NULL) {
+          snprintf(err, MAXS, "malloc(vx): %s\n", errtxt); free(errtxt);
+        } else
+          snprintf(err, MAXS, "malloc(vx): Can't allocate memory\n");
+        if (msg == NULL) fprintf(stderr, "%s", err);
+        else xstrncat(msg, err, MAXL);
+        SHPDestroyObject(psShape);
+        free(oTuple);
+        geo_grid_free(&grid);
+        SHPClose(iSHP); DBFClose(iDBF);
+        SHPClose(oSHP); DBFClose(oDBF);
+        return 4;
       }
-      else pszPlus = " ";
+      vy = vx + nvsize; vh = vy + nvsize;
+    }
 
-      // prepare data for transformation
-      if (tr == 2 || tr == 4 || tr == 10) { // etrs89
+    // prepare vertices in a shape for transformation
+    for (nVertex = 0; nVertex < psShape->nVertices; nVertex++) {
+      if (plan.ifila) { // etrs89
         ifl.fi = psShape->padfY[nVertex]; ifl.la = psShape->padfX[nVertex]; // reverse!
         ifl.h = psShape->padfZ[nVertex];
         if (rev) swapfila(&ifl);
-        if (ifl.la > 17.0) {
+        if (ifl.la > 17.0 && !ctx.zsel) { // other GK zones allowed
           if (warn) {
             snprintf(err, MAXS, "%s: possibly reversed fi/la\n", inpname);
             if (msg == NULL) fprintf(stderr, "%s", err);
@@ -295,6 +335,7 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
             warn = 0;
           }
         }
+        vx[nVertex] = ifl.fi; vy[nVertex] = ifl.la; vh[nVertex] = ifl.h;
       }
       else { // tr == 1,3,5,6,7,8,9 // d96tm/d48gk
         ixy.x = psShape->padfY[nVertex]; ixy.y = psShape->padfX[nVertex]; // reverse!
@@ -309,41 +350,34 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
             warn = 0;
           }
         }
+        vx[nVertex] = ixy.x; vy[nVertex] = ixy.y; vh[nVertex] = ixy.H;
       }
+    } // for each Vertice
 
-      // transform data
-      switch (tr) {
-        case 1: // xy (d96tm) --> fila (etrs89)
-          tmxy2fila_wgs(ixy, &ofl); break;
-        case 2: // fila (etrs89) --> xy (d96tm)
-          fila_wgs2tmxy(ifl, &oxy); break;
-        case 3: // xy (d48gk) --> fila (etrs89)
-          gkxy2fila_wgs(ixy, &ofl); break;
-        case 4: // fila (etrs89) --> xy (d48gk)
-          fila_wgs2gkxy(ifl, &oxy); break;
-        case 5: // xy (d48gk) --> xy (d96tm)
-          gkxy2tmxy(ixy, &oxy); break;
-        case 6: // xy (d96tm) --> xy (d48gk)
-          tmxy2gkxy(ixy, &oxy); break;
-        case 7: // xy (d48gk) --> xy (d96tm), affine trans.
-          gkxy2tmxy_aft(ixy, &oxy, &last_tri); break;
-        case 8: // xy (d96tm) --> xy (d48gk), affine trans.
-          tmxy2gkxy_aft(ixy, &oxy, &last_tri); break;
-        case 9: // xy (d48gk) --> fila (etrs89), affine trans.
-          gkxy2fila_wgs_aft(ixy, &ofl, &last_tri); break;
-        case 10: // fila (etrs89) --> xy (d48gk), affine trans.
-          fila_wgs2gkxy_aft(ifl, &oxy, &last_tri); break;
-        default: // xy (d96tm) --> fila (etrs89)
-          tmxy2fila_wgs(ixy, &ofl); break;
+    // transform all vertices in a shape at once (in place)
+    geo_plan_run(&plan, psShape->nVertices, vx, vy, vh, vx, vy, vh, NULL);
+
+    // save transformed vertices
+    nPart = 1;
+    for (nVertex = 0; nVertex < psShape->nVertices; nVertex++) {
+      pszPartType = "";
+      if (nVertex == 0 && psShape->nParts > 0)
+        pszPartType = (char *)SHPPartTypeName(psShape->panPartType[0]);
+
+      if (nPart < psShape->nParts && psShape->panPartStart[nPart] == nVertex) {
+        pszPartType = (char *)SHPPartTypeName(psShape->panPartType[nPart]);
+        nPart++; pszPlus = "+";
       }
+      else pszPlus = " ";
 
-      // save transformed data
-      if (tr == 1 || tr == 3 || tr == 9) { // etrs89
+      if (plan.ofila) { // etrs89
+        ofl.fi = vx[nVertex]; ofl.la = vy[nVertex]; ofl.h = vh[nVertex];
         if (rev) swapfila(&ofl);
         psShape->padfX[nVertex] = ofl.la; psShape->padfY[nVertex] = ofl.fi; // reverse!
         psShape->padfZ[nVertex] = ofl.h;
       }
       else { // tr == 2,4,5,6,7,8,10 // d96tm/d48gk
+        oxy.x = vx[nVertex]; oxy.y = vy[nVertex]; oxy.H = vh[nVertex];
         if (rev) swapxy(&oxy);
         psShape->padfX[nVertex] = oxy.y; psShape->padfY[nVertex] = oxy.x; // reverse!
         psShape->padfZ[nVertex] = oxy.H;
@@ -386,6 +420,9 @@ int convert_shp_file(char *inpurl, char *outurl, char *msg)
          + (double)(stop.tv_nsec - start.tv_nsec)/NANOSEC;
   if (debug) fprintf(stderr, "Processing time: %f\n", tdif);
 
+  free(vx); free(oTuple);
+  geo_grid_free(&grid);
+
   SHPClose(iSHP); DBFClose(iDBF);
   SHPClose(oSHP); DBFClose(oDBF);
 
@@ -32,10 +32,44 @@ extern int debug;
 extern int tr;      // transformation
 extern int rev;     // reverse xy/fila
 extern int wdms;    // write DMS
+extern int rtrip;   // round-trip verification
 
 extern int gid_wgs; // selected geoid on WGS 84 (in geo.c)
 extern int hsel;    // output height calculation (in geo.c)
 
+#define BLKSIZE 4096 // number of points converted together
+#define MTBLKSIZE 65536 // ... with several threads (enough work for each)
+#define RTTOL 0.001  // round-trip verification tolerance (in m)
+
+// ----------------------------------------------------------------------------
+// write_xyz_block
+// Convert block of nb points with geo_plan_run() and write them out
+// ----------------------------------------------------------------------------
+void write_xyz_block(const GEO_PLAN *plan, FILE *out, int nb, double *bx, double *by,
+                     double *bh, char *lbuf, int *lofs)
+{
+  int ii;
+  DMS lat, lon;
+
+  // Convert coordinates (in place)
+  geo_plan_run(plan, nb, bx, by, bh, bx, by, bh, NULL);
+
+  for (ii = 0; ii < nb; ii++) {
+    if (plan->ofila) { // etrs89
+      fprintf(out, "%s%.9f %.9f %.3f", &lbuf[lofs[ii]], bx[ii], by[ii], bh[ii]);
+      if (wdms) {
+	deg2dms(bx[ii], &lat); deg2dms(by[ii], &lon);
+	fprintf(out, " %.0f %2.0f %8.5f %.0f %2.0f %8.5f\n",
+	  lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
+      }
+      else fprintf(out, "\n");
+    }
+    else // tr == 2,4,5,6,7,8,10 // d96tm/d48gk
+      fprintf(out, "%s%.3f %.3f %.3f\n", &lbuf[lofs[ii]], bx[ii], by[ii], bh[ii]);
+  }
+} /* write_xyz_block */
+
+
 // ----------------------------------------------------------------------------
 // convert_xyz_file
 // ellipsoid_init() and params_init() must be called before this!
@@ -48,15 +82,32 @@ int convert_xyz_file(char *url, int outf, FILE *out, char *msg)
   char line[MAXS+1], col1[MAXS+1];
   int inpf, ln, n, warn;
   double fi, la, h, x, y, H, tmp;
-  GEOGRA fl; GEOUTM xy, gkxy, tmxy;
-  DMS lat, lon;
+  double *bx, *by, *bh; // block of points to convert
+  double *sx; // saved input of block (round-trip verification)
+  char *lbuf; int *lofs, lsize, llen, nb; // labels of points in block
+  int bsize; // number of points in block
   struct timespec start, stop;
   double tdif;
-  int last_tri = -1;
+  GEO_CTX ctx;
+  GEO_PLAN plan;
+  GEO_GRID grid;
+  GEO_JAC jac;
+  GEO_PLAN rplan;
+  double rtmax; long rtn, rtbad;
 
   if (url == NULL) return 1;
   if (msg != NULL) msg[0] = '\0';
 
+  // Take current settings and resolve transformation once for the whole
+  // file (later changes of settings don't affect this conversion)
+  geo_ctx_init(&ctx);
+  if (geo_plan_init(&plan, tr, &ctx) != 0) {
+    snprintf(err, MAXS, "Unknown transformation: %d\n", tr);
+    if (msg == NULL) fprintf(stderr, "%s", err);
+    else xstrncat(msg, err, MAXL);
+    return 1;
+  }
+
   // Open input file
   if (strcmp(url, "-") == 0) {
     xstrncpy(inpname, "<stdin>", MAXS);
@@ -100,6 +151,56 @@ int convert_xyz_file(char *url, int outf, FILE *out, char *msg)
     }
   }
 
+  // Allocate block buffers
+  bsize = (ctx.nthr != 1) ? MTBLKSIZE : BLKSIZE;
+  bx = (double *)malloc(bsize*(3*sizeof(double) + sizeof(int)));
+  lsize = bsize*16;
+  lbuf = (char *)malloc(lsize);
+  sx = NULL;
+  if (rtrip) sx = (double *)malloc(bsize*3*sizeof(double));
+  if (bx == NULL || lbuf == NULL || (rtrip && sx == NULL)) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      snprintf(err, MAXS, "malloc(block): %s\n", errtxt); free(errtxt);
+    } else
+      snprintf(err, MAXS, "malloc(block): Can't allocate memory\n");
+    if (msg == NULL) fprintf(stderr, "%s", err);
+    else xstrncat(msg, err, MAXL);
+    free(bx); free(lbuf); free(sx);
+    if (inpf == 2) fclose(inp);
+    if (outf == 2) fclose(out);
+    return 4;
+  }
+  by = bx + bsize; bh = by + bsize;
+  lofs = (int *)(bh + bsize);
+  nb = 0; llen = 0;
+
+  // Interpolation grid instead of exact conversion (if tolerance is set)
+  grid.val = NULL;
+  if (ctx.gtol > 0.0) {
+    if (geo_grid_init(&grid, &plan, ctx.gtol) != 0) {
+      snprintf(err, MAXS, "Interpolation grid not possible for transformation %d, using exact conversion\n", tr);
+      if (msg == NULL) fprintf(stderr, "%s", err);
+      else xstrncat(msg, err, MAXL);
+    }
+    else if (debug) fprintf(stderr, "Interpolation grid %dx%d, max. deviation %.3e m\n",
+                            grid.nx, grid.ny, grid.maxerr);
+  }
+
+  // Linear maps of small cells for dense point clouds (if tolerance is set)
+  jac.cells = NULL;
+  if (ctx.jtol > 0.0 && plan.grid == NULL) {
+    if (geo_jac_init(&jac, &plan, ctx.jtol, 0.0) != 0) {
+      snprintf(err, MAXS, "Linearization not possible for transformation %d, using exact conversion\n", tr);
+      if (msg == NULL) fprintf(stderr, "%s", err);
+      else xstrncat(msg, err, MAXL);
+    }
+  }
+
+  // Exact inverse transformation for round-trip verification
+  rtmax = 0.0; rtn = 0; rtbad = 0;
+  if (rtrip) geo_plan_inverse(&rplan, &plan, &ctx);
+
   if (debug) fprintf(stderr, "Processing %s\n", inpname);
   clock_gettime(CLOCK_REALTIME, &start);
 
@@ -125,7 +226,7 @@ int convert_xyz_file(char *url, int outf, FILE *out, char *msg)
 
     // Parse line
     s = xstrtrim(line);
-    if (tr == 2 || tr == 4 || tr == 10) { // etrs89
+    if (plan.ifila) { // etrs89
       // try with blank (SiTra)
       n = sscanf(s, "%10240s %lf %lf %lf", col1, &fi, &la, &h);
       if (n != 4) {
@@ -158,7 +259,7 @@ int convert_xyz_file(char *url, int outf, FILE *out, char *msg)
         else xstrncat(msg, err, MAXL);
 	continue;
       }
-      if (la > 17.0) {
+      if (la > 17.0 && !ctx.zsel) { // other GK zones allowed
 	if (warn) {
           snprintf(err, MAXS, "%s: possibly reversed fi/la\n", inpname);
           if (msg == NULL) fprintf(stderr, "%s", err);
@@ -211,91 +312,67 @@ int convert_xyz_file(char *url, int outf, FILE *out, char *msg)
       }
     }
 
-    // Convert coordinates
-    if (tr == 1) { // xy (d96tm) --> fila (etrs89)
-      xy.x = x; xy.y = y; xy.H = H;
-      tmxy2fila_wgs(xy, &fl);
-      fprintf(out, "%s%.9f %.9f %.3f", col1, fl.fi, fl.la, fl.h);
-      if (wdms) {
-	deg2dms(fl.fi, &lat); deg2dms(fl.la, &lon);
-	fprintf(out, " %.0f %2.0f %8.5f %.0f %2.0f %8.5f\n",
-	  lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
-      }
-      else fprintf(out, "\n");
+    // Add point to current block
+    if (plan.ifila) { // etrs89
+      bx[nb] = fi; by[nb] = la; bh[nb] = h;
     }
-
-    else if (tr == 2) { // fila (etrs89) --> xy (d96tm)
-      fl.fi = fi; fl.la = la; fl.h = h;
-      fila_wgs2tmxy(fl, &xy);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, xy.x, xy.y, xy.H);
+    else { // tr == 1,3,5,6,7,8,9 // d96tm/d48gk
+      bx[nb] = x; by[nb] = y; bh[nb] = H;
     }
-
-    else if (tr == 3) { // xy (d48gk) --> fila (etrs89)
-      // SiTra: h,H/H(tr), gk-slo: hsel = ht ==> OK
-      // SiTra: h=0,H=0/H(tr)=h-N, gk-slo: hsel = ht ==> OK (isti input!)
-      // SiTra: h=0,H=0/H(tr)=h-N, gk-slo: hsel = hg ==> 40-70cm razlike
-      xy.x = x; xy.y = y; xy.H = H;
-      gkxy2fila_wgs(xy, &fl);
-      fprintf(out, "%s%.9f %.9f %.3f", col1, fl.fi, fl.la, fl.h);
-      if (wdms) {
-	deg2dms(fl.fi, &lat); deg2dms(fl.la, &lon);
-	fprintf(out, " %.0f %2.0f %8.5f %.0f %2.0f %8.5f\n",
-	  lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
+    n = strlen(col1) + 1;
+    if (lsize - llen < n) {
+      lsize = 2*lsize + n;
+      s = (char *)realloc(lbuf, lsize);
+      if (s == NULL) {
+        errtxt = xstrerror();
+        if (errtxt != NULL) {
+          snprintf(err, MAXS, "realloc(lbuf): %s\n", errtxt); free(errtxt);
+        } else
+          snprintf(err, MAXS, "realloc(lbuf): Can't allocate memory\n");
+        if (msg == NULL) fprintf(stderr, "%s", err);
+        else xstrncat(msg, err, MAXL);
+        break;
       }
-      else fprintf(out, "\n");
-    }
-
-    else if (tr == 4) { // fila (etrs89) --> xy (d48gk)
-      // SiTra: h,H/H(tr), gk-slo: hsel = ht ==> OK
-      // SiTra: h=0,H=0/H(tr)=h-N, gk-slo: hsel = hg ==> OK
-      // SiTra: h=0,H=0/H(tr)=h-N, gk-slo: hsel = ht ==> 40-70cm razlike
-      fl.fi = fi; fl.la = la; fl.h = h;
-      fila_wgs2gkxy(fl, &xy);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, xy.x, xy.y, xy.H);
+      lbuf = s;
     }
+    memcpy(&lbuf[llen], col1, n);
+    lofs[nb] = llen; llen += n;
+    nb++;
 
-    else if (tr == 5) { // xy (d48gk) --> xy (d96tm)
-      xy.x = x; xy.y = y; xy.H = H;
-      gkxy2tmxy(xy, &tmxy);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, tmxy.x, tmxy.y, tmxy.H);
-    }
-
-    else if (tr == 6) { // xy (d96tm) --> xy (d48gk)
-      xy.x = x; xy.y = y; xy.H = H;
-      tmxy2gkxy(xy, &gkxy);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, gkxy.x, gkxy.y, gkxy.H);
-    }
-
-    else if (tr == 7) { // xy (d48gk) --> xy (d96tm), affine trans.
-      xy.x = x; xy.y = y; xy.H = H;
-      gkxy2tmxy_aft(xy, &tmxy, &last_tri);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, tmxy.x, tmxy.y, tmxy.H);
-    }
-
-    else if (tr == 8) { // xy (d96tm) --> xy (d48gk), affine trans.
-      xy.x = x; xy.y = y; xy.H = H;
-      tmxy2gkxy_aft(xy, &gkxy, &last_tri);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, gkxy.x, gkxy.y, gkxy.H);
-    }
-
-    else if (tr == 9) { // xy (d48gk) --> fila (etrs89), affine trans.
-      xy.x = x; xy.y = y; xy.H = H;
-      gkxy2fila_wgs_aft(xy, &fl, &last_tri);
-      fprintf(out, "%s%.9f %.9f %.3f", col1, fl.fi, fl.la, fl.h);
-      if (wdms) {
-	deg2dms(fl.fi, &lat); deg2dms(fl.la, &lon);
-	fprintf(out, " %.0f %2.0f %8.5f %.0f %2.0f %8.5f\n",
-	  lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
+    // Convert and write full block
+    if (nb >= bsize) {
+      if (rtrip) memcpy(sx, bx, bsize*3*sizeof(double));
+      write_xyz_block(&plan, out, nb, bx, by, bh, lbuf, lofs);
+      if (rtrip) {
+        rtbad += geo_plan_check(&rplan, nb, sx, sx + bsize, bx, by, bh, RTTOL, &rtmax);
+        rtn += nb;
       }
-      else fprintf(out, "\n");
+      nb = 0; llen = 0;
     }
+  } // while !eof
 
-    else if (tr == 10) { // fila (etrs89) --> xy (d48gk), affine trans.
-      fl.fi = fi; fl.la = la; fl.h = h;
-      fila_wgs2gkxy_aft(fl, &xy, &last_tri);
-      fprintf(out, "%s%.3f %.3f %.3f\n", col1, xy.x, xy.y, xy.H);
+  // Convert and write last (partial) block
+  if (nb > 0) {
+    if (rtrip) memcpy(sx, bx, bsize*3*sizeof(double));
+    write_xyz_block(&plan, out, nb, bx, by, bh, lbuf, lofs);
+    if (rtrip) {
+      rtbad += geo_plan_check(&rplan, nb, sx, sx + bsize, bx, by, bh, RTTOL, &rtmax);
+      rtn += nb;
     }
-  } // while !eof
+  }
+  free(bx); free(lbuf); free(sx);
+  if (rtrip) {
+    // inpname is shortened so that numbers always fit into err
+    snprintf(err, MAXS, "%.*s: round-trip of %ld points: max. deviation %.3e m, %ld above %g m\n",
+             MAXS - 128, inpname, rtn, rtmax, rtbad, RTTOL);
+    if (msg == NULL) fprintf(stderr, "%s", err);
+    else xstrncat(msg, err, MAXL);
+  }
+  geo_grid_free(&grid);
+  if (debug && jac.cells != NULL)
+    fprintf(stderr, "Linearization: %ld points linearized (max. deviation %.3e m), %ld exact\n",
+            jac.nlin, jac.maxerr, jac.nexact);
+  geo_jac_free(&jac);
 
   clock_gettime(CLOCK_REALTIME, &stop);
   tdif = (stop.tv_sec - start.tv_sec)
@@ -19,10 +19,21 @@
 //
 #include "common.h"
 #include "geo.h"
+#include <pthread.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 
 // Select meridian arc length (L) calculation algorithm
 #define L1 //else L2
 #undef  L3 // alternative
+#define L4 // Clenshaw summation of L1/L2 series (one sin/cos pair)
+
+// Select evaluation of TM projection series
+#ifndef PS2 // term by term (as in literature, -DPS2 for comparison)
+#define PS1 // Horner form without pow() (fast)
+#endif
 
 // Select fi0 calculation algorithm (geocentric to geodetic coordinates)
 #define FI1 //else FI2
@@ -51,11 +62,24 @@ ELLIPSOID ellips[3];
 // y: 362633.289 - 633083.271 (D96/TM)
 // y: 363001.945 - 633454.830 (D48/GK)
 // la: 1315' - 1645' = 210'/1.0' = 210
-double geoid_bes[106][141];   // (doesn't exist) on Bessel 1841 (0)
+// (compile with -DNOGEOID to leave them out, they can be loaded with
+// geoid_load() from files written by geoid_save())
+#ifndef NOGEOID
 //double geoid_slo[106][141]; // Slo2000 on WGS 84 (1)
 #include "geoid_slo.h"
 //double geoid_egm[106][211]; // EGM2008 on WGS 84 (2)
 #include "geoid_egm.h"
+
+// Compact geoid models used by geoid_height() (packed by params_init), about
+// 33 KB (Slo2000) and 50 KB (EGM2008) instead of 117 KB and 175 KB
+#define GEOID_TILES(nx, ny) \
+  (((nx) + GEO_TILE - 1)/GEO_TILE*(((ny) + GEO_TILE - 1)/GEO_TILE))
+static short geoid_slo_val[GEOID_TILES(106, 141)*GEO_TILE*GEO_TILE];
+static unsigned char geoid_slo_valid[GEOID_TILES(106, 141)*GEO_TILE];
+static short geoid_egm_val[GEOID_TILES(106, 211)*GEO_TILE*GEO_TILE];
+static unsigned char geoid_egm_valid[GEOID_TILES(106, 211)*GEO_TILE];
+#endif
+GEO_GEOID geoids[3]; // 0: bessel (doesn't exist), 1: slo2000, 2: egm2008
 double gfimin, gfimax, gfiinc1;
 double glamin, glamax, glainc15, glainc1;
 
@@ -72,6 +96,13 @@ int hsel;    // selected output height (via cmd line)
 //   0-5m for Bessel 1841
 //   45-48m for WGS 84 (EGM96)
 
+int tmsel;   // selected TM projection series (via cmd line)
+double gtol; // interpolation grid tolerance in m (via cmd line)
+double jtol; // linearization cache tolerance in m (via cmd line)
+int csel;    // Chebyshev approximation (via cmd line)
+int nthr = 1; // number of threads in batch conversions (via cmd line)
+int zsel;    // multi-zone GK coordinates (via cmd line)
+
 // German expressions:
 // Breite = Latitude (N/S)
 // Laenge = Longitude (E/W)
@@ -99,12 +130,37 @@ GKLM gkzones[] = {
 //AFT aft_tmgk[MAXAFT];  // Affine transformation table from TM to GK for Slovenia
 #include "aft_tmgk.h"
 
+// Uniform grid indexes of AFT triangles (built by params_init): each cell
+// has a short list of triangles whose bounding boxes overlap it, in the
+// order of the former linear search (from the middle of the table in both
+// directions), so points on common edges get the same triangle as before
+#define AFT_CELL 5000.0 // cell size in m (typical triangle is about 6 km)
+typedef struct aft_index {
+  double xmin, ymin; // lower left corner of grid
+  int nx, ny;        // number of cells
+  int *first;        // triangles of cell k: tri[first[k]] .. tri[first[k+1]-1]
+  short *tri;        // (NULL: no index, linear search)
+} AFT_INDEX;
+static AFT_INDEX aft_gktm_idx, aft_tmgk_idx;
+static int aft_index_init(AFT_INDEX *idx, const AFT *aft);
+
+// Pre-calculated Chebyshev approximations of transformations 1-6
+//GEO_CHEB geo_cheb[6]; // generated with gk-slo -gc
+#include "geo_cheb.h"
+
+// Number of points processed together in batch conversions
+#define MAXCHUNK 256
+
+// Maximum number of Newton iterations in projection inversion
+#define MAXITER 10
+
 // Distance to triangle segment
 #define EPSILON  0.001
 #define EPSILON2 EPSILON*EPSILON
 
 // Projection parameters
 PROJ tm;
+PROJ gkproj[GEO_MAXZONE]; // GK zones (zone number in front of easting)
 
 // Parameters for Helmert transformation
 HELMERT7 slo7, slo7inv;
@@ -278,7 +334,7 @@ void ellipsoid_precalc(int oid)
 void series_precalc(int oid)
 {
   double E2, E4, E6, E8, E10;
-  double N, N2, N3, N4, N5;
+  double N, N2, N3, N4, N5, N6;
 
   // Coefficients for series to determine meridian arc length (L) on ellipsoid
   // See "Geodesy - Introduction to Geodetic Datum and Geodetic Systems (Zhiping, 2014), pg. 194"
@@ -318,6 +374,23 @@ void series_precalc(int oid)
   ellipsoid.F = 639.0/131072.0*E10;
 #endif
 
+  // Same series with constant factors included (for L4 and vectorized kernels)
+#ifdef L1
+  ellipsoid.arc[0] = ellipsoid.c*ellipsoid.A;
+  ellipsoid.arc[1] = ellipsoid.c*ellipsoid.B/2.0;
+  ellipsoid.arc[2] = ellipsoid.c*ellipsoid.C/4.0;
+  ellipsoid.arc[3] = ellipsoid.c*ellipsoid.D/6.0;
+  ellipsoid.arc[4] = ellipsoid.c*ellipsoid.E/8.0;
+  ellipsoid.arc[5] = ellipsoid.c*ellipsoid.F/10.0;
+#else //L2
+  ellipsoid.arc[0] = ellipsoid.M*ellipsoid.A;
+  ellipsoid.arc[1] = -ellipsoid.M*ellipsoid.B/2.0;
+  ellipsoid.arc[2] = ellipsoid.M*ellipsoid.C/4.0;
+  ellipsoid.arc[3] = -ellipsoid.M*ellipsoid.D/6.0;
+  ellipsoid.arc[4] = ellipsoid.M*ellipsoid.E/8.0;
+  ellipsoid.arc[5] = -ellipsoid.M*ellipsoid.F/10.0;
+#endif
+
   // Coefficients for series to determine fi0 on ellipsoid (alternative way)
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 22-23"
   //   for sin() variant (alfa, ...; similar to above)
@@ -332,6 +405,36 @@ void series_precalc(int oid)
   ellipsoid.gama = 21.0/16.0*N2 - 55.0/32.0*N4;
   ellipsoid.delta = 151.0/96.0*N3 - 417.0/128.0*N5;
   ellipsoid.epsilon = 1097.0/512.0*N4;
+
+  // Coefficients for Krueger n-series (TM projection, tmsel = 1)
+  // See "Transverse Mercator with an accuracy of a few nanometers (Karney, 2011)"
+  N6 = N3*N3;
+  ellipsoid.kA = ellipsoid.a/(1.0 + N)*(1.0 + N2/4.0 + N4/64.0 + N6/256.0);
+  ellipsoid.ke = sqrt(ellipsoid.e2);
+
+  ellipsoid.kalp[0] = 0.0;
+  ellipsoid.kalp[1] = N/2.0 - 2.0/3.0*N2 + 5.0/16.0*N3 + 41.0/180.0*N4
+    - 127.0/288.0*N5 + 7891.0/37800.0*N6;
+  ellipsoid.kalp[2] = 13.0/48.0*N2 - 3.0/5.0*N3 + 557.0/1440.0*N4
+    + 281.0/630.0*N5 - 1983433.0/1935360.0*N6;
+  ellipsoid.kalp[3] = 61.0/240.0*N3 - 103.0/140.0*N4 + 15061.0/26880.0*N5
+    + 167603.0/181440.0*N6;
+  ellipsoid.kalp[4] = 49561.0/161280.0*N4 - 179.0/168.0*N5
+    + 6601661.0/7257600.0*N6;
+  ellipsoid.kalp[5] = 34729.0/80640.0*N5 - 3418889.0/1995840.0*N6;
+  ellipsoid.kalp[6] = 212378941.0/319334400.0*N6;
+
+  ellipsoid.kbet[0] = 0.0;
+  ellipsoid.kbet[1] = N/2.0 - 2.0/3.0*N2 + 37.0/96.0*N3 - 1.0/360.0*N4
+    - 81.0/512.0*N5 + 96199.0/604800.0*N6;
+  ellipsoid.kbet[2] = 1.0/48.0*N2 + 1.0/15.0*N3 - 437.0/1440.0*N4
+    + 46.0/105.0*N5 - 1118711.0/3870720.0*N6;
+  ellipsoid.kbet[3] = 17.0/480.0*N3 - 37.0/840.0*N4 - 209.0/4480.0*N5
+    + 5569.0/90720.0*N6;
+  ellipsoid.kbet[4] = 4397.0/161280.0*N4 - 11.0/504.0*N5
+    - 830251.0/7257600.0*N6;
+  ellipsoid.kbet[5] = 4583.0/161280.0*N5 - 108847.0/3991680.0*N6;
+  ellipsoid.kbet[6] = 20648693.0/638668800.0*N6;
 } /* series_precalc */
 
 
@@ -372,6 +475,7 @@ void h7_precalc(HELMERT7 *h7)
   double alfa, beta, gama;
   double sinAlfa, cosAlfa, sinBeta, cosBeta, sinGama, cosGama;
   m33 R1, R2, R3, R12;
+  double dm1; int ii, jj;
   char *errtxt;
 
   // Angles specified in arc seconds, convert to radians
@@ -438,6 +542,24 @@ void h7_precalc(HELMERT7 *h7)
   matrix33_mul(R1,  R2, &R12);
   matrix33_mul(R12, R3, h7->R);
 #endif
+
+#if defined(H71) || defined(H72)
+  // Rotation matrix multiplied by scale (1 + s), used by xyz2xyz_helmert
+  h7->sR = (m33 *)malloc(sizeof(m33));
+  if (h7->sR == NULL) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      fprintf(stderr, "malloc(m33): %s\n", errtxt); free(errtxt);
+    } else
+      fprintf(stderr, "malloc(m33): Can't allocate memory\n");
+    exit(3);
+  }
+
+  dm1 = 1.0 + h7->dm*1e-6;
+  for (ii = 0; ii < 3; ii++)
+    for (jj = 0; jj < 3; jj++)
+      (*h7->sR)[ii][jj] = dm1*(*h7->R)[ii][jj];
+#endif
 } /* h7_precalc */
 
 
@@ -448,6 +570,7 @@ void params_init()
 {
   DMS lat, lon;
   double dlat, dlon;
+  int zone;
 
   // http://en.wikipedia.org/wiki/Helmert_transformation
   // Parameters for Slovenia ETRS89 (D48/GK --> D96/TM)
@@ -486,6 +609,15 @@ void params_init()
   tm.meridian = 15; // central meridian for Slovenia
   tm.lambda0 = tm.meridian*PI/180.0; //0.26179938779914941
 
+  // Gauss-Krueger zones (same scale and false northing as above, zone number
+  // in front of false easting, e.g. 5500000 for zone 5 with meridian 15)
+  for (zone = 0; zone < GEO_MAXZONE; zone++) {
+    gkproj[zone] = tm;
+    gkproj[zone].meridian = 3*zone;
+    gkproj[zone].lambda0 = gkproj[zone].meridian*PI/180.0;
+    gkproj[zone].false_easting = zone*1000000.0 + tm.false_easting;
+  }
+
   // Absolute geoid model limits
   // fi: 4515' - 4700', inc: 1.0'
   lat.deg = 45; lat.min = 15; lat.sec = 0;
@@ -504,70 +636,332 @@ void params_init()
   lon.deg = 0; lon.min = 1; lon.sec = 0;
   dms2deg(lon, &dlon); glainc1 = dlon;
 
+  // Indexes of constant AFT tables (built only once)
+  if (aft_gktm_idx.tri == NULL) aft_index_init(&aft_gktm_idx, aft_gktm);
+  if (aft_tmgk_idx.tri == NULL) aft_index_init(&aft_tmgk_idx, aft_tmgk);
+
+  // Compact geoid models (models loaded from files are kept)
   // There's no data available for geoid on Bessel 1841!
-  memset(geoid_bes, 0, sizeof(geoid_bes));
+  memset(&geoids[0], 0, sizeof(GEO_GEOID));
+#ifndef NOGEOID
+  if (geoids[1].map == NULL) {
+    geoid_free(1);
+    if (geoid_pack(&geoids[1], &geoid_slo[0][0], 106, 141, geoid_slo_val, geoid_slo_valid) != 0) {
+      fprintf(stderr, "geoid_pack(slo2000): Geoid heights don't fit into 16 bits\n");
+      exit(3);
+    }
+    geoids[1].fimin = gfimin; geoids[1].fimax = gfimax; geoids[1].dfi = gfiinc1;
+    geoids[1].lamin = glamin; geoids[1].lamax = glamax; geoids[1].dla = glainc15;
+    geoids[1].dla0 = glainc15;
+  }
+  if (geoids[2].map == NULL) {
+    geoid_free(2);
+    if (geoid_pack(&geoids[2], &geoid_egm[0][0], 106, 211, geoid_egm_val, geoid_egm_valid) != 0) {
+      fprintf(stderr, "geoid_pack(egm2008): Geoid heights don't fit into 16 bits\n");
+      exit(3);
+    }
+    geoids[2].fimin = gfimin; geoids[2].fimax = gfimax; geoids[2].dfi = gfiinc1;
+    geoids[2].lamin = glamin; geoids[2].lamax = glamax; geoids[2].dla = glainc1;
+    geoids[2].dla0 = glainc15; // as in previous versions (same results)
+  }
+#endif
 } /* params_init */
 
 
+// ----------------------------------------------------------------------------
+// geoid_pack
+// ----------------------------------------------------------------------------
+// Pack geoid model src[nx][ny] (heights in meters, 0.0 where there is no
+// data) into compact model g (area and distance between nodes must be set
+// afterwards): heights in mm relative to base height, stored
+// in tiles of GEO_TILE x GEO_TILE nodes (128 bytes, neighbouring points are
+// mostly in the same tile), and separate validity bitmap. Buffers val and
+// valid must hold GEO_TILE*GEO_TILE and GEO_TILE elements per tile.
+// Heights are exact if they are given in mm (as in all supported models).
+// Returns 0 if OK or -1 if heights don't fit into 16 bits (g is cleared, so
+// there is no model).
+// ----------------------------------------------------------------------------
+int geoid_pack(GEO_GEOID *g, const double *src, int nx, int ny, short *val,
+               unsigned char *valid)
+{
+  double p, pmin, pmax;
+  int ii, jj, t, mm;
+
+  memset(g, 0, sizeof(GEO_GEOID));
+  g->nx = nx; g->ny = ny;
+  g->tx = (nx + GEO_TILE - 1)/GEO_TILE; g->ty = (ny + GEO_TILE - 1)/GEO_TILE;
+  g->val = val; g->valid = valid;
+  memset(val, 0, g->tx*g->ty*GEO_TILE*GEO_TILE*sizeof(short));
+  memset(valid, 0, g->tx*g->ty*GEO_TILE);
+
+  pmin = 1e9; pmax = -1e9;
+  for (ii = 0; ii < nx*ny; ii++) {
+    p = src[ii];
+    if (p == 0.0) continue; // no data
+    if (p < pmin) pmin = p;
+    if (p > pmax) pmax = p;
+  }
+  g->base = (pmin <= pmax) ? (int)xround((pmin + pmax)/2.0*1000.0) : 0;
+  if (pmin <= pmax && ((pmax - pmin)*1000.0/2.0 > 32000.0)) {
+    memset(g, 0, sizeof(GEO_GEOID));
+    return -1;
+  }
+
+  for (ii = 0; ii < nx; ii++)
+    for (jj = 0; jj < ny; jj++) {
+      p = src[ii*ny + jj];
+      if (p == 0.0) continue;
+      t = (ii/GEO_TILE)*g->ty + jj/GEO_TILE;
+      mm = (int)xround(p*1000.0) - g->base;
+      val[(t*GEO_TILE + ii%GEO_TILE)*GEO_TILE + jj%GEO_TILE] = (short)mm;
+      valid[t*GEO_TILE + ii%GEO_TILE] |= 1 << (jj%GEO_TILE);
+    }
+  return 0;
+} /* geoid_pack */
+
+
+// ----------------------------------------------------------------------------
+// geoid_free
+// ----------------------------------------------------------------------------
+// Unmap geoid model gid loaded with geoid_load() (compiled-in model is used
+// again after params_init())
+// ----------------------------------------------------------------------------
+void geoid_free(int gid)
+{
+  GEO_GEOID *g = &geoids[gid];
+
+  if (g->map != NULL) {
+#ifdef _WIN32
+    UnmapViewOfFile(g->map);
+#else
+    munmap(g->map, g->mapsize);
+#endif
+  }
+  memset(g, 0, sizeof(GEO_GEOID));
+} /* geoid_free */
+
+
+// Tolerance of model extent in geoid model file (in degrees)
+#define GEOID_EPS 1e-9
+
+// ----------------------------------------------------------------------------
+// geoid_load
+// ----------------------------------------------------------------------------
+// Map binary geoid model file fname (written by geoid_save) read-only into
+// memory and use it as geoid model gid (1: slo2000, 2: egm2008) instead of
+// compiled-in model. Pages of file are shared between all processes using
+// it and read only when needed. Must be called before conversions (and
+// before or after params_init).
+// Returns 0 if OK, -1 if file can't be mapped (errno/GetLastError is set)
+// or -2 if it is not a valid geoid model file.
+// ----------------------------------------------------------------------------
+int geoid_load(int gid, const char *fname)
+{
+  GEO_GEOID g;
+  GEO_GEOID_HDR *hdr;
+  size_t ntiles;
+#ifdef _WIN32
+  wchar_t *wfname;
+  HANDLE hf, hm;
+  LARGE_INTEGER fsize;
+#else
+  struct stat fst;
+  int fd;
+#endif
+
+  if (gid < 1 || gid > 2) return -2;
+  memset(&g, 0, sizeof(GEO_GEOID));
+
+#ifdef _WIN32
+  wfname = utf82wchar(fname);
+  if (wfname == NULL) { SetLastError(ERROR_NOT_ENOUGH_MEMORY); return -1; }
+  hf = CreateFileW(wfname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                   FILE_ATTRIBUTE_NORMAL, NULL);
+  free(wfname);
+  if (hf == INVALID_HANDLE_VALUE) return -1;
+  if (!GetFileSizeEx(hf, &fsize)) { CloseHandle(hf); return -1; }
+  g.mapsize = (size_t)fsize.QuadPart;
+  if (g.mapsize < sizeof(GEO_GEOID_HDR)) { CloseHandle(hf); return -2; }
+  hm = CreateFileMappingW(hf, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(hf);
+  if (hm == NULL) return -1;
+  g.map = MapViewOfFile(hm, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(hm); // view keeps mapping open
+  if (g.map == NULL) return -1;
+#else
+  fd = open(fname, O_RDONLY);
+  if (fd < 0) return -1;
+  if (fstat(fd, &fst) != 0) { close(fd); return -1; }
+  g.mapsize = (size_t)fst.st_size;
+  if (g.mapsize < sizeof(GEO_GEOID_HDR)) { close(fd); return -2; }
+  g.map = mmap(NULL, g.mapsize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd); // mapping stays valid
+  if (g.map == MAP_FAILED) return -1;
+#endif
+
+  // Check header, extent of model and size of file
+  hdr = (GEO_GEOID_HDR *)g.map;
+  ntiles = (size_t)hdr->tx*hdr->ty;
+  if (memcmp(hdr->magic, GEO_GEOID_MAGIC, 8) != 0 || hdr->order != GEO_GEOID_ORDER
+      || hdr->nx < 2 || hdr->ny < 2
+      || hdr->tx != (hdr->nx + GEO_TILE - 1)/GEO_TILE
+      || hdr->ty != (hdr->ny + GEO_TILE - 1)/GEO_TILE
+      || !(hdr->dfi > 0.0) || !(hdr->dla > 0.0) || !(hdr->dla0 > 0.0)
+      || !(fabs(hdr->fimin + (hdr->nx - 1)*hdr->dfi - hdr->fimax) <= GEOID_EPS)
+      || !(fabs(hdr->lamin + (hdr->ny - 1)*hdr->dla - hdr->lamax) <= GEOID_EPS)
+      || g.mapsize != sizeof(GEO_GEOID_HDR) + ntiles*GEO_TILE*(GEO_TILE*sizeof(short) + 1)) {
+#ifdef _WIN32
+    UnmapViewOfFile(g.map);
+#else
+    munmap(g.map, g.mapsize);
+#endif
+    return -2;
+  }
+
+  g.nx = hdr->nx; g.ny = hdr->ny; g.tx = hdr->tx; g.ty = hdr->ty;
+  g.base = hdr->base;
+  g.fimin = hdr->fimin; g.fimax = hdr->fimax; g.dfi = hdr->dfi;
+  g.lamin = hdr->lamin; g.lamax = hdr->lamax; g.dla = hdr->dla;
+  g.dla0 = hdr->dla0;
+  g.val = (const short *)(hdr + 1);
+  g.valid = (const unsigned char *)(g.val + ntiles*GEO_TILE*GEO_TILE);
+
+  geoid_free(gid);
+  geoids[gid] = g;
+  return 0;
+} /* geoid_load */
+
+
+// ----------------------------------------------------------------------------
+// geoid_save
+// ----------------------------------------------------------------------------
+// Write geoid model gid (1: slo2000, 2: egm2008; compiled-in or loaded) to
+// binary geoid model file fname (for geoid_load)
+// Returns 0 if OK, -1 if file can't be written (errno is set) or -2 if
+// there is no such model.
+// ----------------------------------------------------------------------------
+int geoid_save(int gid, const char *fname)
+{
+  const GEO_GEOID *g;
+  GEO_GEOID_HDR hdr;
+  size_t ntiles;
+  FILE *out;
+  int ok;
+
+  if (gid < 1 || gid > 2 || geoids[gid].val == NULL) return -2;
+  g = &geoids[gid];
+  ntiles = (size_t)g->tx*g->ty;
+
+  memset(&hdr, 0, sizeof(GEO_GEOID_HDR));
+  memcpy(hdr.magic, GEO_GEOID_MAGIC, 8); hdr.order = GEO_GEOID_ORDER;
+  hdr.nx = g->nx; hdr.ny = g->ny; hdr.tx = g->tx; hdr.ty = g->ty;
+  hdr.base = g->base;
+  hdr.fimin = g->fimin; hdr.fimax = g->fimax; hdr.dfi = g->dfi;
+  hdr.lamin = g->lamin; hdr.lamax = g->lamax; hdr.dla = g->dla;
+  hdr.dla0 = g->dla0;
+
+  out = utf8_fopen(fname, "wb");
+  if (out == NULL) return -1;
+  ok = fwrite(&hdr, sizeof(GEO_GEOID_HDR), 1, out) == 1
+    && fwrite(g->val, sizeof(short)*GEO_TILE*GEO_TILE, ntiles, out) == ntiles
+    && fwrite(g->valid, GEO_TILE, ntiles, out) == ntiles;
+  if (fclose(out) != 0) ok = 0;
+  return ok ? 0 : -1;
+} /* geoid_save */
+
+
+// ----------------------------------------------------------------------------
+// geoid_load_file
+// ----------------------------------------------------------------------------
+// Use geoid model gid from binary geoid model file fname instead of
+// compiled-in model (geoid_load with error reporting for gk-slo, gk-shp and
+// xgk-slo). Errors are written to stderr if msg is NULL, otherwise appended
+// to msg (MAXL).
+// Returns 0 if OK, -1 if file can't be mapped or -2 if it is not a valid
+// geoid model file.
+// ----------------------------------------------------------------------------
+int geoid_load_file(int gid, const char *fname, char *msg)
+{
+  char err[MAXS+1];
+  char *errtxt;
+  int rc;
+
+  rc = geoid_load(gid, fname);
+  if (rc == 0) return 0;
+  if (rc == -1) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      snprintf(err, MAXS, "%s: %s\n", fname, errtxt); free(errtxt);
+    } else
+      snprintf(err, MAXS, "%s: Can't map geoid model file\n", fname);
+  }
+  else
+    snprintf(err, MAXS, "%s: Not a valid geoid model file\n", fname);
+  if (msg == NULL) fprintf(stderr, "%s", err);
+  else xstrncat(msg, err, MAXL);
+  return rc;
+} /* geoid_load_file */
+
+
+// Tile row of geoid model node ix, iy (unsigned, so divisions are shifts),
+// height (in meters) and validity of node in tile row r, column c
+#define GEOID_ROW(g, ix, iy) \
+  (((unsigned)(ix)/GEO_TILE*(g)->ty + (unsigned)(iy)/GEO_TILE)*GEO_TILE + (unsigned)(ix)%GEO_TILE)
+#define GEOID_VAL(g, r, c) (((g)->base + (g)->val[(r)*GEO_TILE + (c)])/1000.0)
+#define GEOID_VALID(g, r, c) (((g)->valid[r] >> (c)) & 1)
+
+
 // ----------------------------------------------------------------------------
 // geoid_height (depends on ellipsoid)
 // ----------------------------------------------------------------------------
 // Geoid: 0: bessel, 1: slo2000/wgs84, 2: egm2008/wgs84
 double geoid_height(double fi, double la, int gid)
 {
+  const GEO_GEOID *g = &geoids[gid];
   double Ng = 0.0;
   double xi, yi; int ix, iy, gixmax, giymax;
   double x, y, x1, y1, x2, y2;
   double p1, p2, p3, p4;
   double R1, R2;
+  unsigned r1, r2, r3, c1, c2;
+
+  if (g->val == NULL) {
+    // No geoid model (bessel)
+    return Ng;
+  }
 
-  if (fi < gfimin || fi > gfimax || la < glamin || la > glamax) {
+  if (fi < g->fimin || fi > g->fimax || la < g->lamin || la > g->lamax) {
     // Outside geoid model
     return Ng;
   }
 
   x = fi; y = la;
 
-  xi = (fi - gfimin)/gfiinc1; ix = (int)xtrunc(xi);
-  if (gid == 2) yi = (la - glamin)/glainc1; //egm2008
-  else yi = (la - glamin)/glainc15; //slo2000, bessel
-  iy = (int)xtrunc(yi);
+  xi = (fi - g->fimin)/g->dfi; ix = (int)xtrunc(xi);
+  yi = (la - g->lamin)/g->dla; iy = (int)xtrunc(yi);
 
-  gixmax = 105; giymax = (gid == 2) ? 210 : 140;
+  gixmax = g->nx - 1; giymax = g->ny - 1;
   if (ix <= 0 || ix >= gixmax || iy <= 0 || iy >= giymax) {
     // On geoid model borders
     return Ng;
   }
 
-  if (gid == 1) {
-    x1 = gfimin + ix*gfiinc1; y1 = glamin + iy*glainc15;
-    x2 = x1 + gfiinc1;        y2 = y1 + glainc15;
-
-    p3 = geoid_slo[ix+1][iy]; p4 = geoid_slo[ix+1][iy+1];
-    p1 = geoid_slo[ix][iy];   p2 = geoid_slo[ix][iy+1];
-  }
-  else if (gid == 2) {
-    x1 = gfimin + ix*gfiinc1; y1 = glamin + iy*glainc15;
-    x2 = x1 + gfiinc1;        y2 = y1 + glainc1;
-
-    p3 = geoid_egm[ix+1][iy]; p4 = geoid_egm[ix+1][iy+1];
-    p1 = geoid_egm[ix][iy];   p2 = geoid_egm[ix][iy+1];
-  }
-  else {
-    x1 = gfimin + ix*gfiinc1; y1 = glamin + iy*glainc15;
-    x2 = x1 + gfiinc1;        y2 = y1 + glainc15;
-
-    p3 = geoid_bes[ix+1][iy]; p4 = geoid_bes[ix+1][iy+1];
-    p1 = geoid_bes[ix][iy];   p2 = geoid_bes[ix][iy+1];
-  }
-  if (p1 == 0.0) {
+  x1 = g->fimin + ix*g->dfi; y1 = g->lamin + iy*g->dla0;
+  x2 = x1 + g->dfi;          y2 = y1 + g->dla;
+  // Tile rows and columns of nodes (iy+1 can be in next tile)
+  r1 = GEOID_ROW(g, ix, iy); r3 = GEOID_ROW(g, ix+1, iy);
+  c1 = (unsigned)iy%GEO_TILE; c2 = (c1 + 1)%GEO_TILE;
+  r2 = (c2 == 0) ? GEO_TILE : 0;
+  if (!GEOID_VALID(g, r1, c1)) {
     // No data in geoid model (outside Slovenia for slo2000)
     return Ng;
   }
 
   // Add missing values on Slovenia borders for slo2000
-  if (p3 == 0.0) p3 = p1; if (p4 == 0.0) p4 = p1;
-  /* p1 = base value */   if (p2 == 0.0) p2 = p1;
+  p1 = GEOID_VAL(g, r1, c1);
+  p2 = GEOID_VALID(g, r1+r2, c2) ? GEOID_VAL(g, r1+r2, c2) : p1;
+  p3 = GEOID_VALID(g, r3, c1) ? GEOID_VAL(g, r3, c1) : p1;
+  p4 = GEOID_VALID(g, r3+r2, c2) ? GEOID_VAL(g, r3+r2, c2) : p1;
 
   // Bilinear interpolation (from Wiki)
   R1 = (y2 - y)/(y2 - y1)*p1 + (y - y1)/(y2 - y1)*p2;
@@ -578,6 +972,42 @@ double geoid_height(double fi, double la, int gid)
 } /* geoid_height */
 
 
+// ----------------------------------------------------------------------------
+// geoid_cell_coef
+// ----------------------------------------------------------------------------
+// Bilinear interpolation of geoid model g in cell ix,iy (nodes ix..ix+1,
+// iy..iy+1) as Ng = cf[0] + cf[1]*u + cf[2]*v + cf[3]*u*v, where u = xi-ix
+// and v = yi-iy are position in cell (xi, yi as in geoid_height), so that
+// geoid_height_vec() needs no divisions or tests per point. Cells where
+// geoid_height() returns 0 (model borders, no data) get all coefficients 0.
+// Called by vector kernels only when points move to another cell.
+// ----------------------------------------------------------------------------
+void geoid_cell_coef(const GEO_GEOID *g, int ix, int iy, double *cf)
+{
+  double p1, p2, p3, p4, s;
+  unsigned r1, r2, r3, c1, c2;
+
+  cf[0] = cf[1] = cf[2] = cf[3] = 0.0;
+  if (ix < 1 || ix >= g->nx - 1 || iy < 1 || iy >= g->ny - 1) return;
+
+  r1 = GEOID_ROW(g, ix, iy); r3 = GEOID_ROW(g, ix+1, iy);
+  c1 = (unsigned)iy%GEO_TILE; c2 = (c1 + 1)%GEO_TILE;
+  r2 = (c2 == 0) ? GEO_TILE : 0;
+  if (!GEOID_VALID(g, r1, c1)) return;
+  p1 = GEOID_VAL(g, r1, c1);
+  p2 = GEOID_VALID(g, r1+r2, c2) ? GEOID_VAL(g, r1+r2, c2) : p1;
+  p3 = GEOID_VALID(g, r3, c1) ? GEOID_VAL(g, r3, c1) : p1;
+  p4 = GEOID_VALID(g, r3+r2, c2) ? GEOID_VAL(g, r3+r2, c2) : p1;
+
+  // Cell origins are iy*dla0 apart, so v in cell is really v - s
+  s = iy*(g->dla0/g->dla - 1.0);
+  cf[2] = p2 - p1;
+  cf[3] = p1 - p2 - p3 + p4;
+  cf[0] = p1 - cf[2]*s;
+  cf[1] = p3 - p1 - cf[3]*s;
+} /* geoid_cell_coef */
+
+
 // ----------------------------------------------------------------------------
 // point_in_bounding_box
 // ----------------------------------------------------------------------------
@@ -671,30 +1101,343 @@ int coord_in_triangle(GEOUTM in, AFT aft)
 
 
 // ----------------------------------------------------------------------------
-// xy2fila_ellips (height calculated from geoid)
+// aft_order
+// Triangle checked as ii-th by linear search (from the middle of the table
+// in both directions: MAXAFT/2, MAXAFT/2-1, MAXAFT/2+1, ...)
 // ----------------------------------------------------------------------------
-// Transform from GK/TM x,y,H coordinates to fi,la,h on specified ellipsoid
+static int aft_order(int ii)
+{
+  return (ii & 1) ? MAXAFT/2 - 1 - ii/2 : MAXAFT/2 + ii/2;
+} /* aft_order */
+
+
+// ----------------------------------------------------------------------------
+// aft_cells
+// Range of grid cells cx1..cx2, cy1..cy2 overlapped by bounding box of
+// triangle (enlarged by EPSILON as in point_in_bounding_box)
+// ----------------------------------------------------------------------------
+static void aft_cells(const AFT_INDEX *idx, const AFT *t, int *cx1, int *cy1,
+                      int *cx2, int *cy2)
+{
+  double xMin, xMax, yMin, yMax;
+
+  xMin = xfmin(t->src[0].x, xfmin(t->src[1].x, t->src[2].x)) - EPSILON;
+  xMax = xfmax(t->src[0].x, xfmax(t->src[1].x, t->src[2].x)) + EPSILON;
+  yMin = xfmin(t->src[0].y, xfmin(t->src[1].y, t->src[2].y)) - EPSILON;
+  yMax = xfmax(t->src[0].y, xfmax(t->src[1].y, t->src[2].y)) + EPSILON;
+  *cx1 = (int)floor((xMin - idx->xmin)/AFT_CELL);
+  *cx2 = (int)floor((xMax - idx->xmin)/AFT_CELL);
+  *cy1 = (int)floor((yMin - idx->ymin)/AFT_CELL);
+  *cy2 = (int)floor((yMax - idx->ymin)/AFT_CELL);
+  if (*cx2 >= idx->nx) *cx2 = idx->nx - 1;
+  if (*cy2 >= idx->ny) *cy2 = idx->ny - 1;
+} /* aft_cells */
+
+
+// ----------------------------------------------------------------------------
+// aft_index_init
+// ----------------------------------------------------------------------------
+// Build uniform grid index idx of MAXAFT triangles in table aft (cells of
+// AFT_CELL m over bounding box of all triangles).
+// Returns 0 if OK or -1 if there's no memory (linear search is used then).
+// ----------------------------------------------------------------------------
+static int aft_index_init(AFT_INDEX *idx, const AFT *aft)
+{
+  double xmax, ymax;
+  int ii, jj, kk, cx, cy, cx1, cy1, cx2, cy2, ncells;
+
+  memset(idx, 0, sizeof(AFT_INDEX));
+  idx->xmin = 1e30; idx->ymin = 1e30; xmax = -1e30; ymax = -1e30;
+  for (ii = 0; ii < MAXAFT; ii++)
+    for (jj = 0; jj < 3; jj++) {
+      idx->xmin = xfmin(idx->xmin, aft[ii].src[jj].x);
+      idx->ymin = xfmin(idx->ymin, aft[ii].src[jj].y);
+      xmax = xfmax(xmax, aft[ii].src[jj].x);
+      ymax = xfmax(ymax, aft[ii].src[jj].y);
+    }
+  idx->xmin -= EPSILON; idx->ymin -= EPSILON;
+  idx->nx = (int)((xmax + EPSILON - idx->xmin)/AFT_CELL) + 1;
+  idx->ny = (int)((ymax + EPSILON - idx->ymin)/AFT_CELL) + 1;
+  ncells = idx->nx*idx->ny;
+
+  idx->first = (int *)calloc(ncells + 1, sizeof(int));
+  if (idx->first == NULL) return -1;
+
+  // Count triangles per cell, then fill lists in order of linear search
+  for (ii = 0; ii < MAXAFT; ii++) {
+    aft_cells(idx, &aft[ii], &cx1, &cy1, &cx2, &cy2);
+    for (cx = cx1; cx <= cx2; cx++)
+      for (cy = cy1; cy <= cy2; cy++) idx->first[cx*idx->ny + cy + 1]++;
+  }
+  for (kk = 0; kk < ncells; kk++) idx->first[kk+1] += idx->first[kk];
+  idx->tri = (short *)malloc(idx->first[ncells]*sizeof(short));
+  if (idx->tri == NULL) {
+    free(idx->first); idx->first = NULL;
+    return -1;
+  }
+  for (jj = 0; jj < MAXAFT; jj++) {
+    ii = aft_order(jj);
+    aft_cells(idx, &aft[ii], &cx1, &cy1, &cx2, &cy2);
+    for (cx = cx1; cx <= cx2; cx++)
+      for (cy = cy1; cy <= cy2; cy++) {
+        kk = cx*idx->ny + cy;
+        idx->tri[idx->first[kk]++] = (short)ii;
+      }
+  }
+  for (kk = ncells; kk > 0; kk--) idx->first[kk] = idx->first[kk-1]; // restore
+  idx->first[0] = 0;
+  return 0;
+} /* aft_index_init */
+
+
+// ----------------------------------------------------------------------------
+// aft_find
+// ----------------------------------------------------------------------------
+// Find triangle of table aft (with index idx) containing point in: only
+// triangles listed in its grid cell are checked (all triangles in order of
+// linear search if there's no index).
+// Returns triangle or -1 if point is outside of all triangles.
+// ----------------------------------------------------------------------------
+static int aft_find(const AFT_INDEX *idx, const AFT *aft, GEOUTM in)
+{
+  double dx, dy;
+  int ii, kk, cx, cy;
+
+  if (idx->tri == NULL) {
+    for (ii = 0; ii < MAXAFT; ii++)
+      if (coord_in_triangle(in, aft[aft_order(ii)])) return aft_order(ii);
+    return -1;
+  }
+
+  dx = (in.x - idx->xmin)/AFT_CELL; dy = (in.y - idx->ymin)/AFT_CELL;
+  if (!(dx >= 0.0 && dx < idx->nx && dy >= 0.0 && dy < idx->ny))
+    return -1; // outside of all triangles (or NaN)
+  cx = (int)dx; cy = (int)dy;
+  kk = cx*idx->ny + cy;
+  for (ii = idx->first[kk]; ii < idx->first[kk+1]; ii++)
+    if (coord_in_triangle(in, aft[idx->tri[ii]])) return idx->tri[ii];
+  return -1;
+} /* aft_find */
+
+
+// ----------------------------------------------------------------------------
+// arc_length
+// ----------------------------------------------------------------------------
+// Meridian arc length from equator to fi (in radians) on specified ellipsoid
+// using Clenshaw summation of sin(2k*fi) series (only one sin/cos pair)
 // ----------------------------------------------------------------------------
 // Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
-void xy2fila_ellips(GEOUTM in, GEOGRA *out, int oid)
+double arc_length(double fi, int oid)
+{
+  double sin2Fi, cos2Fi, b1, b2, b3;
+  int k;
+
+  sin2Fi = sin(2.0*fi);
+  cos2Fi = cos(2.0*fi);
+
+  // b(k) = arc[k] + 2*cos(2fi)*b(k+1) - b(k+2), sum = b(1)*sin(2fi)
+  b1 = 0.0; b2 = 0.0;
+  for (k = 5; k >= 1; k--) {
+    b3 = b2; b2 = b1;
+    b1 = ellipsoid.arc[k] + 2.0*cos2Fi*b2 - b3;
+  }
+  return ellipsoid.arc[0]*fi + b1*sin2Fi;
+} /* arc_length */
+
+
+// ----------------------------------------------------------------------------
+// arc_length_sum
+// ----------------------------------------------------------------------------
+// Meridian arc length from equator to fi (in radians) on specified ellipsoid
+// summed term by term with L1 (alg = 1) or L2 (alg = 2) series, as used by
+// xy2fila_ellips() and fila_ellips2xy() without L4 (for comparison)
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+double arc_length_sum(double fi, int oid, int alg)
+{
+  if (alg == 1)
+    return ellipsoid.c*(ellipsoid.A*fi + ellipsoid.B/2.0*sin(2.0*fi)
+      + ellipsoid.C/4.0*sin(4.0*fi) + ellipsoid.D/6.0*sin(6.0*fi)
+      + ellipsoid.E/8.0*sin(8.0*fi) + ellipsoid.F/10.0*sin(10.0*fi));
+  else
+    return ellipsoid.M*(ellipsoid.A*fi - ellipsoid.B/2.0*sin(2.0*fi)
+      + ellipsoid.C/4.0*sin(4.0*fi) - ellipsoid.D/6.0*sin(6.0*fi)
+      + ellipsoid.E/8.0*sin(8.0*fi) - ellipsoid.F/10.0*sin(10.0*fi));
+} /* arc_length_sum */
+
+
+// ----------------------------------------------------------------------------
+// krueger_sum
+// ----------------------------------------------------------------------------
+// Sum of c[j]*sin(2j*(xi + i*eta)), j = 1..6, with complex Clenshaw recurrence
+// ----------------------------------------------------------------------------
+void krueger_sum(const double *c, double xi, double eta, double *sxi, double *seta)
+{
+  double s2, c2, sh2, ch2, ar, ai, br, bi, b2r, b2i, b3r, b3i;
+  int k;
+
+  s2 = sin(2.0*xi); c2 = cos(2.0*xi);
+  sh2 = sinh(2.0*eta); ch2 = cosh(2.0*eta);
+
+  // a = 2*cos(2*zeta), b(k) = c[k] + a*b(k+1) - b(k+2)
+  ar = 2.0*c2*ch2; ai = -2.0*s2*sh2;
+  br = 0.0; bi = 0.0; b2r = 0.0; b2i = 0.0;
+  for (k = 6; k >= 1; k--) {
+    b3r = b2r; b3i = b2i; b2r = br; b2i = bi;
+    br = c[k] + ar*b2r - ai*b2i - b3r;
+    bi = ar*b2i + ai*b2r - b3i;
+  }
+
+  // sum = b(1)*sin(2*zeta)
+  *sxi = br*s2*ch2 - bi*c2*sh2;
+  *seta = br*c2*sh2 + bi*s2*ch2;
+} /* krueger_sum */
+
+
+// ----------------------------------------------------------------------------
+// fila2xy_krueger_rad, fila2xy_krueger_rad_proj (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform from fi,la (in radians) to GK/TM x,y coordinates on specified
+// ellipsoid using Krueger n-series (6th order)
+// (for Slovenia or with projection constants pj, e.g. GK zone from gkproj[])
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void fila2xy_krueger_rad_proj(const PROJ *pj, double fi, double la, double *x, double *y, int oid)
+{
+  double dl, tau, sig, taup, xip, etap, dxi, deta;
+
+  dl = la - pj->lambda0;
+
+  // Conformal latitude (as tangent)
+  tau = tan(fi);
+  sig = sinh(ellipsoid.ke*atanh(ellipsoid.ke*tau/sqrt(1.0 + tau*tau)));
+  taup = tau*sqrt(1.0 + sig*sig) - sig*sqrt(1.0 + tau*tau);
+
+  // Gauss-Schreiber TM, then Krueger series
+  xip = atan2(taup, cos(dl));
+  etap = asinh(sin(dl)/sqrt(taup*taup + cos(dl)*cos(dl)));
+  krueger_sum(ellipsoid.kalp, xip, etap, &dxi, &deta);
+
+  // Convert from real to relative coordinates
+  *x = ellipsoid.kA*(xip + dxi)*pj->scale + pj->false_northing;
+  *y = ellipsoid.kA*(etap + deta)*pj->scale + pj->false_easting;
+} /* fila2xy_krueger_rad_proj */
+
+void fila2xy_krueger_rad(double fi, double la, double *x, double *y, int oid)
+{
+  fila2xy_krueger_rad_proj(&tm, fi, la, x, y, oid);
+} /* fila2xy_krueger_rad */
+
+
+// ----------------------------------------------------------------------------
+// fila2xy_krueger, fila2xy_krueger_proj (heights not calculated)
+// ----------------------------------------------------------------------------
+// Same as fila2xy_krueger_rad, but with fi,la in degrees
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void fila2xy_krueger_proj(const PROJ *pj, double fi, double la, double *x, double *y, int oid)
+{
+  fila2xy_krueger_rad_proj(pj, fi*PI/180.0, la*PI/180.0, x, y, oid);
+} /* fila2xy_krueger_proj */
+
+void fila2xy_krueger(double fi, double la, double *x, double *y, int oid)
+{
+  fila2xy_krueger_rad_proj(&tm, fi*PI/180.0, la*PI/180.0, x, y, oid);
+} /* fila2xy_krueger */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_krueger_rad, xy2fila_krueger_rad_proj (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform from GK/TM x,y to fi,la (in radians) coordinates on specified
+// ellipsoid using Krueger n-series (6th order)
+// (for Slovenia or with projection constants pj, e.g. GK zone from gkproj[])
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void xy2fila_krueger_rad_proj(const PROJ *pj, double x, double y, double *fi, double *la, int oid)
+{
+  double xi, eta, dxi, deta, xip, etap, taup, tau, sig, tau1, dif, e2m;
+  int n;
+
+  // Convert from relative to real coordinates
+  xi = (x - pj->false_northing)/pj->scale/ellipsoid.kA;
+  eta = (y - pj->false_easting)/pj->scale/ellipsoid.kA;
+
+  krueger_sum(ellipsoid.kbet, xi, eta, &dxi, &deta);
+  xip = xi - dxi; etap = eta - deta;
+  taup = sin(xip)/sqrt(sinh(etap)*sinh(etap) + cos(xip)*cos(xip));
+  *la = pj->lambda0 + atan2(sinh(etap), cos(xip));
+
+  // Latitude from conformal latitude (Newton's method)
+  e2m = 1.0 - ellipsoid.e2;
+  tau = taup/e2m; // first estimate
+  dif = 1.0; n = 5;
+  while (fabs(dif) >= 1e-15 && n > 0) {
+    sig = sinh(ellipsoid.ke*atanh(ellipsoid.ke*tau/sqrt(1.0 + tau*tau)));
+    tau1 = tau*sqrt(1.0 + sig*sig) - sig*sqrt(1.0 + tau*tau);
+    dif = (taup - tau1)/sqrt(1.0 + tau1*tau1)*(1.0 + e2m*tau*tau)
+      /(e2m*sqrt(1.0 + tau*tau));
+    tau += dif;
+    dif = dif/sqrt(1.0 + tau*tau);
+    n--;
+  }
+  *fi = atan(tau);
+} /* xy2fila_krueger_rad_proj */
+
+void xy2fila_krueger_rad(double x, double y, double *fi, double *la, int oid)
+{
+  xy2fila_krueger_rad_proj(&tm, x, y, fi, la, oid);
+} /* xy2fila_krueger_rad */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_krueger, xy2fila_krueger_proj (heights not calculated)
+// ----------------------------------------------------------------------------
+// Same as xy2fila_krueger_rad, but with fi,la in degrees
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void xy2fila_krueger_proj(const PROJ *pj, double x, double y, double *fi, double *la, int oid)
+{
+  xy2fila_krueger_rad_proj(pj, x, y, fi, la, oid);
+  *fi = *fi*180.0/PI;
+  *la = *la*180.0/PI;
+} /* xy2fila_krueger_proj */
+
+void xy2fila_krueger(double x, double y, double *fi, double *la, int oid)
+{
+  xy2fila_krueger_proj(&tm, x, y, fi, la, oid);
+} /* xy2fila_krueger */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_rad, xy2fila_rad_proj (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform from GK/TM x,y coordinates to fi,la (in radians) on specified
+// ellipsoid using tan-power series
+// (for Slovenia or with projection constants pj, e.g. GK zone from gkproj[])
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void xy2fila_rad_proj(const PROJ *pj, double x, double y, double *fi, double *la, int oid)
 {
   double ab, fi0, dif, L; int n;
   double sinFi0, sin2Fi0;
   double cosFi0, cos2Fi0;
   double tanFi0, tan2Fi0, tan4Fi0, tan6Fi0;
-  double N, ni2, ni4, Ng;
+  double N, ni2, ni4, v;
 
   // Convert from relative to real coordinates
-  in.x = (in.x - tm.false_northing)/tm.scale;
-  in.y = (in.y - tm.false_easting)/tm.scale;
+  x = (x - pj->false_northing)/pj->scale;
+  y = (y - pj->false_easting)/pj->scale;
 
   // Calculate fi0 - footpoint latitude
   // See "Geometrical Geodesy (Hooijberg, 2008), pg. 165(pdf: 183)"
   ab = ellipsoid.a + ellipsoid.b;
-  fi0 = 2.0*in.x/ab; // first estimate
+  fi0 = 2.0*x/ab; // first estimate
   dif = 1.0; n = 15;
   while (fabs(dif) >= 1e-18 && n > 0) {
-#ifdef L1
+#ifdef L4
+    L = arc_length(fi0, oid);
+#elif defined(L1)
     L = ellipsoid.c*(ellipsoid.A*fi0 + ellipsoid.B/2.0*sin(2.0*fi0)
       + ellipsoid.C/4.0*sin(4.0*fi0) + ellipsoid.D/6.0*sin(6.0*fi0)
       + ellipsoid.E/8.0*sin(8.0*fi0) + ellipsoid.F/10.0*sin(10.0*fi0));
@@ -703,7 +1446,7 @@ void xy2fila_ellips(GEOUTM in, GEOGRA *out, int oid)
       + ellipsoid.C/4.0*sin(4.0*fi0) - ellipsoid.D/6.0*sin(6.0*fi0)
       + ellipsoid.E/8.0*sin(8.0*fi0) - ellipsoid.F/10.0*sin(10.0*fi0));
 #endif
-    dif = 2.0*(in.x - L)/ab;
+    dif = 2.0*(x - L)/ab;
     fi0 += dif;
     n--;
   }
@@ -712,58 +1455,80 @@ void xy2fila_ellips(GEOUTM in, GEOGRA *out, int oid)
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 22-23"
   double fiq;
 
-  fiq = in.x/ellipsoid.alfa;
+  fiq = x/ellipsoid.alfa;
   fi0 = fiq + ellipsoid.beta*sin(2.0*fiq) + ellipsoid.gama*sin(4.0*fiq)
     + ellipsoid.delta*sin(6.0*fiq) + ellipsoid.epsilon*sin(8.0*fiq);
 #endif
 
   sinFi0 = sin(fi0);
-  sin2Fi0 = pow(sinFi0,2);
   cosFi0 = cos(fi0);
+#ifdef PS1
+  sin2Fi0 = sinFi0*sinFi0;
+  cos2Fi0 = cosFi0*cosFi0;
+  tanFi0 = sinFi0/cosFi0;
+  tan2Fi0 = tanFi0*tanFi0; tan4Fi0 = tan2Fi0*tan2Fi0; tan6Fi0 = tan4Fi0*tan2Fi0;
+#else //PS2
+  sin2Fi0 = pow(sinFi0,2);
   cos2Fi0 = pow(cosFi0,2);
   tanFi0 = tan(fi0);
   tan2Fi0 = pow(tanFi0,2); tan4Fi0 = pow(tanFi0,4); tan6Fi0 = pow(tanFi0,6);
+#endif
 
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 22"
   N = ellipsoid.c/sqrt(1.0 + ellipsoid.e2_*cos2Fi0);
 //N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*sin2Fi0); // alternative (from java)
 //t = tanFi0;
   ni2 = ellipsoid.e2_*cos2Fi0;
-  ni4 = pow(ni2,2);
-
+  ni4 = ni2*ni2;
+
+#ifdef PS1
+  // Same series as below in Horner form, v = (y/N)^2
+  v = y/N; v = v*v;
+  *fi = fi0 + tanFi0*v*(-(1.0 + ni2)/2.0
+    + v*((5.0 + 3.0*tan2Fi0 + 6.0*ni2 - 6.0*tan2Fi0*ni2 - 3.0*ni4
+          - 9.0*tan2Fi0*ni4)/24.0
+    + v*((-61.0 - 90.0*tan2Fi0 - 45.0*tan4Fi0 - 107.0*ni2 + 162.0*tan2Fi0*ni2
+          + 45.0*tan4Fi0*ni2)/720.0
+    + v*(1385.0 + 3633.0*tan2Fi0 + 4095.0*tan4Fi0 + 1575.0*tan6Fi0)/40320.0)));
+
+  *la = pj->lambda0 + y/(N*cosFi0)*(1.0
+    + v*((-1.0 - 2.0*tan2Fi0 - ni2)/6.0
+    + v*((5.0 + 28.0*tan2Fi0 + 24.0*tan4Fi0 + 8.0*tan2Fi0*ni2 + 6.0*ni2)/120.0
+    + v*(-61.0 - 662.0*tan2Fi0 - 1320.0*tan4Fi0 - 720.0*tan6Fi0)/5040.0)));
+#else //PS2
 #if 1
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 41"
   // See "Bundeseinheitliche Transformation fr ATKIS (BeTA2007), pg. 28"
-  out->fi = fi0
-    + tanFi0/(2.0*pow(N,2))*(-1.0 - ni2)*pow(in.y,2)
+  *fi = fi0
+    + tanFi0/(2.0*pow(N,2))*(-1.0 - ni2)*pow(y,2)
     + tanFi0/(24.0*pow(N,4))*(5.0 + 3.0*tan2Fi0 + 6.0*ni2 - 6.0*tan2Fi0*ni2
-        - 3.0*ni4 - 9.0*tan2Fi0*ni4)*pow(in.y,4)
+        - 3.0*ni4 - 9.0*tan2Fi0*ni4)*pow(y,4)
     + tanFi0/(720.0*pow(N,6))*(-61.0 - 90.0*tan2Fi0 - 45.0*tan4Fi0 - 107.0*ni2
-        + 162.0*tan2Fi0*ni2 + 45.0*tan4Fi0*ni2)*pow(in.y,6)
+        + 162.0*tan2Fi0*ni2 + 45.0*tan4Fi0*ni2)*pow(y,6)
     + tanFi0/(40320.0*pow(N,8))*(1385.0 + 3633.0*tan2Fi0 + 4095.0*tan4Fi0
-        + 1575.0*tan6Fi0)*pow(in.y,8);
+        + 1575.0*tan6Fi0)*pow(y,8);
 #else // really identical
   // See "Stara in nova drzavna kartografska projekcija (2008), pg. 8)"
   // See "Digitalni model reliefa (Podobnikar, 2001), pg. 109(pdf: 114)"
-  out->fi = fi0
-    - tanFi0/(2.0*pow(N,2))*(1.0 + ni2)*pow(in.y,2)
+  *fi = fi0
+    - tanFi0/(2.0*pow(N,2))*(1.0 + ni2)*pow(y,2)
     + tanFi0/(24.0*pow(N,4))*(5.0 + 3.0*tan2Fi0 + 6.0*ni2 - 6.0*tan2Fi0*ni2
-        - 3.0*ni4 - 9.0*tan2Fi0*ni4)*pow(in.y,4)
+        - 3.0*ni4 - 9.0*tan2Fi0*ni4)*pow(y,4)
     - tanFi0/(720.0*pow(N,6))*(61.0 + 90.0*tan2Fi0 + 45.0*tan4Fi0 + 107.0*ni2
-        - 162.0*tan2Fi0*ni2 - 45.0*tan4Fi0*ni2)*pow(in.y,6)
+        - 162.0*tan2Fi0*ni2 - 45.0*tan4Fi0*ni2)*pow(y,6)
     + tanFi0/(40320.0*pow(N,8))*(1385.0 + 3633.0*tan2Fi0 + 4095.0*tan4Fi0
-        + 1575.0*tan6Fi0)*pow(in.y,8);
+        + 1575.0*tan6Fi0)*pow(y,8);
 #endif
 
 #if 0 //xxx
 #ifdef L1
-  L = ellipsoid.c*(ellipsoid.A*out->fi + ellipsoid.B/2.0*sin(2.0*out->fi)
-    + ellipsoid.C/4.0*sin(4.0*out->fi) + ellipsoid.D/6.0*sin(6.0*out->fi)
-    + ellipsoid.E/8.0*sin(8.0*out->fi) + ellipsoid.F/10.0*sin(10.0*out->fi));
+  L = ellipsoid.c*(ellipsoid.A*(*fi) + ellipsoid.B/2.0*sin(2.0*(*fi))
+    + ellipsoid.C/4.0*sin(4.0*(*fi)) + ellipsoid.D/6.0*sin(6.0*(*fi))
+    + ellipsoid.E/8.0*sin(8.0*(*fi)) + ellipsoid.F/10.0*sin(10.0*(*fi)));
 #else //L2
-  L = ellipsoid.M*(ellipsoid.A*out->fi - ellipsoid.B/2.0*sin(2.0*out->fi)
-    + ellipsoid.C/4.0*sin(4.0*out->fi) - ellipsoid.D/6.0*sin(6.0*out->fi)
-    + ellipsoid.E/8.0*sin(8.0*out->fi) - ellipsoid.F/10.0*sin(10.0*out->fi));
+  L = ellipsoid.M*(ellipsoid.A*(*fi) - ellipsoid.B/2.0*sin(2.0*(*fi))
+    + ellipsoid.C/4.0*sin(4.0*(*fi)) - ellipsoid.D/6.0*sin(6.0*(*fi))
+    + ellipsoid.E/8.0*sin(8.0*(*fi)) - ellipsoid.F/10.0*sin(10.0*(*fi)));
 #endif
   printf(">> L: %.10f\n", L);
 #endif
@@ -771,98 +1536,232 @@ void xy2fila_ellips(GEOUTM in, GEOGRA *out, int oid)
 #if 1
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 41"
   // See "Bundeseinheitliche Transformation fr ATKIS (BeTA2007), pg. 28"
-  out->la = tm.lambda0
-    + 1.0/(N*cosFi0)*in.y
-    + 1.0/(6.0*pow(N,3)*cosFi0)*(-1.0 - 2.0*tan2Fi0 - ni2)*pow(in.y,3)
+  *la = pj->lambda0
+    + 1.0/(N*cosFi0)*y
+    + 1.0/(6.0*pow(N,3)*cosFi0)*(-1.0 - 2.0*tan2Fi0 - ni2)*pow(y,3)
     + 1.0/(120.0*pow(N,5)*cosFi0)*(5.0 + 28.0*tan2Fi0 + 24.0*tan4Fi0
-        + 8.0*tan2Fi0*ni2 + 6.0*ni2)*pow(in.y,5)
+        + 8.0*tan2Fi0*ni2 + 6.0*ni2)*pow(y,5)
     + 1.0/(5040.0*pow(N,7)*cosFi0)*(-61.0 - 662.0*tan2Fi0 - 1320.0*tan4Fi0
-        - 720.0*tan6Fi0)*pow(in.y,7);
+        - 720.0*tan6Fi0)*pow(y,7);
 #else // really identical
   // See "Stara in nova drzavna kartografska projekcija (2008), pg. 8)"
   // See "Digitalni model reliefa (Podobnikar, 2001), pg. 109(pdf: 114)"
-  out->la = tm.lambda0
-    + 1.0/(N*cosFi0)*in.y
-    - 1.0/(6.0*pow(N,3)*cosFi0)*(1.0 + 2.0*tan2Fi0 + ni2)*pow(in.y,3)
+  *la = pj->lambda0
+    + 1.0/(N*cosFi0)*y
+    - 1.0/(6.0*pow(N,3)*cosFi0)*(1.0 + 2.0*tan2Fi0 + ni2)*pow(y,3)
     + 1.0/(120.0*pow(N,5)*cosFi0)*(5.0 + 28.0*tan2Fi0 + 24.0*tan4Fi0 + 6.0*ni2
-        + 8.0*tan2Fi0*ni2)*pow(in.y,5)
+        + 8.0*tan2Fi0*ni2)*pow(y,5)
     - 1.0/(5040.0*pow(N,7)*cosFi0)*(61.0 + 662.0*tan2Fi0 + 1320.0*tan4Fi0
-        + 720.0*tan6Fi0)*pow(in.y,7);
+        + 720.0*tan6Fi0)*pow(y,7);
 #endif
+#endif //PS2
+} /* xy2fila_rad_proj */
 
-  // Convert from radians to degrees
-  out->fi = out->fi*180.0/PI;
-  out->la = out->la*180.0/PI;
+void xy2fila_rad(double x, double y, double *fi, double *la, int oid)
+{
+  xy2fila_rad_proj(&tm, x, y, fi, la, oid);
+} /* xy2fila_rad */
 
-  if (oid == 1 || oid == 2) //wgs84/etrs89
-    Ng = geoid_height(out->fi, out->la, gid_wgs); //slo2000/egm2008
-  else //bessel
-    Ng = geoid_height(out->fi, out->la, 0); //bessel
-  out->Ng = Ng;
 
-  // Geoid height
-  out->h = in.H + Ng;
-} /* xy2fila_ellips */
+// ----------------------------------------------------------------------------
+// proj_xy2fila, proj_fila2xy (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform between GK/TM x,y and fi,la (in radians) on specified ellipsoid
+// using selected TM projection series tms (0: tan-power, 1: Krueger n-series)
+// ----------------------------------------------------------------------------
+static void proj_xy2fila(int tms, double x, double y, double *fi, double *la, int oid)
+{
+  if (tms == 1) // Krueger n-series
+    xy2fila_krueger_rad(x, y, fi, la, oid);
+  else xy2fila_rad(x, y, fi, la, oid);
+} /* proj_xy2fila */
+
+static void proj_fila2xy(int tms, double fi, double la, double *x, double *y, int oid)
+{
+  if (tms == 1) // Krueger n-series
+    fila2xy_krueger_rad(fi, la, x, y, oid);
+  else fila2xy_rad(fi, la, x, y, oid);
+} /* proj_fila2xy */
 
 
 // ----------------------------------------------------------------------------
-// fila_ellips2xy (height calculated from geoid)
+// geo_ctx_init
 // ----------------------------------------------------------------------------
-// Transform from fi,la,h to GK/TM x,y,H coordinates on specified ellipsoid
+// Initialize conversion context from current global settings (gid_wgs, hsel,
+// tmsel, gtol, jtol, csel, nthr and zsel, set via cmd line) and reset last
+// found AFT triangle.
 // ----------------------------------------------------------------------------
-// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
-void fila_ellips2xy(GEOGRA in, GEOUTM *out, int oid)
+void geo_ctx_init(GEO_CTX *ctx)
 {
-  double dl, dl2, dl3, dl4, dl5, dl6, dl7, dl8;
-  double sinFi, sin2Fi;
-  double cosFi, cos2Fi, cos3Fi, cos4Fi, cos5Fi, cos6Fi, cos7Fi, cos8Fi;
-  double tanFi, tan2Fi, tan4Fi, tan6Fi;
-  double N, ni2, ni4, L, Ng;
+  ctx->gid_wgs = gid_wgs;
+  ctx->hsel = hsel;
+  ctx->tmsel = tmsel;
+  ctx->last_tri = -1;
+  ctx->gtol = gtol;
+  ctx->jtol = jtol;
+  ctx->csel = csel;
+  ctx->nthr = nthr;
+  ctx->zsel = zsel;
+} /* geo_ctx_init */
+
+
+// Default context of routines without context (legacy wrappers), initialized
+// from global settings once, at the first call (see geo_ctx_default_update)
+static GEO_CTX defctx;
+static pthread_once_t defctx_once = PTHREAD_ONCE_INIT;
+
+static void defctx_init(void)
+{
+  geo_ctx_init(&defctx);
+} /* defctx_init */
 
-  if (oid == 1 || oid == 2) //wgs84/etrs89
-    Ng = geoid_height(in.fi, in.la, gid_wgs); //slo2000/egm2008
-  else //bessel
-    Ng = geoid_height(in.fi, in.la, 0); //bessel
-  out->Ng = Ng;
 
-  // Convert from degrees to radians
-  in.fi = in.fi*PI/180.0;
-  in.la = in.la*PI/180.0;
+// ----------------------------------------------------------------------------
+// geo_ctx_default
+// ----------------------------------------------------------------------------
+// Returns default context (routines only read it, so it is shared by all
+// threads)
+// ----------------------------------------------------------------------------
+static GEO_CTX *geo_ctx_default(void)
+{
+  pthread_once(&defctx_once, defctx_init);
+  return &defctx;
+} /* geo_ctx_default */
 
-  dl = in.la - tm.lambda0;
-  dl2 = pow(dl,2); dl3 = pow(dl,3); dl4 = pow(dl,4); dl5 = pow(dl,5);
-  dl6 = pow(dl,6); dl7 = pow(dl,7); dl8 = pow(dl,8);
 
-  sinFi = sin(in.fi);
-  sin2Fi = pow(sinFi,2);
-  cosFi = cos(in.fi);
-  cos2Fi = pow(cosFi,2); cos3Fi = pow(cosFi,3); cos4Fi = pow(cosFi,4);
-  cos5Fi = pow(cosFi,5); cos6Fi = pow(cosFi,6); cos7Fi = pow(cosFi,7);
+// ----------------------------------------------------------------------------
+// geo_ctx_default_update
+// ----------------------------------------------------------------------------
+// Copy current global settings to default context. Must be called after
+// global settings are changed once routines without context have been used
+// (not while conversions are running in other threads).
+// ----------------------------------------------------------------------------
+void geo_ctx_default_update(void)
+{
+  pthread_once(&defctx_once, defctx_init);
+  geo_ctx_init(&defctx);
+} /* geo_ctx_default_update */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_ellips_ctx (height calculated from geoid)
+// ----------------------------------------------------------------------------
+// Transform from GK/TM x,y,H coordinates to fi,la,h on specified ellipsoid
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void xy2fila_ellips_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out, int oid)
+{
+  double Ng;
+
+  proj_xy2fila(ctx->tmsel, in.x, in.y, &out->fi, &out->la, oid);
+
+  // Convert from radians to degrees
+  out->fi = out->fi*180.0/PI;
+  out->la = out->la*180.0/PI;
+
+  if (oid == 1 || oid == 2) //wgs84/etrs89
+    Ng = geoid_height(out->fi, out->la, ctx->gid_wgs); //slo2000/egm2008
+  else //bessel
+    Ng = geoid_height(out->fi, out->la, 0); //bessel
+  out->Ng = Ng;
+
+  // Geoid height
+  out->h = in.H + Ng;
+} /* xy2fila_ellips_ctx */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_ellips (height calculated from geoid)
+// ----------------------------------------------------------------------------
+// Transform from GK/TM x,y,H coordinates to fi,la,h on specified ellipsoid
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void xy2fila_ellips(GEOUTM in, GEOGRA *out, int oid)
+{
+  xy2fila_ellips_ctx(geo_ctx_default(), in, out, oid);
+} /* xy2fila_ellips */
+
+
+// ----------------------------------------------------------------------------
+// fila2xy_rad, fila2xy_rad_proj (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform from fi,la (in radians) to GK/TM x,y coordinates on specified
+// ellipsoid using tan-power series
+// (for Slovenia or with projection constants pj, e.g. GK zone from gkproj[])
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void fila2xy_rad_proj(const PROJ *pj, double fi, double la, double *x, double *y, int oid)
+{
+  double dl, dl2;
+  double sinFi, sin2Fi;
+  double cosFi, cos2Fi;
+  double tanFi, tan2Fi, tan4Fi, tan6Fi;
+  double N, ni2, ni4, L;
+#ifdef PS1
+  double u;
+#else //PS2
+  double dl3, dl4, dl5, dl6, dl7, dl8;
+  double cos3Fi, cos4Fi, cos5Fi, cos6Fi, cos7Fi, cos8Fi;
+#endif
+
+  dl = la - pj->lambda0;
+  sinFi = sin(fi);
+  cosFi = cos(fi);
+#ifdef PS1
+  dl2 = dl*dl;
+  sin2Fi = sinFi*sinFi;
+  cos2Fi = cosFi*cosFi;
+  tanFi = sinFi/cosFi;
+  tan2Fi = tanFi*tanFi; tan4Fi = tan2Fi*tan2Fi; tan6Fi = tan4Fi*tan2Fi;
+#else //PS2
+  dl2 = pow(dl,2); dl3 = pow(dl,3); dl4 = pow(dl,4); dl5 = pow(dl,5);
+  dl6 = pow(dl,6); dl7 = pow(dl,7); dl8 = pow(dl,8);
+
+  sin2Fi = pow(sinFi,2);
+  cos2Fi = pow(cosFi,2); cos3Fi = pow(cosFi,3); cos4Fi = pow(cosFi,4);
+  cos5Fi = pow(cosFi,5); cos6Fi = pow(cosFi,6); cos7Fi = pow(cosFi,7);
   cos8Fi = pow(cosFi,8);
-  tanFi = tan(in.fi);
+  tanFi = tan(fi);
   tan2Fi = pow(tanFi,2); tan4Fi = pow(tanFi,4); tan6Fi = pow(tanFi,6);
+#endif
 
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 22"
   N = ellipsoid.c/sqrt(1.0 + ellipsoid.e2_*cos2Fi);
 //N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*sin2Fi); // alternative (from java)
 //t = tanFi;
   ni2 = ellipsoid.e2_*cos2Fi;
-  ni4 = pow(ni2,2);
-
-#ifdef L1
-  L = ellipsoid.c*(ellipsoid.A*in.fi + ellipsoid.B/2.0*sin(2.0*in.fi)
-    + ellipsoid.C/4.0*sin(4.0*in.fi) + ellipsoid.D/6.0*sin(6.0*in.fi)
-    + ellipsoid.E/8.0*sin(8.0*in.fi) + ellipsoid.F/10.0*sin(10.0*in.fi));
+  ni4 = ni2*ni2;
+
+#ifdef L4
+  L = arc_length(fi, oid);
+#elif defined(L1)
+  L = ellipsoid.c*(ellipsoid.A*fi + ellipsoid.B/2.0*sin(2.0*fi)
+    + ellipsoid.C/4.0*sin(4.0*fi) + ellipsoid.D/6.0*sin(6.0*fi)
+    + ellipsoid.E/8.0*sin(8.0*fi) + ellipsoid.F/10.0*sin(10.0*fi));
 #else //L2
-  L = ellipsoid.M*(ellipsoid.A*in.fi - ellipsoid.B/2.0*sin(2.0*in.fi)
-    + ellipsoid.C/4.0*sin(4.0*in.fi) - ellipsoid.D/6.0*sin(6.0*in.fi)
-    + ellipsoid.E/8.0*sin(8.0*in.fi) - ellipsoid.F/10.0*sin(10.0*in.fi));
+  L = ellipsoid.M*(ellipsoid.A*fi - ellipsoid.B/2.0*sin(2.0*fi)
+    + ellipsoid.C/4.0*sin(4.0*fi) - ellipsoid.D/6.0*sin(6.0*fi)
+    + ellipsoid.E/8.0*sin(8.0*fi) - ellipsoid.F/10.0*sin(10.0*fi));
 #endif
 
+#ifdef PS1
+  // Same series as below in Horner form, u = cos^2(fi)*dl^2
+  // (differs from PS2 only by rounding, up to 2 ulp of x or 1.9e-9 m)
+  u = cos2Fi*dl2;
+  *x = L + N*sinFi*cosFi*dl2*(1.0/2.0
+    + u*((5.0 - tan2Fi + 9.0*ni2 + 4.0*ni4)/24.0
+    + u*((61.0 - 58.0*tan2Fi + tan4Fi + 270.0*ni2 - 330.0*tan2Fi*ni2)/720.0
+    + u*(1385.0 - 3111.0*tan2Fi + 543.0*tan4Fi - tan6Fi)/40320.0)));
+
+  *y = N*cosFi*dl*(1.0
+    + u*((1.0 - tan2Fi + ni2)/6.0
+    + u*((5.0 - 18.0*tan2Fi + tan4Fi + 14.0*ni2 - 58.0*tan2Fi*ni2)/120.0
+    + u*(61.0 - 479.0*tan2Fi + 179.0*tan4Fi - tan6Fi)/5040.0)));
+#else //PS2
 #if 1
   // See "Stara in nova drzavna kartografska projekcija (2008), pg. 8)"
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 40"
-  out->x = L
+  *x = L
     + tanFi/2.0*N*cos2Fi*dl2
     + tanFi/24.0*N*cos4Fi*(5.0 - tan2Fi + 9.0*ni2 + 4.0*ni4)*dl4
     + tanFi/720.0*N*cos6Fi*(61.0 - 58.0*tan2Fi + tan4Fi + 270.0*ni2
@@ -871,7 +1770,7 @@ void fila_ellips2xy(GEOGRA in, GEOUTM *out, int oid)
         - tan6Fi)*dl8;
 #else // identical
   // See "Digitalni model reliefa (Podobnikar, 2001), pg. 110(pdf: 115)"
-  out->x = L
+  *x = L
     + 1.0/2.0*N*sinFi*cosFi*dl2
     + 1.0/24.0*N*sinFi*cos3Fi*(5.0 - tan2Fi + 9.0*ni2 + 4.0*ni4)*dl4
     + 1.0/720.0*N*sinFi*cos5Fi*(61.0 - 58.0*tan2Fi + tan4Fi)*dl6
@@ -882,84 +1781,131 @@ void fila_ellips2xy(GEOGRA in, GEOUTM *out, int oid)
 #if 1
   // See "Stara in nova drzavna kartografska projekcija (2008), pg. 8)"
   // See "Predavanje Geodezija (Univ. Zagreb, 2007), pg. 40"
-  out->y = N*cosFi*dl
+  *y = N*cosFi*dl
     + 1.0/6.0*N*cos3Fi*(1.0 - tan2Fi + ni2)*dl3
     + 1.0/120.0*N*cos5Fi*(5.0 - 18.0*tan2Fi + tan4Fi + 14.0*ni2
         - 58.0*tan2Fi*ni2)*dl5
     + 1.0/5040.0*N*cos7Fi*(61.0 - 479.0*tan2Fi + 179.0*tan4Fi - tan6Fi)*dl7;
 #else // really identical
   // See "Digitalni model reliefa (Podobnikar, 2001), pg. 110(pdf: 115)"
-  out->y = N*cosFi*dl
+  *y = N*cosFi*dl
     + 1.0/6.0*N*cos3Fi*(1.0 - tan2Fi + ni2)*dl3
     + 1.0/120.0*N*cos5Fi*(5.0 - 18.0*tan2Fi + tan4Fi + 14.0*ni2
         - 58.0*tan2Fi*ni2)*dl5
     + 1.0/5040.0*N*cos7Fi*(61.0 - 479.0*tan2Fi + 179.0*tan4Fi - tan6Fi)*dl7;
 #endif
+#endif //PS2
 
   // Convert from real to relative coordinates
-  out->x = out->x*tm.scale + tm.false_northing;
-  out->y = out->y*tm.scale + tm.false_easting;
+  *x = (*x)*pj->scale + pj->false_northing;
+  *y = (*y)*pj->scale + pj->false_easting;
+} /* fila2xy_rad_proj */
+
+void fila2xy_rad(double fi, double la, double *x, double *y, int oid)
+{
+  fila2xy_rad_proj(&tm, fi, la, x, y, oid);
+} /* fila2xy_rad */
+
+
+// ----------------------------------------------------------------------------
+// fila_ellips2xy_ctx (height calculated from geoid)
+// ----------------------------------------------------------------------------
+// Transform from fi,la,h to GK/TM x,y,H coordinates on specified ellipsoid
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void fila_ellips2xy_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out, int oid)
+{
+  double Ng;
+
+  if (oid == 1 || oid == 2) //wgs84/etrs89
+    Ng = geoid_height(in.fi, in.la, ctx->gid_wgs); //slo2000/egm2008
+  else //bessel
+    Ng = geoid_height(in.fi, in.la, 0); //bessel
+  out->Ng = Ng;
+
+  // Convert from degrees to radians
+  proj_fila2xy(ctx->tmsel, in.fi*PI/180.0, in.la*PI/180.0, &out->x, &out->y, oid);
 
   // Geoid height
   out->H = in.h - Ng;
+} /* fila_ellips2xy_ctx */
+
+
+// ----------------------------------------------------------------------------
+// fila_ellips2xy (height calculated from geoid)
+// ----------------------------------------------------------------------------
+// Transform from fi,la,h to GK/TM x,y,H coordinates on specified ellipsoid
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void fila_ellips2xy(GEOGRA in, GEOUTM *out, int oid)
+{
+  fila_ellips2xy_ctx(geo_ctx_default(), in, out, oid);
 } /* fila_ellips2xy */
 
 
+// ----------------------------------------------------------------------------
+// proj_jacobian
+// Partial derivatives of GK/TM x (northing), y (easting) by fi, la (in
+// radians) on specified ellipsoid: projection is conformal, so they are
+// given by radii of curvature, scale factor k and meridian convergence gam
+// (series on ellipsoid, same order as tan-power series of projection)
+// ----------------------------------------------------------------------------
+static void proj_jacobian(double fi, double la, int oid, double *dxfi, double *dxla,
+                          double *dyfi, double *dyla)
+{
+  double sinFi, cosFi, dla, w, N, M, k, gam, t2, ni2, A2;
+
+  sinFi = sin(fi); cosFi = cos(fi); dla = la - tm.lambda0;
+  w = 1.0 - ellips[oid].e2*sinFi*sinFi;
+  N = ellips[oid].a/sqrt(w);            // radius of curvature in prime vertical
+  M = N*(1.0 - ellips[oid].e2)/w;       // radius of curvature in meridian
+  t2 = sinFi*sinFi/(cosFi*cosFi);
+  ni2 = ellips[oid].e2_*cosFi*cosFi;
+  A2 = dla*dla*cosFi*cosFi;
+  k = tm.scale*(1.0 + A2*((1.0 + ni2)/2.0     // scale factor
+    + A2*((5.0 - 4.0*t2 + 42.0*ni2 + 13.0*ni2*ni2 - 28.0*ellips[oid].e2_)/24.0
+    + A2*(61.0 - 148.0*t2 + 16.0*t2*t2)/720.0)));
+  gam = dla*sinFi*(1.0 + A2*((1.0 + 3.0*ni2 + 2.0*ni2*ni2)/3.0 // meridian convergence
+    + A2*(2.0 - t2)/15.0));
+
+  *dxfi = k*M*cos(gam);       *dxla = k*N*cosFi*sin(gam);
+  *dyfi = -k*M*sin(gam);      *dyla = k*N*cosFi*cos(gam);
+} /* proj_jacobian */
+
+
 // ----------------------------------------------------------------------------
 // xy2fila_ellips_loop (height calculated from geoid)
 // ----------------------------------------------------------------------------
 // Transform from GK/TM x,y,H coordinates to fi,la,h on specified ellipsoid
-// using loop search over coordinates
+// by inverting fila_ellips2xy() with Newton iterations (started in the middle
+// of GK zone 5, Slovenia). Returns 1 if converged, 0 otherwise.
 // ----------------------------------------------------------------------------
 // Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
-int xy2fila_ellips_loop(GEOUTM in, GEOGRA *out, int oid)
+int xy2fila_ellips_loop_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out, int oid)
 {
-  GEOGRA fl; GEOUTM xy;
-  double fi_max, fi_inc;
-  double la_max, la_inc;
-  long long int rx, ry, rxx, ryy; double prec;
-  int zone, found;
+  double fi, la, x, y, dx, dy, a, b, c, d, det;
+  int ii, zone, found;
   double Ng;
 
   zone = 5; // Slovenia
-  fl.fi = gkzones[zone].fimin; fi_max = gkzones[zone].fimax; fi_inc = 0.1;
-  fl.la = gkzones[zone].lamin; la_max = gkzones[zone].lamax; la_inc = 0.1;
-  fl.h = 0; // height will be calculated at the end
-
-  xy.x = 0; xy.y = 0; xy.H = 0;
-  prec = 100000000.0; // maximum precision (1e-8)
-  rx = xllround(in.x*prec); ry = xllround(in.y*prec);
-  rxx = xllround(xy.x*prec); ryy = xllround(xy.y*prec);
+  fi = (gkzones[zone].fimin + gkzones[zone].fimax)/2.0*PI/180.0;
+  la = (gkzones[zone].lamin + gkzones[zone].lamax)/2.0*PI/180.0;
 
   found = 0;
-  for ( ; ; ) {
-    for ( ; fl.fi <= fi_max; fl.fi += fi_inc) {
-      for ( ; fl.la <= la_max; fl.la += la_inc) {
-        fila_ellips2xy(fl, &xy, oid);
-        ryy = xllround(xy.y*prec);
-        if ((ry - ryy) < 0) {
-          fl.la -= la_inc;
-          break;
-        }
-        else if (ry == ryy) break;
-      } // for fl.la
-      rxx = xllround(xy.x*prec);
-      if ((rx - rxx) < 0) {
-        fl.fi -= fi_inc;
-        break;
-      }
-      else if (rx == rxx) break;
-    } // for fl.fi
-    if (ry == ryy && rx == rxx) { found = 1; break; }
-    fi_inc /= 10.0; la_inc /= 10.0; // increase precision for next round
-    if (fi_inc < 1e-18 || la_inc < 1e-18) break;
-  } // outer loop
-  fila_ellips2xy(fl, &xy, oid);
+  for (ii = 0; ii < MAXITER; ii++) {
+    proj_fila2xy(ctx->tmsel, fi, la, &x, &y, oid);
+    dx = in.x - x; dy = in.y - y;
+    if (fabs(dx) < 1e-8 && fabs(dy) < 1e-8) { found = 1; break; } // 1e-8 m
+    proj_jacobian(fi, la, oid, &a, &b, &c, &d);
+    det = a*d - b*c;
+    fi += (d*dx - b*dy)/det;
+    la += (a*dy - c*dx)/det;
+  }
 
-  out->fi = fl.fi; out->la = fl.la;
+  out->fi = fi*180.0/PI; out->la = la*180.0/PI;
 
   if (oid == 1 || oid == 2) //wgs84/etrs89
-    Ng = geoid_height(out->fi, out->la, gid_wgs); //slo2000/egm2008
+    Ng = geoid_height(out->fi, out->la, ctx->gid_wgs); //slo2000/egm2008
   else //bessel
     Ng = geoid_height(out->fi, out->la, 0); //bessel
   out->Ng = Ng;
@@ -968,6 +1914,11 @@ int xy2fila_ellips_loop(GEOUTM in, GEOGRA *out, int oid)
   out->h = in.H + Ng;
 
   return found;
+} /* xy2fila_ellips_loop_ctx */
+
+int xy2fila_ellips_loop(GEOUTM in, GEOGRA *out, int oid)
+{
+  return xy2fila_ellips_loop_ctx(geo_ctx_default(), in, out, oid);
 } /* xy2fila_ellips_loop */
 
 
@@ -975,111 +1926,109 @@ int xy2fila_ellips_loop(GEOUTM in, GEOGRA *out, int oid)
 // fila_ellips2xy_loop (height calculated from geoid)
 // ----------------------------------------------------------------------------
 // Transform from fi,la,h to GK/TM x,y,H coordinates on specified ellipsoid
-// using loop search over coordinates
+// by inverting xy2fila_ellips() with Newton iterations (started in the middle
+// of GK zone 5, Slovenia). Returns 1 if converged, 0 otherwise.
 // ----------------------------------------------------------------------------
 // Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
-int fila_ellips2xy_loop(GEOGRA in, GEOUTM *out, int oid)
+int fila_ellips2xy_loop_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out, int oid)
 {
-  GEOUTM xy; GEOGRA fl;
-  double x_max, x_inc;
-  double y_max, y_inc;
-  long long int rfi, rla, rxfi, rxla; double prec;
-  int zone, found;
+  double x, y, fi, la, dfi, dla, a, b, c, d;
+  int ii, zone, found;
   double Ng;
 
   if (oid == 1 || oid == 2) //wgs84/etrs89
-    Ng = geoid_height(in.fi, in.la, gid_wgs); //slo2000/egm2008
+    Ng = geoid_height(in.fi, in.la, ctx->gid_wgs); //slo2000/egm2008
   else //bessel
     Ng = geoid_height(in.fi, in.la, 0); //bessel
   out->Ng = Ng;
 
   zone = 5; // Slovenia
-  xy.x = gkzones[zone].xmin; x_max = gkzones[zone].xmax; x_inc = 10000;
-  xy.y = gkzones[zone].ymin; y_max = gkzones[zone].ymax; y_inc = 10000;
-  xy.H = 0; // height will be calculated at the end
-
-  fl.fi = 0; fl.la = 0; fl.h = 0.0;
-  prec = 100000000.0; // maximum precision (1e-8)
-  rfi = xllround(in.fi*prec); rla = xllround(in.la*prec);
-  rxfi = xllround(fl.fi*prec); rxla = xllround(fl.la*prec);
+  x = (gkzones[zone].xmin + gkzones[zone].xmax)/2.0;
+  y = (gkzones[zone].ymin + gkzones[zone].ymax)/2.0;
 
   found = 0;
-  for ( ; ; ) {
-    for ( ; xy.x <= x_max; xy.x += x_inc) {
-      for ( ; xy.y <= y_max; xy.y += y_inc) {
-        xy2fila_ellips(xy, &fl, oid);
-        rxla = xllround(fl.la*prec);
-        if ((rla - rxla) < 0) {
-          xy.y -= y_inc;
-          break;
-        }
-        else if (rla == rxla) break;
-      } // for xy.y
-      rxfi = xllround(fl.fi*prec);
-      if ((rfi - rxfi) < 0) {
-        xy.x -= x_inc;
-        break;
-      }
-      else if (rfi == rxfi) break;
-    } // for xy.x
-    if (rla == rxla && rfi == rxfi) { found = 1; break; }
-    x_inc /= 10.0; y_inc /= 10.0; // increase precision for next round
-    if (x_inc < 1e-18 || y_inc < 1e-18) break;
-  } // outer loop
-  xy2fila_ellips(xy, &fl, oid);
+  for (ii = 0; ii < MAXITER; ii++) {
+    proj_xy2fila(ctx->tmsel, x, y, &fi, &la, oid);
+    dfi = in.fi*PI/180.0 - fi; dla = in.la*PI/180.0 - la;
+    if (fabs(dfi) < 1e-15 && fabs(dla) < 1e-15) { found = 1; break; } // ~1e-8 m
+    proj_jacobian(fi, la, oid, &a, &b, &c, &d);
+    x += a*dfi + b*dla;
+    y += c*dfi + d*dla;
+  }
 
-  out->x = xy.x; out->y = xy.y;
+  out->x = x; out->y = y;
 
   // Geoid height
   out->H = in.h - Ng;
 
   return found;
+} /* fila_ellips2xy_loop_ctx */
+
+int fila_ellips2xy_loop(GEOGRA in, GEOUTM *out, int oid)
+{
+  return fila_ellips2xy_loop_ctx(geo_ctx_default(), in, out, oid);
 } /* fila_ellips2xy_loop */
 
 
 // ----------------------------------------------------------------------------
-// xyz2fila_ellips (height calculated from input)
+// xyz2fila_rad (height calculated from input)
 // ----------------------------------------------------------------------------
-// Transform from cart. X,Y,Z coordinates to fi,la,h on specified ellipsoid
+// Transform from cart. X,Y,Z coordinates to fi,la (in radians),h on specified
+// ellipsoid (h can be NULL if transformed height is not needed)
 // ----------------------------------------------------------------------------
 // Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
-void xyz2fila_ellips(GEOCEN in, GEOGRA *out, int oid)
+void xyz2fila_rad(double X, double Y, double Z, double *fi, double *la, double *h, int oid)
 {
-  double p, N;
+  double p, N, ht;
   double O, sinO, sin3O, cosO, cos3O;
   double fi0, dif; int n;
 
   // See "Comparison of different algorithms to transform
   //      geocentric to geodetic coordinates (Seemkooei, 2002)"
-  p = sqrt(pow(in.X,2) + pow(in.Y,2));
+  p = sqrt(pow(X,2) + pow(Y,2));
 #ifdef FI1
   // Bowring's algorithm (fastest)
-  O = atan2(in.Z*ellipsoid.a, p*ellipsoid.b);
+  O = atan2(Z*ellipsoid.a, p*ellipsoid.b);
   sinO = sin(O);
   sin3O = pow(sinO,3);
   cosO = cos(O);
   cos3O = pow(cosO,3);
 
-  out->fi = atan2(in.Z + ellipsoid.e2_*ellipsoid.b*sin3O,
+  *fi = atan2(Z + ellipsoid.e2_*ellipsoid.b*sin3O,
                   p - ellipsoid.e2*ellipsoid.a*cos3O);
 
-  N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*pow(sin(out->fi),2));
+  *la = atan2(Y, X);
+  if (h == NULL) return; // skip transformed height
+  N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*pow(sin(*fi),2));
 #else //FI2
   // Heiskanen and Moritz's algorithm (slower), more errors
-  fi0 = atan2(in.Z*ellipsoid.a2, ellipsoid.b2*p); // first estimate
-//fi0 = atan2(in.Z/(1.0 - ellipsoid.e2)*p); // identical (from Wiki)
+  fi0 = atan2(Z*ellipsoid.a2, ellipsoid.b2*p); // first estimate
+//fi0 = atan2(Z/(1.0 - ellipsoid.e2)*p); // identical (from Wiki)
   dif = 1.0; n = 15;
   while (fabs(dif) >= 1e-18 && n > 0) {
     N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*pow(sin(fi0),2));
-    out->h = p/cos(fi0) - N;
-    out->fi = atan2(in.Z, (1.0 - ellipsoid.e2*(N/(N + out->h)))*p);
-    dif = fi0 - out->fi;
-    fi0 = out->fi;
+    ht = p/cos(fi0) - N;
+    *fi = atan2(Z, (1.0 - ellipsoid.e2*(N/(N + ht)))*p);
+    dif = fi0 - *fi;
+    fi0 = *fi;
     n--;
   }
+  *la = atan2(Y, X);
+  if (h == NULL) return; // skip transformed height
 #endif
-  out->la = atan2(in.Y, in.X);
-  out->h = p/cos(out->fi) - N;
+  *h = p/cos(*fi) - N;
+} /* xyz2fila_rad */
+
+
+// ----------------------------------------------------------------------------
+// xyz2fila_ellips (height calculated from input)
+// ----------------------------------------------------------------------------
+// Transform from cart. X,Y,Z coordinates to fi,la,h on specified ellipsoid
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void xyz2fila_ellips(GEOCEN in, GEOGRA *out, int oid)
+{
+  xyz2fila_rad(in.X, in.Y, in.Z, &out->fi, &out->la, &out->h, oid);
 
   // Convert from radians to degrees
   out->fi = out->fi*180.0/PI;
@@ -1087,6 +2036,28 @@ void xyz2fila_ellips(GEOCEN in, GEOGRA *out, int oid)
 } /* xyz2fila_ellips */
 
 
+// ----------------------------------------------------------------------------
+// fila2xyz_rad (height included in calculation)
+// ----------------------------------------------------------------------------
+// Transform from fi,la (in radians),h to cart. X,Y,Z coordinates on specified
+// ellipsoid
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+void fila2xyz_rad(double fi, double la, double h, double *X, double *Y, double *Z, int oid)
+{
+  double sinFi, cosFi, N;
+
+  sinFi = sin(fi); cosFi = cos(fi);
+  N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*sinFi*sinFi);
+
+  // Hofmann-Wellenhof et al. 1994, ISO/DIS 19111 2001
+  *X = (N + h)*cosFi*cos(la);
+  *Y = (N + h)*cosFi*sin(la);
+  *Z = ((ellipsoid.b2/ellipsoid.a2)*N + h)*sinFi;
+//*Z = ((1.0 - ellipsoid.e2)*N + h)*sinFi; // identical (from Wiki)
+} /* fila2xyz_rad */
+
+
 // ----------------------------------------------------------------------------
 // fila_ellips2xyz (height included in calculation)
 // ----------------------------------------------------------------------------
@@ -1095,242 +2066,268 @@ void xyz2fila_ellips(GEOCEN in, GEOGRA *out, int oid)
 // Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
 void fila_ellips2xyz(GEOGRA in, GEOCEN *out, int oid)
 {
-  double N;
-
   // Convert from degrees to radians
-  in.fi = in.fi*PI/180.0;
-  in.la = in.la*PI/180.0;
-
-  N = ellipsoid.a/sqrt(1.0 - ellipsoid.e2*pow(sin(in.fi),2));
-
-  // Hofmann-Wellenhof et al. 1994, ISO/DIS 19111 2001
-  out->X = (N + in.h)*cos(in.fi)*cos(in.la);
-  out->Y = (N + in.h)*cos(in.fi)*sin(in.la);
-  out->Z = ((ellipsoid.b2/ellipsoid.a2)*N + in.h)*sin(in.fi);
-//out->Z = ((1.0 - ellipsoid.e2)*N + in.h)*sin(in.fi); // identical (from Wiki)
+  fila2xyz_rad(in.fi*PI/180.0, in.la*PI/180.0, in.h, &out->X, &out->Y, &out->Z, oid);
 } /* fila_ellips2xyz */
 
 
 // ----------------------------------------------------------------------------
-// xyz2xyz_helmert
+// xyz2xyz_h7
 // ----------------------------------------------------------------------------
 // Transform from cart. X,Y,Z to cart. X,Y,Z coordinates
 // using Helmert 7-parameters transformation
 // [Xo;Yo;Zo] = [Xt;Yt;Zt] + (1 + s)*R*[Xi;Yi;Zi]
-// R: rotation matrix
+// sR: rotation matrix multiplied by scale (from h7_precalc)
 // ----------------------------------------------------------------------------
-void xyz2xyz_helmert(GEOCEN in, GEOCEN *out, HELMERT7 h7)
+void xyz2xyz_h7(double X, double Y, double Z, double *oX, double *oY, double *oZ,
+                const HELMERT7 *h7)
 {
+#if defined(H71) || defined(H72)
+  double (*sR)[3] = (double (*)[3])h7->sR;
+
+  // H71: See "GNSS - Global Navigation Satellite Systems (Hofmann-Wellenhof, 2008), pg: 294"
+  // H72: See "Computing Helmert transformations (Watson, 2005)"
+  *oX = h7->dX + sR[0][0]*X + sR[0][1]*Y + sR[0][2]*Z;
+  *oY = h7->dY + sR[1][0]*X + sR[1][1]*Y + sR[1][2]*Z;
+  *oZ = h7->dZ + sR[2][0]*X + sR[2][1]*Y + sR[2][2]*Z;
+#else
   double alfa, beta, gama, dm1;
-  double (*R)[3] = (double (*)[3])h7.R;
-
-#if 0
-  if (inv < 0) { // for inverse transformation
-    // not really aplicable, although mentioned in Wiki
-    h7.dX = -h7.dX; h7.dY = -h7.dY; h7.dZ = -h7.dZ;
-    h7.alfa = -h7.alfa; h7.beta = -h7.beta; h7.gama = -h7.gama;
-    h7.dm = -h7.dm;
-  }
-#endif
 
   // Angles specified in arc seconds, convert to radians
-  alfa = (h7.alfa/3600.0)*PI/180.0;
-  beta = (h7.beta/3600.0)*PI/180.0;
-  gama = (h7.gama/3600.0)*PI/180.0;
+  alfa = (h7->alfa/3600.0)*PI/180.0;
+  beta = (h7->beta/3600.0)*PI/180.0;
+  gama = (h7->gama/3600.0)*PI/180.0;
 
-  dm1 = 1.0 + h7.dm*1e-6;
-#ifdef H71
-  // See "GNSS - Global Navigation Satellite Systems (Hofmann-Wellenhof, 2008), pg: 294"
-  // See "Digitalni model reliefa (Podobnikar, 2001), pg. 114(pdf: 119)"
-  out->X = h7.dX + dm1*(R[0][0]*in.X + R[0][1]*in.Y + R[0][2]*in.Z);
-  out->Y = h7.dY + dm1*(R[1][0]*in.X + R[1][1]*in.Y + R[1][2]*in.Z);
-  out->Z = h7.dZ + dm1*(R[2][0]*in.X + R[2][1]*in.Y + R[2][2]*in.Z);
-#elif defined(H72)
-  // See "Computing Helmert transformations (Watson, 2005)"
-  // (different rotations?!)
-  out->X = h7.dX + dm1*(R[0][0]*in.X + R[0][1]*in.Y + R[0][2]*in.Z);
-  out->Y = h7.dY + dm1*(R[1][0]*in.X + R[1][1]*in.Y + R[1][2]*in.Z);
-  out->Z = h7.dZ + dm1*(R[2][0]*in.X + R[2][1]*in.Y + R[2][2]*in.Z);
-#elif defined(H73)
+  dm1 = 1.0 + h7->dm*1e-6;
+#ifdef H73
   // Simplified version (for small angles, from Wiki)
-  out->X = h7.dX + dm1*(in.X       + gama*in.Y - beta*in.Z);
-  out->Y = h7.dY + dm1*(-gama*in.X + in.Y      + alfa*in.Z);
-  out->Z = h7.dZ + dm1*(beta*in.X  - alfa*in.Y + in.Z);
+  *oX = h7->dX + dm1*(X       + gama*Y - beta*Z);
+  *oY = h7->dY + dm1*(-gama*X + Y      + alfa*Z);
+  *oZ = h7->dZ + dm1*(beta*X  - alfa*Y + Z);
 #else
   // See "A guide to coordinate systems in Great Britain (2013), pg. 30"
   // (not suitable for Slovenia?!)
-  out->X = h7.dX + (dm1*in.X   - gama*in.Y + beta*in.Z);
-  out->Y = h7.dY + (gama*in.X  + dm1*in.Y  - alfa*in.Z);
-  out->Z = h7.dZ + (-beta*in.X + alfa*in.Y + dm1*in.Z);
+  *oX = h7->dX + (dm1*X   - gama*Y + beta*Z);
+  *oY = h7->dY + (gama*X  + dm1*Y  - alfa*Z);
+  *oZ = h7->dZ + (-beta*X + alfa*Y + dm1*Z);
+#endif
 #endif
+} /* xyz2xyz_h7 */
+
+
+// ----------------------------------------------------------------------------
+// xyz2xyz_helmert
+// ----------------------------------------------------------------------------
+// Transform from cart. X,Y,Z to cart. X,Y,Z coordinates
+// using Helmert 7-parameters transformation
+// [Xo;Yo;Zo] = [Xt;Yt;Zt] + (1 + s)*R*[Xi;Yi;Zi]
+// R: rotation matrix
+// ----------------------------------------------------------------------------
+void xyz2xyz_helmert(GEOCEN in, GEOCEN *out, HELMERT7 h7)
+{
+  xyz2xyz_h7(in.X, in.Y, in.Z, &out->X, &out->Y, &out->Z, &h7);
 } /* xyz2xyz_helmert */
 
 
 // ----------------------------------------------------------------------------
-// gkxy2fila_wgs
+// gkxy2fila_wgs_ctx
 // ----------------------------------------------------------------------------
 // Transform from GK x,y,H on Bessel 1841 to fi,la,h on WGS 84
 // ----------------------------------------------------------------------------
-void gkxy2fila_wgs(GEOUTM in, GEOGRA *out)
+void gkxy2fila_wgs_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out)
 {
-  GEOGRA flb;
-  GEOCEN xyzb, xyzw;
-  DMS lat, lon;
-  double Ng, H;
+  double fi, la, X, Y, Z, Xw, Yw, Zw, Ng, H;
+  int ht;
 
   H = in.H; // in.H = 0.0;
+  ht = (ctx->hsel != 1 && ctx->hsel != 2); // transformed height needed?
 
-  // Convert GK x,y,H to fi,la,h on Bessel 1841
-  xy2fila_ellips(in, &flb, 0); // no change in height because of bessel
+  // Single pass in radians, without geoid lookup on Bessel 1841
+  // (doesn't exist, always 0)
 
-#if 0 //xxx
-  deg2dms(flb.fi, &lat); deg2dms(flb.la, &lon);
-  printf("> lat_b: %2.0f %2.0f %6.3f, lon_b: %2.0f %2.0f %6.3f\n",
-         lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
-#endif
+  // Convert GK x,y,H to fi,la,h on Bessel 1841 (h = H)
+  proj_xy2fila(ctx->tmsel, in.x, in.y, &fi, &la, 0);
 
   // Convert fi,la,h on Bessel 1841 to X,Y,Z on Bessel 1841
-  fila_ellips2xyz(flb, &xyzb, 0); // height included in calculation of XYZ
+  fila2xyz_rad(fi, la, H, &X, &Y, &Z, 0); // height included in calculation of XYZ
 
   // Convert X,Y,Z on Bessel 1841 to X,Y,Z on WGS 84
-  xyz2xyz_helmert(xyzb, &xyzw, slo7);
+  xyz2xyz_h7(X, Y, Z, &Xw, &Yw, &Zw, &slo7);
 
   // Convert X,Y,Z on WGS 84 to fi,la,h on WGS 84
-  xyz2fila_ellips(xyzw, out, 1); // transformed height calculated from XYZ
+  xyz2fila_rad(Xw, Yw, Zw, &fi, &la, ht ? &out->h : NULL, 1); // transformed height
+
+  // Convert from radians to degrees
+  out->fi = fi*180.0/PI;
+  out->la = la*180.0/PI;
 
-//if (hsel < 0) out->h;             // default: transformed height (SiTra)
-  if (hsel == 1) out->h = H;        // copied height
-  else if (hsel == 2) {
-    Ng = geoid_height(out->fi, out->la, gid_wgs); //slo2000/egm2008
+//if (ctx->hsel < 0) out->h;        // default: transformed height (SiTra)
+  if (ctx->hsel == 1) out->h = H;   // copied height
+  else if (ctx->hsel == 2) {
+    Ng = geoid_height(out->fi, out->la, ctx->gid_wgs); //slo2000/egm2008
     out->h = H + Ng;                // geoid height
   }
+} /* gkxy2fila_wgs_ctx */
+
+
+// ----------------------------------------------------------------------------
+// gkxy2fila_wgs
+// ----------------------------------------------------------------------------
+// Transform from GK x,y,H on Bessel 1841 to fi,la,h on WGS 84
+// ----------------------------------------------------------------------------
+void gkxy2fila_wgs(GEOUTM in, GEOGRA *out)
+{
+  gkxy2fila_wgs_ctx(geo_ctx_default(), in, out);
 } /* gkxy2fila_wgs */
 
 
 // ----------------------------------------------------------------------------
-// fila_wgs2gkxy
+// fila_wgs2gkxy_ctx
 // ----------------------------------------------------------------------------
 // Transform from fi,la,h on WGS 84 to GK x,y,H on Bessel 1841
 // ----------------------------------------------------------------------------
-void fila_wgs2gkxy(GEOGRA in, GEOUTM *out)
+void fila_wgs2gkxy_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out)
 {
-  GEOGRA flb;
-  GEOCEN xyzb, xyzw;
-  DMS lat, lon;
-  double Ng, h;
+  double fi, la, X, Y, Z, Xb, Yb, Zb, Ng, h;
 
   h = in.h; // in.h = 0.0;
-  if (hsel < 0 || hsel == 2)
-    Ng = geoid_height(in.fi, in.la, gid_wgs); //slo2000/egm2008
+  if (ctx->hsel < 0 || ctx->hsel == 2)
+    Ng = geoid_height(in.fi, in.la, ctx->gid_wgs); //slo2000/egm2008
   else Ng = 0.0; // to keep compiler happy
 
+  // Single pass in radians, without geoid lookup on Bessel 1841
+  // (doesn't exist, always 0)
+
   // Convert fi,la,h on WGS 84 to X,Y,Z on WGS 84
-  fila_ellips2xyz(in, &xyzw, 1); // height included in calculation of XYZ
+  fila2xyz_rad(in.fi*PI/180.0, in.la*PI/180.0, h, &X, &Y, &Z, 1); // height included in calculation of XYZ
 
   // Convert X,Y,Z on WGS 84 to X,Y,Z on Bessel 1841
-  xyz2xyz_helmert(xyzw, &xyzb, slo7inv);
+  xyz2xyz_h7(X, Y, Z, &Xb, &Yb, &Zb, &slo7inv);
 
   // Convert X,Y,Z on Bessel 1841 to fi,la,h on Bessel 1841
-  xyz2fila_ellips(xyzb, &flb, 0); // transformed height calculated from XYZ
+  // (transformed height only needed for hsel == 0)
+  xyz2fila_rad(Xb, Yb, Zb, &fi, &la, (ctx->hsel == 0) ? &out->H : NULL, 0);
 
-#if 0 //xxx
-  deg2dms(flb.fi, &lat); deg2dms(flb.la, &lon);
-  printf("> lat_b: %2.0f %2.0f %6.3f, lon_b: %2.0f %2.0f %6.3f\n",
-         lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
-#endif
+  // Convert fi,la to GK x,y on Bessel 1841
+  proj_fila2xy(ctx->tmsel, fi, la, &out->x, &out->y, 0);
+  out->Ng = 0.0;
 
-  // Convert fi,la,h to GK x,y,H on Bessel 1841
-  fila_ellips2xy(flb, out, 0); // no change in height because of bessel
+  if (ctx->hsel < 0) out->H = h - Ng;       // default: geoid height (SiTra)
+  else if (ctx->hsel == 1) out->H = h;      // copied height
+  else if (ctx->hsel == 2) out->H = h - Ng; // geoid height
+//else out->H;                              // transformed height
+} /* fila_wgs2gkxy_ctx */
 
-  if (hsel < 0) out->H = h - Ng;       // default: geoid height (SiTra)
-  else if (hsel == 1) out->H = h;      // copied height
-  else if (hsel == 2) out->H = h - Ng; // geoid height
+
+// ----------------------------------------------------------------------------
+// fila_wgs2gkxy
+// ----------------------------------------------------------------------------
+// Transform from fi,la,h on WGS 84 to GK x,y,H on Bessel 1841
+// ----------------------------------------------------------------------------
+void fila_wgs2gkxy(GEOGRA in, GEOUTM *out)
+{
+  fila_wgs2gkxy_ctx(geo_ctx_default(), in, out);
 } /* fila_wgs2gkxy */
 
 
 // ----------------------------------------------------------------------------
-// gkxy2tmxy
+// gkxy2tmxy_ctx
 // ----------------------------------------------------------------------------
 // Transform from GK x,y,H on Bessel 1841 to TM n,e,H on WGS 84
 // ----------------------------------------------------------------------------
-void gkxy2tmxy(GEOUTM in, GEOUTM *out)
+void gkxy2tmxy_ctx(GEO_CTX *ctx, GEOUTM in, GEOUTM *out)
 {
-  GEOGRA fl, flb;
-  GEOCEN xyzb, xyzw;
-  DMS lat, lon;
-  double H, ht;
-
-  H = in.H; // in.H = 0.0;
+  double fi, la, h, X, Y, Z, Xw, Yw, Zw, Ng;
 
-  // Convert GK x,y,H to fi,la,h on Bessel 1841
-  xy2fila_ellips(in, &flb, 0); // no change in height because of bessel
+  // Single pass in radians, without intermediate structs and without
+  // geoid lookup on Bessel 1841 (doesn't exist, always 0)
 
-#if 0 //xxx
-  deg2dms(flb.fi, &lat); deg2dms(flb.la, &lon);
-  printf("> lat_b: %2.0f %2.0f %6.3f, lon_b: %2.0f %2.0f %6.3f\n",
-         lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
-#endif
+  // Convert GK x,y,H to fi,la,h on Bessel 1841 (h = H)
+  proj_xy2fila(ctx->tmsel, in.x, in.y, &fi, &la, 0);
 
   // Convert fi,la,h on Bessel 1841 to X,Y,Z on Bessel 1841
-  fila_ellips2xyz(flb, &xyzb, 0); // height included in calculation of XYZ
+  fila2xyz_rad(fi, la, in.H, &X, &Y, &Z, 0);
 
   // Convert X,Y,Z on Bessel 1841 to X,Y,Z on WGS 84
-  xyz2xyz_helmert(xyzb, &xyzw, slo7);
+  xyz2xyz_h7(X, Y, Z, &Xw, &Yw, &Zw, &slo7);
 
   // Convert X,Y,Z on WGS 84 to fi,la,h on WGS 84
-  xyz2fila_ellips(xyzw, &fl, 1); // transformed height calculated from XYZ
+  // (transformed height not needed for copied height)
+  xyz2fila_rad(Xw, Yw, Zw, &fi, &la, (ctx->hsel == 1) ? NULL : &h, 1);
 
-  ht = fl.h; // fl.h = 0.0;
+  // Convert fi,la on WGS 84 to TM n,e on WGS 84
+  proj_fila2xy(ctx->tmsel, fi, la, &out->x, &out->y, 1);
+
+  if (ctx->hsel == 1) {      // copied height
+    out->H = in.H; out->Ng = 0.0;
+  }
+  else if (ctx->hsel == 0) { // transformed height
+    out->H = h; out->Ng = 0.0;
+  }
+  else {                     // default: geoid height (closest)
+    Ng = geoid_height(fi*180.0/PI, la*180.0/PI, ctx->gid_wgs); //slo2000/egm2008
+    out->H = h - Ng; out->Ng = Ng;
+  }
+} /* gkxy2tmxy_ctx */
 
-  // Convert fi,la,h on WGS 84 to TM n,e,H on WGS 84
-  fila_ellips2xy(fl, out, 1); // height calculated from geoid (H = h - Ng)
 
-//if (hsel < 0) out->H;            // default: geoid height (closest)
-  if (hsel == 1) out->H = H;       // copied height
-  else if (hsel == 0) out->H = ht; // transformed height
+// ----------------------------------------------------------------------------
+// gkxy2tmxy
+// ----------------------------------------------------------------------------
+// Transform from GK x,y,H on Bessel 1841 to TM n,e,H on WGS 84
+// ----------------------------------------------------------------------------
+void gkxy2tmxy(GEOUTM in, GEOUTM *out)
+{
+  gkxy2tmxy_ctx(geo_ctx_default(), in, out);
 } /* gkxy2tmxy */
 
 
 // ----------------------------------------------------------------------------
-// tmxy2gkxy
+// tmxy2gkxy_ctx
 // ----------------------------------------------------------------------------
 // Transform from TM n,e,H on WGS 84 to GK x,y,H on Bessel 1841
 // ----------------------------------------------------------------------------
-void tmxy2gkxy(GEOUTM in, GEOUTM *out)
+void tmxy2gkxy_ctx(GEO_CTX *ctx, GEOUTM in, GEOUTM *out)
 {
-  GEOGRA fl, flb;
-  GEOCEN xyzb, xyzw;
-  DMS lat, lon;
-  double hg, H;
+  double fi, la, h, X, Y, Z, Xb, Yb, Zb, Ng;
 
-  H = in.H; // in.H = 0.0;
+  // Single pass in radians, without intermediate structs and without
+  // geoid lookup on Bessel 1841 (doesn't exist, always 0)
 
-  // Convert TM n,e,H on WGS 84 to fi,la,h on WGS 84
-  xy2fila_ellips(in, &fl, 1); // height calculated from geoid (h = H + Ng)
+  // Convert TM n,e on WGS 84 to fi,la on WGS 84
+  proj_xy2fila(ctx->tmsel, in.x, in.y, &fi, &la, 1);
 
-  hg = fl.h; // fl.h = 0.0;
+  // Height calculated from geoid (h = H + Ng)
+  Ng = geoid_height(fi*180.0/PI, la*180.0/PI, ctx->gid_wgs); //slo2000/egm2008
 
   // Convert fi,la,h on WGS 84 to X,Y,Z on WGS 84
-  fila_ellips2xyz(fl, &xyzw, 1); // height included in calculation of XYZ
+  fila2xyz_rad(fi, la, in.H + Ng, &X, &Y, &Z, 1);
 
   // Convert X,Y,Z on WGS 84 to X,Y,Z on Bessel 1841
-  xyz2xyz_helmert(xyzw, &xyzb, slo7inv);
+  xyz2xyz_h7(X, Y, Z, &Xb, &Yb, &Zb, &slo7inv);
 
   // Convert X,Y,Z on Bessel 1841 to fi,la,h on Bessel 1841
-  xyz2fila_ellips(xyzb, &flb, 0); // transformed height calculated from XYZ
+  // (transformed height not needed for copied or geoid height)
+  xyz2fila_rad(Xb, Yb, Zb, &fi, &la, (ctx->hsel == 1 || ctx->hsel == 2) ? NULL : &h, 0);
 
-#if 0 //xxx
-  deg2dms(flb.fi, &lat); deg2dms(flb.la, &lon);
-  printf("> lat_b: %2.0f %2.0f %6.3f, lon_b: %2.0f %2.0f %6.3f\n",
-         lat.deg, lat.min, lat.sec, lon.deg, lon.min, lon.sec);
-#endif
+  // Convert fi,la to GK x,y on Bessel 1841
+  proj_fila2xy(ctx->tmsel, fi, la, &out->x, &out->y, 0);
+  out->Ng = 0.0;
 
-  // Convert fi,la,h to GK x,y,H on Bessel 1841
-  fila_ellips2xy(flb, out, 0); // no change in height because of bessel
+  if (ctx->hsel == 1) out->H = in.H;           // copied height
+  else if (ctx->hsel == 2) out->H = in.H + Ng; // geoid height (already calculated)
+  else out->H = h;                             // default: transformed height (closest)
+} /* tmxy2gkxy_ctx */
 
-//if (hsel < 0) out->H;            // default: transformed height (closest)
-  if (hsel == 1) out->H = H;       // copied height
-  else if (hsel == 2) out->H = hg; // geoid height (already calculated)
+
+// ----------------------------------------------------------------------------
+// tmxy2gkxy
+// ----------------------------------------------------------------------------
+// Transform from TM n,e,H on WGS 84 to GK x,y,H on Bessel 1841
+// ----------------------------------------------------------------------------
+void tmxy2gkxy(GEOUTM in, GEOUTM *out)
+{
+  tmxy2gkxy_ctx(geo_ctx_default(), in, out);
 } /* tmxy2gkxy */
 
 
@@ -1343,7 +2340,7 @@ void tmxy2gkxy(GEOUTM in, GEOUTM *out)
 int gkxy2tmxy_aft(GEOUTM in, GEOUTM *out, int *last_tri)
 {
   double H;
-  int ii, jj, found;
+  int ii, found;
 
   H = in.H;
 
@@ -1361,28 +2358,15 @@ int gkxy2tmxy_aft(GEOUTM in, GEOUTM *out, int *last_tri)
     else *last_tri = -1;
   }
 
-  // if not found, search from the middle of the table in both directions
-  ii = MAXAFT / 2; jj = ii - 1;
-  for ( ; !found; ) {
-    if (ii < MAXAFT) {
-      if (coord_in_triangle(in, aft_gktm[ii])) {
-        out->x = aft_gktm[ii].a*in.x + aft_gktm[ii].b*in.y + aft_gktm[ii].c;
-        out->y = aft_gktm[ii].d*in.x + aft_gktm[ii].e*in.y + aft_gktm[ii].f;
-        *last_tri = ii;
-        found = 1; break;
-      }
-      ii++;
-    }
-    if (jj >= 0) {
-      if (coord_in_triangle(in, aft_gktm[jj])) {
-        out->x = aft_gktm[jj].a*in.x + aft_gktm[jj].b*in.y + aft_gktm[jj].c;
-        out->y = aft_gktm[jj].d*in.x + aft_gktm[jj].e*in.y + aft_gktm[jj].f;
-        *last_tri = jj;
-        found = 1; break;
-      }
-      jj--;
+  // if not found, check triangles in grid cell of point
+  if (!found) {
+    ii = aft_find(&aft_gktm_idx, aft_gktm, in);
+    if (ii >= 0) {
+      out->x = aft_gktm[ii].a*in.x + aft_gktm[ii].b*in.y + aft_gktm[ii].c;
+      out->y = aft_gktm[ii].d*in.x + aft_gktm[ii].e*in.y + aft_gktm[ii].f;
+      *last_tri = ii;
+      found = 1;
     }
-    if (ii >= MAXAFT && jj < 0) break;
   }
 
   out->H = H;  // default: copied height
@@ -1400,7 +2384,7 @@ int gkxy2tmxy_aft(GEOUTM in, GEOUTM *out, int *last_tri)
 int tmxy2gkxy_aft(GEOUTM in, GEOUTM *out, int *last_tri)
 {
   double H;
-  int ii, jj, found;
+  int ii, found;
 
   H = in.H;
 
@@ -1418,28 +2402,15 @@ int tmxy2gkxy_aft(GEOUTM in, GEOUTM *out, int *last_tri)
     else *last_tri = -1;
   }
 
-  // if not found, search from the middle of the table in both directions
-  ii = MAXAFT / 2; jj = ii - 1;
-  for ( ; !found; ) {
-    if (ii < MAXAFT) {
-      if (coord_in_triangle(in, aft_tmgk[ii])) {
-        out->x = aft_tmgk[ii].a*in.x + aft_tmgk[ii].b*in.y + aft_tmgk[ii].c;
-        out->y = aft_tmgk[ii].d*in.x + aft_tmgk[ii].e*in.y + aft_tmgk[ii].f;
-        *last_tri = ii;
-        found = 1; break;
-      }
-      ii++;
-    }
-    if (jj >= 0) {
-      if (coord_in_triangle(in, aft_tmgk[jj])) {
-        out->x = aft_tmgk[jj].a*in.x + aft_tmgk[jj].b*in.y + aft_tmgk[jj].c;
-        out->y = aft_tmgk[jj].d*in.x + aft_tmgk[jj].e*in.y + aft_tmgk[jj].f;
-        *last_tri = jj;
-        found = 1; break;
-      }
-      jj--;
+  // if not found, check triangles in grid cell of point
+  if (!found) {
+    ii = aft_find(&aft_tmgk_idx, aft_tmgk, in);
+    if (ii >= 0) {
+      out->x = aft_tmgk[ii].a*in.x + aft_tmgk[ii].b*in.y + aft_tmgk[ii].c;
+      out->y = aft_tmgk[ii].d*in.x + aft_tmgk[ii].e*in.y + aft_tmgk[ii].f;
+      *last_tri = ii;
+      found = 1;
     }
-    if (ii >= MAXAFT && jj < 0) break;
   }
 
   out->H = H;  // default: copied height
@@ -1449,45 +2420,94 @@ int tmxy2gkxy_aft(GEOUTM in, GEOUTM *out, int *last_tri)
 
 
 // ----------------------------------------------------------------------------
-// tmxy2fila_wgs
+// tmxy2fila_wgs_ctx
 // ----------------------------------------------------------------------------
 // Transform from TM n,e,H on WGS 84 to fi,la,h on WGS 84
 // ----------------------------------------------------------------------------
-void tmxy2fila_wgs(GEOUTM in, GEOGRA *out)
+void tmxy2fila_wgs_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out)
 {
   double H;
 
   H = in.H; // in.H = 0.0;
 
+  if (ctx->hsel == 1) { // copied height (no geoid lookup)
+    proj_xy2fila(ctx->tmsel, in.x, in.y, &out->fi, &out->la, 1);
+    out->fi = out->fi*180.0/PI;
+    out->la = out->la*180.0/PI;
+    out->h = H; out->Ng = 0.0;
+    return;
+  }
+
   // Convert TM n,e,H on WGS 84 to fi,la,h on WGS 84
-  xy2fila_ellips(in, out, 1); // height calculated from geoid (h = H + Ng)
+  xy2fila_ellips_ctx(ctx, in, out, 1); // height calculated from geoid (h = H + Ng)
 
-//if (hsel < 0) out->h;             // default: geoid height
-  if (hsel == 1) out->h = H;        // copied height
+//if (ctx->hsel < 0) out->h;        // default: geoid height
   // no transformed height possible
-} /* tmxy2fila_wgs */
+} /* tmxy2fila_wgs_ctx */
 
 
 // ----------------------------------------------------------------------------
-// fila_wgs2tmxy
+// tmxy2fila_wgs
 // ----------------------------------------------------------------------------
-// Transform from fi,la,h on WGS 84 to TM n,e,H on WGS 84
+// Transform from TM n,e,H on WGS 84 to fi,la,h on WGS 84
 // ----------------------------------------------------------------------------
-void fila_wgs2tmxy(GEOGRA in, GEOUTM *out)
+void tmxy2fila_wgs(GEOUTM in, GEOGRA *out)
 {
-  double h;
+  tmxy2fila_wgs_ctx(geo_ctx_default(), in, out);
+} /* tmxy2fila_wgs */
 
-  h = in.h; // in.h = 0.0;
+
+// ----------------------------------------------------------------------------
+// fila_wgs2tmxy_ctx
+// ----------------------------------------------------------------------------
+// Transform from fi,la,h on WGS 84 to TM n,e,H on WGS 84
+// ----------------------------------------------------------------------------
+void fila_wgs2tmxy_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out)
+{
+  double h;
+
+  h = in.h; // in.h = 0.0;
+
+  if (ctx->hsel == 1) { // copied height (no geoid lookup)
+    proj_fila2xy(ctx->tmsel, in.fi*PI/180.0, in.la*PI/180.0, &out->x, &out->y, 1);
+    out->H = h; out->Ng = 0.0;
+    return;
+  }
 
   // Convert fi,la,h on WGS 84 to TM n,e,H on WGS 84
-  fila_ellips2xy(in, out, 1); // height calculated from geoid (H = h - Ng)
+  fila_ellips2xy_ctx(ctx, in, out, 1); // height calculated from geoid (H = h - Ng)
 
-//if (hsel < 0) out->H;            // default: geoid height
-  if (hsel == 1) out->H = h;       // copied height
+//if (ctx->hsel < 0) out->H;       // default: geoid height
   // no transformed height possible
+} /* fila_wgs2tmxy_ctx */
+
+
+// ----------------------------------------------------------------------------
+// fila_wgs2tmxy
+// ----------------------------------------------------------------------------
+// Transform from fi,la,h on WGS 84 to TM n,e,H on WGS 84
+// ----------------------------------------------------------------------------
+void fila_wgs2tmxy(GEOGRA in, GEOUTM *out)
+{
+  fila_wgs2tmxy_ctx(geo_ctx_default(), in, out);
 } /* fila_wgs2tmxy */
 
 
+// ----------------------------------------------------------------------------
+// gkxy2fila_wgs_aft_ctx
+// ----------------------------------------------------------------------------
+// Transform from GK x,y,H on Bessel 1841 to fi,la,h on WGS 84
+// using pre-calculated affine transformation table
+// ----------------------------------------------------------------------------
+void gkxy2fila_wgs_aft_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out)
+{
+  GEOUTM tmxy;
+
+  gkxy2tmxy_aft(in, &tmxy, &ctx->last_tri);
+  tmxy2fila_wgs_ctx(ctx, tmxy, out);
+} /* gkxy2fila_wgs_aft_ctx */
+
+
 // ----------------------------------------------------------------------------
 // gkxy2fila_wgs_aft
 // ----------------------------------------------------------------------------
@@ -1496,13 +2516,29 @@ void fila_wgs2tmxy(GEOGRA in, GEOUTM *out)
 // ----------------------------------------------------------------------------
 void gkxy2fila_wgs_aft(GEOUTM in, GEOGRA *out, int *last_tri)
 {
-  GEOUTM tmxy;
+  GEO_CTX ctx;
 
-  gkxy2tmxy_aft(in, &tmxy, last_tri);
-  tmxy2fila_wgs(tmxy, out);
+  ctx = *geo_ctx_default(); ctx.last_tri = *last_tri;
+  gkxy2fila_wgs_aft_ctx(&ctx, in, out);
+  *last_tri = ctx.last_tri;
 } /* gkxy2fila_wgs_aft */
 
 
+// ----------------------------------------------------------------------------
+// fila_wgs2gkxy_aft_ctx
+// ----------------------------------------------------------------------------
+// Transform from fi,la,h on WGS 84 to GK x,y,H on Bessel 1841
+// using pre-calculated affine transformation table
+// ----------------------------------------------------------------------------
+void fila_wgs2gkxy_aft_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out)
+{
+  GEOUTM tmxy;
+
+  fila_wgs2tmxy_ctx(ctx, in, &tmxy);
+  tmxy2gkxy_aft(tmxy, out, &ctx->last_tri);
+} /* fila_wgs2gkxy_aft_ctx */
+
+
 // ----------------------------------------------------------------------------
 // fila_wgs2gkxy_aft
 // ----------------------------------------------------------------------------
@@ -1511,12 +2547,1664 @@ void gkxy2fila_wgs_aft(GEOUTM in, GEOGRA *out, int *last_tri)
 // ----------------------------------------------------------------------------
 void fila_wgs2gkxy_aft(GEOGRA in, GEOUTM *out, int *last_tri)
 {
-  GEOUTM tmxy;
+  GEO_CTX ctx;
 
-  fila_wgs2tmxy(in, &tmxy);
-  tmxy2gkxy_aft(tmxy, out, last_tri);
+  ctx = *geo_ctx_default(); ctx.last_tri = *last_tri;
+  fila_wgs2gkxy_aft_ctx(&ctx, in, out);
+  *last_tri = ctx.last_tri;
 } /* fila_wgs2gkxy_aft */
 
+
+// ----------------------------------------------------------------------------
+// proj_vec (heights not calculated)
+// Transform m points from GK/TM x,y to fi,la (inv = 1) or from fi,la to x,y
+// (inv = 0, fi,la in degrees) with projection constants pj and TM projection
+// series selected in plan (vectorized tan-power or Krueger n-series)
+// ----------------------------------------------------------------------------
+static void proj_vec(const GEO_PLAN *plan, const PROJ *pj, int inv, int m, const double *a,
+                     const double *b, double *oa, double *ob, int oid)
+{
+  if (plan->tmsel == 1) { // Krueger n-series
+    if (inv) xy2fila_krueger_proj_vec(pj, m, a, b, oa, ob, oid);
+    else fila2xy_krueger_proj_vec(pj, m, a, b, oa, ob, oid);
+  }
+  else if (inv) xy2fila_ellips_proj_vec(pj, m, a, b, oa, ob, oid);
+  else fila_ellips2xy_proj_vec(pj, m, a, b, oa, ob, oid);
+} /* proj_vec */
+
+
+// ----------------------------------------------------------------------------
+// gk_zone_xy, gk_zone_fila
+// GK zone of point from zone number in front of easting y (-1 if there is
+// none, i.e. coordinates for Slovenia) or from longitude la (in degrees)
+// ----------------------------------------------------------------------------
+static int gk_zone_xy(double y)
+{
+  int zone;
+
+  if (y < 1000000.0) return -1;
+  zone = (int)(y/1000000.0);
+  return (zone < GEO_MAXZONE) ? zone : GEO_MAXZONE - 1;
+} /* gk_zone_xy */
+
+static int gk_zone_fila(double la)
+{
+  int zone;
+
+  zone = (int)floor(la/3.0 + 0.5);
+  return (zone < 0) ? 0 : (zone < GEO_MAXZONE) ? zone : GEO_MAXZONE - 1;
+} /* gk_zone_fila */
+
+
+// ----------------------------------------------------------------------------
+// proj_zones_vec (heights not calculated)
+// Same as proj_vec(), but each point is transformed with constants of its
+// own GK zone. Points of a chunk are grouped by zone and each group is
+// transformed with one call (whole chunk if all points are in the same zone).
+// ----------------------------------------------------------------------------
+static void proj_zones_vec(const GEO_PLAN *plan, int inv, int m, const double *a,
+                           const double *b, double *oa, double *ob)
+{
+  double ta[MAXCHUNK], tb[MAXCHUNK];
+  int zone[MAXCHUNK], idx[MAXCHUNK];
+  int ii, jj, k, z, nz, mm, used;
+
+  for (ii = 0; ii < m; ii += mm) {
+    mm = (m - ii < MAXCHUNK) ? m - ii : MAXCHUNK;
+    used = 0; // bit per zone (bit 0: Slovenia)
+    for (jj = 0; jj < mm; jj++) {
+      zone[jj] = inv ? gk_zone_xy(b[ii+jj]) : gk_zone_fila(b[ii+jj]);
+      used |= 1 << (zone[jj] + 1);
+    }
+    for (z = -1; z < GEO_MAXZONE; z++) {
+      if (!(used & (1 << (z + 1)))) continue;
+      if (used == 1 << (z + 1)) { // whole chunk in one zone
+        proj_vec(plan, (z < 0) ? &tm : &gkproj[z], inv, mm, &a[ii], &b[ii], &oa[ii], &ob[ii], 0);
+        break;
+      }
+      for (jj = 0, nz = 0; jj < mm; jj++)
+        if (zone[jj] == z) { idx[nz] = ii + jj; ta[nz] = a[ii+jj]; tb[nz] = b[ii+jj]; nz++; }
+      proj_vec(plan, (z < 0) ? &tm : &gkproj[z], inv, nz, ta, tb, ta, tb, 0);
+      for (k = 0; k < nz; k++) { oa[idx[k]] = ta[k]; ob[idx[k]] = tb[k]; }
+    }
+  }
+} /* proj_zones_vec */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2fila_vec, plan_fila2xy_vec (heights not calculated)
+// Transform m points between GK/TM x,y and fi,la (in degrees) with TM
+// projection series selected in plan. GK coordinates (bessel) are
+// transformed in their own zones if plan->zones is set.
+// ----------------------------------------------------------------------------
+static void plan_xy2fila_vec(const GEO_PLAN *plan, int m, const double *x, const double *y,
+                             double *fi, double *la, int oid)
+{
+  if (plan->zones && oid == 0) proj_zones_vec(plan, 1, m, x, y, fi, la);
+  else proj_vec(plan, &tm, 1, m, x, y, fi, la, oid);
+} /* plan_xy2fila_vec */
+
+static void plan_fila2xy_vec(const GEO_PLAN *plan, int m, const double *fi, const double *la,
+                             double *x, double *y, int oid)
+{
+  if (plan->zones && oid == 0) proj_zones_vec(plan, 0, m, fi, la, x, y);
+  else proj_vec(plan, &tm, 0, m, fi, la, x, y, oid);
+} /* plan_fila2xy_vec */
+
+
+// Output array for transformed heights (NULL if not needed)
+#define PLAN_HT(plan, ht) (((plan)->skip & GEO_SKIP_HEIGHT) ? NULL : (ht))
+
+
+// ----------------------------------------------------------------------------
+// plan_heights
+// Output heights for m points of a chunk according to plan:
+//   oh = (input height h or transformed height ht) [+/- geoid height at fi,la]
+// (only one branch per chunk, no tests of hsel per point)
+// ----------------------------------------------------------------------------
+static void plan_heights(const GEO_PLAN *plan, int m, const double *h, const double *ht,
+                         const double *fi, const double *la, double *oh)
+{
+  double ng[MAXCHUNK];
+  const double *hb;
+  int ii, jj, mm;
+
+  hb = (plan->hsrc == GEO_HSRC_TRANS) ? ht : h;
+  if (plan->hgeoid == 0) {
+    if (oh != hb) memmove(oh, hb, m*sizeof(double));
+    return;
+  }
+  for (ii = 0; ii < m; ii += mm) {
+    mm = (m - ii < MAXCHUNK) ? m - ii : MAXCHUNK;
+    geoid_height_vec(mm, &fi[ii], &la[ii], ng, plan->gid);
+    if (plan->hgeoid > 0)
+      for (jj = 0; jj < mm; jj++) oh[ii+jj] = hb[ii+jj] + ng[jj];
+    else
+      for (jj = 0; jj < mm; jj++) oh[ii+jj] = hb[ii+jj] - ng[jj];
+  }
+} /* plan_heights */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2fila (tr 1: xy (d96tm) --> fila (etrs89))
+// ----------------------------------------------------------------------------
+static int plan_xy2fila(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                        const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  double cfi[MAXCHUNK], cla[MAXCHUNK];
+  int ii, m;
+
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    plan_xy2fila_vec(plan, m, &x[ii], &y[ii], cfi, cla, plan->iid);
+    plan_heights(plan, m, &h[ii], NULL, cfi, cla, &oh[ii]);
+    memcpy(&ox[ii], cfi, m*sizeof(double));
+    memcpy(&oy[ii], cla, m*sizeof(double));
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_xy2fila */
+
+
+// ----------------------------------------------------------------------------
+// plan_fila2xy (tr 2: fila (etrs89) --> xy (d96tm))
+// ----------------------------------------------------------------------------
+static int plan_fila2xy(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                        const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  int ii;
+
+  plan_heights(plan, n, h, NULL, x, y, oh);
+  plan_fila2xy_vec(plan, n, x, y, ox, oy, plan->oid);
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_fila2xy */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2fila_helmert (tr 3: xy (d48gk) --> fila (etrs89))
+// ----------------------------------------------------------------------------
+static int plan_xy2fila_helmert(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                                const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  double cfi[MAXCHUNK], cla[MAXCHUNK], ch[MAXCHUNK];
+  int ii, m;
+
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    plan_xy2fila_vec(plan, m, &x[ii], &y[ii], cfi, cla, plan->iid);
+    memcpy(ch, &h[ii], m*sizeof(double)); // no geoid on bessel
+    fila_ellips2fila_helmert_vec(m, cfi, cla, ch, cfi, cla, PLAN_HT(plan, ch), *plan->h7, plan->iid, plan->oid);
+    plan_heights(plan, m, &h[ii], ch, cfi, cla, &oh[ii]);
+    memcpy(&ox[ii], cfi, m*sizeof(double));
+    memcpy(&oy[ii], cla, m*sizeof(double));
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_xy2fila_helmert */
+
+
+// ----------------------------------------------------------------------------
+// plan_fila2xy_helmert (tr 4: fila (etrs89) --> xy (d48gk))
+// ----------------------------------------------------------------------------
+static int plan_fila2xy_helmert(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                                const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  double cfi[MAXCHUNK], cla[MAXCHUNK], ch[MAXCHUNK];
+  int ii, m;
+
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    fila_ellips2fila_helmert_vec(m, &x[ii], &y[ii], &h[ii], cfi, cla, PLAN_HT(plan, ch), *plan->h7, plan->iid, plan->oid);
+    plan_heights(plan, m, &h[ii], ch, &x[ii], &y[ii], ch);
+    plan_fila2xy_vec(plan, m, cfi, cla, &ox[ii], &oy[ii], plan->oid);
+    memcpy(&oh[ii], ch, m*sizeof(double));
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_fila2xy_helmert */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2xy_helmert (tr 5: xy (d48gk) --> xy (d96tm))
+// ----------------------------------------------------------------------------
+static int plan_xy2xy_helmert(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                              const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  double cfi[MAXCHUNK], cla[MAXCHUNK], ch[MAXCHUNK];
+  int ii, m;
+
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    plan_xy2fila_vec(plan, m, &x[ii], &y[ii], cfi, cla, plan->iid);
+    memcpy(ch, &h[ii], m*sizeof(double)); // no geoid on bessel
+    fila_ellips2fila_helmert_vec(m, cfi, cla, ch, cfi, cla, PLAN_HT(plan, ch), *plan->h7, plan->iid, plan->oid);
+    plan_heights(plan, m, &h[ii], ch, cfi, cla, ch);
+    plan_fila2xy_vec(plan, m, cfi, cla, &ox[ii], &oy[ii], plan->oid);
+    memcpy(&oh[ii], ch, m*sizeof(double));
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_xy2xy_helmert */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2xy_helmert_geoid (tr 6: xy (d96tm) --> xy (d48gk))
+// Input heights are always converted with geoid (h = H + Ng) before Helmert
+// ----------------------------------------------------------------------------
+static int plan_xy2xy_helmert_geoid(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                                    const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  double cfi[MAXCHUNK], cla[MAXCHUNK], ch[MAXCHUNK], hg[MAXCHUNK];
+  int ii, jj, m;
+
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    plan_xy2fila_vec(plan, m, &x[ii], &y[ii], cfi, cla, plan->iid);
+    geoid_height_vec(m, cfi, cla, hg, plan->gid);
+    for (jj = 0; jj < m; jj++) hg[jj] += h[ii+jj];
+    fila_ellips2fila_helmert_vec(m, cfi, cla, hg, cfi, cla, PLAN_HT(plan, ch), *plan->h7, plan->iid, plan->oid);
+    // input height is h + Ng here (plan->hgeoid is always 0)
+    plan_heights(plan, m, (plan->hsel == 1) ? &h[ii] : hg, ch, NULL, NULL, ch);
+    plan_fila2xy_vec(plan, m, cfi, cla, &ox[ii], &oy[ii], plan->oid);
+    memcpy(&oh[ii], ch, m*sizeof(double));
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_xy2xy_helmert_geoid */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2xy_aft (tr 7, 8: xy (d48gk) <--> xy (d96tm), affine trans.)
+// ----------------------------------------------------------------------------
+static int plan_xy2xy_aft(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                          const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  GEOUTM xy, oxy;
+  int (*aft)(GEOUTM, GEOUTM *, int *);
+  int ii, found, cnt;
+  int last_tri = (plan->hint != NULL) ? *plan->hint : -1; // shared by all points in batch
+
+  aft = (plan->tr == 7) ? gkxy2tmxy_aft : tmxy2gkxy_aft;
+  cnt = 0;
+  for (ii = 0; ii < n; ii++) {
+    xy.x = x[ii]; xy.y = y[ii]; xy.H = h[ii];
+    found = aft(xy, &oxy, &last_tri);
+    ox[ii] = oxy.x; oy[ii] = oxy.y; oh[ii] = oxy.H; // copied height
+    if (status != NULL) status[ii] = found;
+    cnt += found;
+  }
+  if (plan->hint != NULL) *plan->hint = last_tri;
+  return cnt;
+} /* plan_xy2xy_aft */
+
+
+// ----------------------------------------------------------------------------
+// plan_xy2fila_aft (tr 9: xy (d48gk) --> fila (etrs89), affine trans.)
+// ----------------------------------------------------------------------------
+static int plan_xy2fila_aft(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                            const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  GEOUTM xy, tmxy;
+  double cfi[MAXCHUNK], cla[MAXCHUNK], ch[MAXCHUNK];
+  int ii, jj, m, found, cnt;
+  int last_tri = (plan->hint != NULL) ? *plan->hint : -1; // shared by all points in batch
+
+  cnt = 0;
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    for (jj = 0; jj < m; jj++) {
+      xy.x = x[ii+jj]; xy.y = y[ii+jj]; xy.H = h[ii+jj];
+      found = gkxy2tmxy_aft(xy, &tmxy, &last_tri);
+      cfi[jj] = tmxy.x; cla[jj] = tmxy.y; ch[jj] = tmxy.H;
+      if (status != NULL) status[ii+jj] = found;
+      cnt += found;
+    }
+    plan_xy2fila_vec(plan, m, cfi, cla, &ox[ii], &oy[ii], plan->oid);
+    plan_heights(plan, m, ch, NULL, &ox[ii], &oy[ii], &oh[ii]);
+  }
+  if (plan->hint != NULL) *plan->hint = last_tri;
+  return cnt;
+} /* plan_xy2fila_aft */
+
+
+// ----------------------------------------------------------------------------
+// plan_fila2xy_aft (tr 10: fila (etrs89) --> xy (d48gk), affine trans.)
+// ----------------------------------------------------------------------------
+static int plan_fila2xy_aft(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                            const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  GEOUTM tmxy, oxy;
+  double cfi[MAXCHUNK], cla[MAXCHUNK], ch[MAXCHUNK];
+  int ii, jj, m, found, cnt;
+  int last_tri = (plan->hint != NULL) ? *plan->hint : -1; // shared by all points in batch
+
+  cnt = 0;
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    plan_fila2xy_vec(plan, m, &x[ii], &y[ii], cfi, cla, plan->iid);
+    plan_heights(plan, m, &h[ii], NULL, &x[ii], &y[ii], ch);
+    for (jj = 0; jj < m; jj++) {
+      tmxy.x = cfi[jj]; tmxy.y = cla[jj]; tmxy.H = ch[jj];
+      found = tmxy2gkxy_aft(tmxy, &oxy, &last_tri);
+      ox[ii+jj] = oxy.x; oy[ii+jj] = oxy.y; oh[ii+jj] = oxy.H;
+      if (status != NULL) status[ii+jj] = found;
+      cnt += found;
+    }
+  }
+  if (plan->hint != NULL) *plan->hint = last_tri;
+  return cnt;
+} /* plan_fila2xy_aft */
+
+
+// ----------------------------------------------------------------------------
+// plan_geoid (tr 11: fila h --> fila H, tr 12: fila H --> fila h (etrs89))
+// Only heights are converted with geoid model, fi,la are copied unchanged
+// ----------------------------------------------------------------------------
+static int plan_geoid(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                      const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  int ii;
+
+  plan_heights(plan, n, h, NULL, x, y, oh);
+  if (ox != x) memmove(ox, x, n*sizeof(double));
+  if (oy != y) memmove(oy, y, n*sizeof(double));
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_geoid */
+
+
+static int plan_cheb(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                     const double *h, double *ox, double *oy, double *oh, int *status);
+
+// ----------------------------------------------------------------------------
+// geo_plan_init
+// ----------------------------------------------------------------------------
+// Resolve transformation tr (1-12, same numbering as in gk-slo -t) and
+// settings from context ctx (output height, geoid on WGS 84 and TM series)
+// into a plan with conversion kernel and height stage.
+// ellipsoid_init() and params_init() must be called before this!
+// Returns 0 if OK or -1 if transformation is unknown.
+// ----------------------------------------------------------------------------
+int geo_plan_init(GEO_PLAN *plan, int tr, const GEO_CTX *ctx)
+{
+  int hs;
+
+  memset(plan, 0, sizeof(GEO_PLAN));
+  if (tr < 1 || tr > 12) return -1;
+
+  hs = ctx->hsel;
+  plan->nthr = (ctx->nthr > 0) ? ctx->nthr : geo_ncpu();
+  plan->tr = tr; plan->hsel = hs; plan->gid = ctx->gid_wgs; plan->tmsel = ctx->tmsel;
+  plan->ifila = (tr == 2 || tr == 4 || tr == 10 || tr >= 11);
+  plan->ofila = (tr == 1 || tr == 3 || tr == 9 || tr >= 11);
+  plan->iid = (tr == 3 || tr == 5 || tr == 7 || tr == 9) ? 0 : 1; // bessel/wgs84
+  plan->oid = (tr == 4 || tr == 6 || tr == 8 || tr == 10) ? 0 : 1;
+  plan->zones = (ctx->zsel && tr >= 3 && tr <= 6); // GK with Helmert trans.
+  plan->hsrc = GEO_HSRC_INPUT; plan->hgeoid = 0;
+
+  switch (tr) {
+    case 1: // xy (d96tm) --> fila (etrs89)
+      plan->kernel = plan_xy2fila;
+      if (hs != 1) plan->hgeoid = 1; // geoid height
+      break;
+    case 2: // fila (etrs89) --> xy (d96tm)
+      plan->kernel = plan_fila2xy;
+      if (hs != 1) plan->hgeoid = -1; // geoid height
+      break;
+    case 3: // xy (d48gk) --> fila (etrs89)
+      plan->kernel = plan_xy2fila_helmert; plan->h7 = &slo7;
+      if (hs == 2) plan->hgeoid = 1; // geoid height
+      else if (hs != 1) plan->hsrc = GEO_HSRC_TRANS; // transformed height
+      break;
+    case 4: // fila (etrs89) --> xy (d48gk)
+      plan->kernel = plan_fila2xy_helmert; plan->h7 = &slo7inv;
+      if (hs == 0) plan->hsrc = GEO_HSRC_TRANS; // transformed height
+      else if (hs != 1) plan->hgeoid = -1; // geoid height
+      break;
+    case 5: // xy (d48gk) --> xy (d96tm)
+      plan->kernel = plan_xy2xy_helmert; plan->h7 = &slo7;
+      if (hs != 1) plan->hsrc = GEO_HSRC_TRANS; // transformed height
+      if (hs != 1 && hs != 0) plan->hgeoid = -1; // geoid height
+      break;
+    case 6: // xy (d96tm) --> xy (d48gk)
+      plan->kernel = plan_xy2xy_helmert_geoid; plan->h7 = &slo7inv;
+      if (hs != 1 && hs != 2) plan->hsrc = GEO_HSRC_TRANS; // transformed height
+      break;
+    case 7: // xy (d48gk) --> xy (d96tm), affine trans.
+    case 8: // xy (d96tm) --> xy (d48gk), affine trans.
+      plan->kernel = plan_xy2xy_aft; // copied height
+      break;
+    case 9: // xy (d48gk) --> fila (etrs89), affine trans.
+      plan->kernel = plan_xy2fila_aft;
+      if (hs != 1) plan->hgeoid = 1; // geoid height
+      break;
+    case 10: // fila (etrs89) --> xy (d48gk), affine trans.
+      plan->kernel = plan_fila2xy_aft;
+      if (hs != 1) plan->hgeoid = -1; // geoid height
+      break;
+    case 11: // fila h --> fila H (etrs89), geoid only
+      plan->kernel = plan_geoid;
+      if (hs != 1) plan->hgeoid = -1; // geoid height
+      break;
+    case 12: // fila H --> fila h (etrs89), geoid only
+      plan->kernel = plan_geoid;
+      if (hs != 1) plan->hgeoid = 1; // geoid height
+      break;
+  }
+
+  // stages which can be skipped
+  if (plan->hgeoid == 0 && tr != 6) plan->skip |= GEO_SKIP_GEOID;
+  if (plan->hsrc != GEO_HSRC_TRANS) plan->skip |= GEO_SKIP_HEIGHT;
+
+  // Chebyshev approximation instead of exact kernel (not for tr 2, where
+  // vectorized TM projection is faster than the series)
+  plan->exact = plan->kernel;
+  if (ctx->csel && tr <= 6 && tr != 2 && !plan->zones && geo_cheb[tr-1].deg > 0) {
+    plan->cheb = &geo_cheb[tr-1];
+    plan->kernel = plan_cheb;
+  }
+
+  return 0;
+} /* geo_plan_init */
+
+
+// ----------------------------------------------------------------------------
+// Thread pool for batch conversions
+// ----------------------------------------------------------------------------
+// Workers are started with the first multithreaded conversion and wait for
+// next batch afterwards. Batch is split into contiguous slices (one per
+// worker), each worker converts its slice in blocks of POOL_BLOCK points with
+// its own copy of plan and its own AFT triangle hint, so there is no locking
+// while converting and outputs of different workers don't share cache lines
+// (except at slice boundaries, which are multiples of POOL_BLOCK points).
+// The pool converts one batch at a time; batches of other callers (e.g.
+// independent contexts in other threads) arriving meanwhile are converted
+// in their own threads instead of waiting for the pool.
+#define POOL_BLOCK 1024  // points converted together (6 arrays fit into L2 cache)
+#define POOL_MAXTHR 256  // max. number of threads
+
+typedef struct pool_worker {
+  pthread_t tid;
+  GEO_PLAN plan;   // copy of plan (with own hint)
+  int last_tri;    // AFT triangle hint
+  int lo, hi;      // slice of batch
+  int cnt;         // number of converted points
+  long gen;        // last batch seen by worker
+  char pad[64];    // no false sharing between workers
+} POOL_WORKER;
+
+static struct {
+  pthread_mutex_t run;   // one batch at a time (others don't wait)
+  pthread_mutex_t mutex; // protects fields below
+  pthread_cond_t start, done;
+  long gen;              // batch number
+  int active;            // number of workers still converting
+  int quit;
+  int nw;                // number of started workers (main thread is worker 0)
+  const double *x, *y, *h; double *ox, *oy, *oh; int *status; // current batch
+  POOL_WORKER w[POOL_MAXTHR];
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+           PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+
+// ----------------------------------------------------------------------------
+// geo_ncpu
+// ----------------------------------------------------------------------------
+// Returns number of online CPUs
+// ----------------------------------------------------------------------------
+int geo_ncpu()
+{
+  int n;
+#ifdef _WIN32
+  SYSTEM_INFO si;
+
+  GetSystemInfo(&si);
+  n = si.dwNumberOfProcessors;
+#else
+  n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return (n < 1) ? 1 : (n > POOL_MAXTHR) ? POOL_MAXTHR : n;
+} /* geo_ncpu */
+
+
+// ----------------------------------------------------------------------------
+// pool_slice
+// Convert slice of current batch with worker w
+// ----------------------------------------------------------------------------
+static void pool_slice(POOL_WORKER *w)
+{
+  const GEO_PLAN *plan = &w->plan;
+  int ii, m;
+
+  w->cnt = 0;
+  for (ii = w->lo; ii < w->hi; ii += m) {
+    m = (w->hi - ii < POOL_BLOCK) ? w->hi - ii : POOL_BLOCK;
+    w->cnt += plan->kernel(plan, m, &pool.x[ii], &pool.y[ii], &pool.h[ii],
+                           &pool.ox[ii], &pool.oy[ii], &pool.oh[ii],
+                           (pool.status != NULL) ? &pool.status[ii] : NULL);
+  }
+} /* pool_slice */
+
+
+// ----------------------------------------------------------------------------
+// pool_main
+// Worker thread: wait for next batch, convert its slice, report when done
+// ----------------------------------------------------------------------------
+static void *pool_main(void *arg)
+{
+  POOL_WORKER *w = (POOL_WORKER *)arg;
+
+  pthread_mutex_lock(&pool.mutex);
+  for ( ; ; ) {
+    while (pool.gen == w->gen && !pool.quit) pthread_cond_wait(&pool.start, &pool.mutex);
+    if (pool.quit) break;
+    w->gen = pool.gen;
+    pthread_mutex_unlock(&pool.mutex);
+
+    pool_slice(w);
+
+    pthread_mutex_lock(&pool.mutex);
+    if (--pool.active == 0) pthread_cond_signal(&pool.done);
+  }
+  pthread_mutex_unlock(&pool.mutex);
+  return NULL;
+} /* pool_main */
+
+
+// ----------------------------------------------------------------------------
+// pool_stop
+// Stop and join all workers (pool.run must be locked)
+// ----------------------------------------------------------------------------
+static void pool_stop()
+{
+  int ii;
+
+  pthread_mutex_lock(&pool.mutex);
+  pool.quit = 1;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.mutex);
+  for (ii = 1; ii < pool.nw; ii++) pthread_join(pool.w[ii].tid, NULL);
+  pool.quit = 0; pool.nw = 0;
+} /* pool_stop */
+
+
+// ----------------------------------------------------------------------------
+// pool_run
+// Convert batch with nt threads (see geo_plan_run() for parameters).
+// Falls back to conversion in calling thread if pool is busy with batch of
+// another caller or if threads can't be started.
+// ----------------------------------------------------------------------------
+static int pool_run(const GEO_PLAN *plan, int nt, int n, const double *x, const double *y,
+                    const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  int ii, nb, cnt;
+
+  if (pthread_mutex_trylock(&pool.run) != 0) // pool is busy, don't serialize
+    return plan->kernel(plan, n, x, y, h, ox, oy, oh, status);
+
+  // (Re)start workers if needed
+  if (pool.nw < nt) {
+    if (pool.nw > 0) pool_stop();
+    for (pool.nw = 1; pool.nw < nt; pool.nw++) {
+      pool.w[pool.nw].gen = pool.gen; // batch not started yet
+      if (pthread_create(&pool.w[pool.nw].tid, NULL, pool_main, &pool.w[pool.nw]) != 0) break;
+    }
+  }
+  if (pool.nw < 2) {
+    pthread_mutex_unlock(&pool.run);
+    return plan->kernel(plan, n, x, y, h, ox, oy, oh, status);
+  }
+
+  // Slices in multiples of POOL_BLOCK (unused workers get empty slices)
+  nt = pool.nw;
+  nb = (n + POOL_BLOCK - 1)/POOL_BLOCK;
+  for (ii = 0; ii < nt; ii++) {
+    pool.w[ii].plan = *plan;
+    pool.w[ii].last_tri = -1;
+    pool.w[ii].plan.hint = &pool.w[ii].last_tri;
+    pool.w[ii].lo = (int)((long long)nb*ii/nt)*POOL_BLOCK;
+    pool.w[ii].hi = (int)((long long)nb*(ii + 1)/nt)*POOL_BLOCK;
+    if (pool.w[ii].hi > n) pool.w[ii].hi = n;
+  }
+  pool.x = x; pool.y = y; pool.h = h;
+  pool.ox = ox; pool.oy = oy; pool.oh = oh; pool.status = status;
+
+  // Start workers, convert first slice, wait for the rest
+  pthread_mutex_lock(&pool.mutex);
+  pool.active = nt - 1; pool.gen++;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.mutex);
+
+  pool_slice(&pool.w[0]);
+
+  pthread_mutex_lock(&pool.mutex);
+  while (pool.active > 0) pthread_cond_wait(&pool.done, &pool.mutex);
+  pthread_mutex_unlock(&pool.mutex);
+
+  for (ii = 0, cnt = 0; ii < nt; ii++) cnt += pool.w[ii].cnt;
+  pthread_mutex_unlock(&pool.run);
+  return cnt;
+} /* pool_run */
+
+
+// ----------------------------------------------------------------------------
+// geo_pool_free
+// ----------------------------------------------------------------------------
+// Stop worker threads of batch conversions (they are started again when
+// needed)
+// ----------------------------------------------------------------------------
+void geo_pool_free()
+{
+  pthread_mutex_lock(&pool.run);
+  if (pool.nw > 0) pool_stop();
+  pthread_mutex_unlock(&pool.run);
+} /* geo_pool_free */
+
+
+// ----------------------------------------------------------------------------
+// geo_plan_run
+// ----------------------------------------------------------------------------
+// Convert n points stored in separate arrays (structure of arrays) with
+// previously initialized plan:
+//   x,y,h: GK/TM x,y,H or fi,la,h on ETRS89 (depends on transformation)
+//   ox,oy,oh: converted coordinates (can be the same arrays as x,y,h)
+//   status: 1 if point was converted, 0 otherwise (can be NULL)
+// Large batches are split over plan->nthr threads (not with linearization
+// cache, which is filled while converting) if the thread pool isn't busy
+// with batch of another caller.
+// Returns number of converted points.
+// ----------------------------------------------------------------------------
+int geo_plan_run(const GEO_PLAN *plan, int n, const double *x, const double *y, const double *h,
+                 double *ox, double *oy, double *oh, int *status)
+{
+  int nt;
+
+  if (n <= 0) return 0;
+  nt = (n + POOL_BLOCK - 1)/POOL_BLOCK; // at least one block per thread
+  if (nt > plan->nthr) nt = plan->nthr;
+  if (nt > 1 && plan->jac == NULL)
+    return pool_run(plan, nt, n, x, y, h, ox, oy, oh, status);
+  return plan->kernel(plan, n, x, y, h, ox, oy, oh, status);
+} /* geo_plan_run */
+
+
+// ----------------------------------------------------------------------------
+// geo_convert_batch_ctx
+// ----------------------------------------------------------------------------
+// Convert n points stored in separate arrays (structure of arrays) with
+// transformation tr (1-12, same numbering as in gk-slo -t), using settings
+// from context ctx (see geo_plan_run() for parameters).
+// Returns number of converted points or -1 if transformation is unknown.
+// ----------------------------------------------------------------------------
+int geo_convert_batch_ctx(const GEO_CTX *ctx, int tr, int n, const double *x, const double *y,
+                          const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  GEO_PLAN plan;
+
+  if (geo_plan_init(&plan, tr, ctx) != 0) return -1;
+  return geo_plan_run(&plan, n, x, y, h, ox, oy, oh, status);
+} /* geo_convert_batch_ctx */
+
+
+// ----------------------------------------------------------------------------
+// geo_convert_batch
+// ----------------------------------------------------------------------------
+// Convert n points stored in separate arrays (structure of arrays) with
+// transformation tr (1-12, same numbering as in gk-slo -t), using current
+// hsel, gid_wgs and tmsel (see geo_plan_run() for parameters).
+// Returns number of converted points or -1 if transformation is unknown.
+// ----------------------------------------------------------------------------
+int geo_convert_batch(int tr, int n, const double *x, const double *y, const double *h,
+                      double *ox, double *oy, double *oh, int *status)
+{
+  return geo_convert_batch_ctx(geo_ctx_default(), tr, n, x, y, h, ox, oy, oh, status);
+} /* geo_convert_batch */
+
+
+// ----------------------------------------------------------------------------
+// geo_geoid_batch
+// ----------------------------------------------------------------------------
+// Convert n heights at fi,la (ETRS89) between ellipsoidal height h and
+// orthometric height H with geoid model gid only (no projection or Helmert
+// transformation, same as tr 11 and 12 without copying fi,la):
+//   dir < 0: oh = h - Ng (h --> H), dir > 0: oh = H + Ng (H --> h)
+// oh can be the same array as h.
+// Returns number of converted points.
+// ----------------------------------------------------------------------------
+int geo_geoid_batch(int gid, int dir, int n, const double *fi, const double *la,
+                    const double *h, double *oh)
+{
+  double ng[MAXCHUNK];
+  int ii, jj, m;
+
+  if (gid < 0 || gid > 2) return 0;
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    geoid_height_vec(m, &fi[ii], &la[ii], ng, gid);
+    if (dir < 0)
+      for (jj = 0; jj < m; jj++) oh[ii+jj] = h[ii+jj] - ng[jj];
+    else
+      for (jj = 0; jj < m; jj++) oh[ii+jj] = h[ii+jj] + ng[jj];
+  }
+  return (n > 0) ? n : 0;
+} /* geo_geoid_batch */
+
+
+// ----------------------------------------------------------------------------
+// geo_plan_inverse
+// ----------------------------------------------------------------------------
+// Initialize plan inv with exact inverse transformation of plan (1<->2, 3<->4,
+// ..., 11<->12), using settings from context ctx (approximations are not used).
+// Returns 0 if OK or -1 if transformation is unknown.
+// ----------------------------------------------------------------------------
+int geo_plan_inverse(GEO_PLAN *inv, const GEO_PLAN *plan, const GEO_CTX *ctx)
+{
+  GEO_CTX ictx;
+
+  ictx = *ctx; ictx.csel = 0; // exact conversion
+  return geo_plan_init(inv, (plan->tr & 1) ? plan->tr + 1 : plan->tr - 1, &ictx);
+} /* geo_plan_inverse */
+
+
+// ----------------------------------------------------------------------------
+// geo_plan_check
+// ----------------------------------------------------------------------------
+// Round-trip verification of n converted points: convert ox,oy,oh back with
+// inverse plan inv (see geo_plan_inverse()) and compare with original input
+// x,y. Horizontal deviation is computed in m (fi,la are converted with radius
+// of output ellipsoid of inv). Heights are not compared, because height
+// calculation isn't symmetric in all transformations (see hsel).
+// maxerr is updated with maximum deviation.
+// Returns number of points with deviation above tol.
+// ----------------------------------------------------------------------------
+int geo_plan_check(const GEO_PLAN *inv, int n, const double *x, const double *y,
+                   const double *ox, const double *oy, const double *oh,
+                   double tol, double *maxerr)
+{
+  double rx[MAXCHUNK], ry[MAXCHUNK], rh[MAXCHUNK];
+  int st[MAXCHUNK];
+  double dx, dy, d, r;
+  int ii, jj, nc, nbad;
+
+  r = ellips[inv->oid].a*PI/180.0; // m per degree
+  nbad = 0;
+  for (ii = 0; ii < n; ii += nc) {
+    nc = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    geo_plan_run(inv, nc, &ox[ii], &oy[ii], &oh[ii], rx, ry, rh, st);
+    for (jj = 0; jj < nc; jj++) {
+      if (!st[jj]) continue; // outside of transformation area
+      dx = rx[jj] - x[ii+jj]; dy = ry[jj] - y[ii+jj];
+      if (inv->ofila) { dx *= r; dy *= r*cos(x[ii+jj]*PI/180.0); }
+      d = sqrt(dx*dx + dy*dy);
+      if (d > *maxerr) *maxerr = d;
+      if (d > tol) nbad++;
+    }
+  }
+
+  return nbad;
+} /* geo_plan_check */
+
+
+// ----------------------------------------------------------------------------
+// Interpolation grid
+// ----------------------------------------------------------------------------
+// Values per node (only the first nc values are used, depending on tr):
+//   GV_X, GV_Y: output x,y or fi,la at input height 0 (tr 1-6)
+//   GV_H: transformed height at input height 0 (tr 3-6)
+//   GV_DX, GV_DY, GV_DH: derivatives of above by input height (tr 3-6)
+//   GV_GFI, GV_GLA: fi,la on WGS 84 for geoid height (tr 5-6)
+// Input height is the height entering Helmert transformation (H + Ng for
+// tr 6), so values at nodes are smooth functions of input coordinates.
+#define GV_X   0
+#define GV_Y   1
+#define GV_H   2
+#define GV_DX  3
+#define GV_DY  4
+#define GV_DH  5
+#define GV_GFI 6
+#define GV_GLA 7
+#define GV_MAX 8
+
+#define GRID_MAXNODES 4000000 // max. number of grid nodes
+#define GRID_HREF 2000.0      // secant in the middle of heights in Slovenia
+
+
+// ----------------------------------------------------------------------------
+// grid_nc
+// Number of values needed for transformation tr (1-6)
+// ----------------------------------------------------------------------------
+static int grid_nc(int tr)
+{
+  return (tr <= 2) ? GV_H : (tr <= 4) ? GV_GFI : GV_MAX;
+} /* grid_nc */
+
+
+// ----------------------------------------------------------------------------
+// grid_exact
+// Exact values v[GV_*] at input point x,y and input height hin
+// (same conversion steps as in scalar routines, see gkxy2tmxy_ctx)
+// ----------------------------------------------------------------------------
+static void grid_exact(const GEO_PLAN *plan, double x, double y, double hin, double *v)
+{
+  double fi, la, X, Y, Z, oX, oY, oZ;
+  int tms = plan->tmsel;
+
+  switch (plan->tr) {
+    case 1: // xy (d96tm) --> fila (etrs89)
+      proj_xy2fila(tms, x, y, &fi, &la, plan->iid);
+      v[GV_X] = fi*180.0/PI; v[GV_Y] = la*180.0/PI;
+      break;
+    case 2: // fila (etrs89) --> xy (d96tm)
+      proj_fila2xy(tms, x*PI/180.0, y*PI/180.0, &v[GV_X], &v[GV_Y], plan->oid);
+      break;
+    case 3: // xy (d48gk) --> fila (etrs89)
+    case 5: // xy (d48gk) --> xy (d96tm)
+    case 6: // xy (d96tm) --> xy (d48gk)
+      proj_xy2fila(tms, x, y, &fi, &la, plan->iid);
+      if (plan->tr == 6) { v[GV_GFI] = fi*180.0/PI; v[GV_GLA] = la*180.0/PI; }
+      fila2xyz_rad(fi, la, hin, &X, &Y, &Z, plan->iid);
+      xyz2xyz_h7(X, Y, Z, &oX, &oY, &oZ, plan->h7);
+      xyz2fila_rad(oX, oY, oZ, &fi, &la, &v[GV_H], plan->oid);
+      if (plan->tr == 5) { v[GV_GFI] = fi*180.0/PI; v[GV_GLA] = la*180.0/PI; }
+      if (plan->tr == 3) { v[GV_X] = fi*180.0/PI; v[GV_Y] = la*180.0/PI; }
+      else proj_fila2xy(tms, fi, la, &v[GV_X], &v[GV_Y], plan->oid);
+      break;
+    case 4: // fila (etrs89) --> xy (d48gk)
+      fila2xyz_rad(x*PI/180.0, y*PI/180.0, hin, &X, &Y, &Z, plan->iid);
+      xyz2xyz_h7(X, Y, Z, &oX, &oY, &oZ, plan->h7);
+      xyz2fila_rad(oX, oY, oZ, &fi, &la, &v[GV_H], plan->oid);
+      proj_fila2xy(tms, fi, la, &v[GV_X], &v[GV_Y], plan->oid);
+      break;
+  }
+} /* grid_exact */
+
+
+// ----------------------------------------------------------------------------
+// grid_node
+// First nc values at input point x,y (with derivatives by height, taken as
+// secant between input heights 0 and href)
+// ----------------------------------------------------------------------------
+static void grid_node(const GEO_PLAN *plan, int nc, double href, double x, double y, double *v)
+{
+  double v1[GV_MAX];
+
+  grid_exact(plan, x, y, 0.0, v);
+  if (nc > GV_H) {
+    grid_exact(plan, x, y, href, v1);
+    v[GV_DX] = (v1[GV_X] - v[GV_X])/href;
+    v[GV_DY] = (v1[GV_Y] - v[GV_Y])/href;
+    v[GV_DH] = (v1[GV_H] - v[GV_H])/href;
+  }
+} /* grid_node */
+
+
+// ----------------------------------------------------------------------------
+// grid_interp
+// Interpolate values at input point x,y from 4x4 surrounding nodes
+// (bicubic Lagrange interpolation). Returns 0 if point is outside grid.
+// ----------------------------------------------------------------------------
+static int grid_interp(const GEO_GRID *grid, double x, double y, double *v)
+{
+  double t, s, wx[4], wy[4], r;
+  const double *p;
+  int ix, iy, jj, kk, nc = grid->nc;
+
+  t = (x - grid->x0)*grid->rdx; s = (y - grid->y0)*grid->rdy;
+  if (!(t >= 1.0 && s >= 1.0)) return 0; // also NaN
+  ix = (int)t; t -= ix; iy = (int)s; s -= iy;
+  if (ix > grid->nx - 3 || iy > grid->ny - 3) return 0;
+
+  // Lagrange weights for nodes -1, 0, 1, 2 (without divisions)
+  r = t*(t - 1.0);
+  wx[0] = -r*(t - 2.0)*(1.0/6.0); wx[3] = r*(t + 1.0)*(1.0/6.0);
+  r = (t + 1.0)*(t - 2.0);
+  wx[1] = r*(t - 1.0)*0.5; wx[2] = -r*t*0.5;
+  r = s*(s - 1.0);
+  wy[0] = -r*(s - 2.0)*(1.0/6.0); wy[3] = r*(s + 1.0)*(1.0/6.0);
+  r = (s + 1.0)*(s - 2.0);
+  wy[1] = r*(s - 1.0)*0.5; wy[2] = -r*s*0.5;
+
+  for (kk = 0; kk < nc; kk++) v[kk] = 0.0;
+  for (jj = 0; jj < 4; jj++) {
+    p = &grid->val[((iy - 1 + jj)*grid->nx + ix - 1)*nc];
+    for (kk = 0; kk < nc; kk++, p++)
+      v[kk] += wy[jj]*(wx[0]*p[0] + wx[1]*p[nc] + wx[2]*p[2*nc] + wx[3]*p[3*nc]);
+  }
+  return 1;
+} /* grid_interp */
+
+
+// ----------------------------------------------------------------------------
+// grid_dist
+// Distance in m between exact values ve at input height hin and first nc
+// values vi interpolated from grid (horizontal position and transformed height)
+// ----------------------------------------------------------------------------
+static double grid_dist(const GEO_PLAN *plan, int nc, const double *ve, const double *vi,
+                        double hin)
+{
+  double d1, d2, dh, m;
+
+  d1 = ve[GV_X] - vi[GV_X]; d2 = ve[GV_Y] - vi[GV_Y]; dh = 0.0;
+  if (nc > GV_H) {
+    d1 -= hin*vi[GV_DX];
+    d2 -= hin*vi[GV_DY];
+    dh = fabs(ve[GV_H] - vi[GV_H] - hin*vi[GV_DH]);
+  }
+  if (plan->ofila) { // degrees to m (approx.)
+    m = PI/180.0*ellips[1].a;
+    d1 *= m; d2 *= m*cos(ve[GV_X]*PI/180.0);
+  }
+  m = sqrt(d1*d1 + d2*d2);
+  if (nc > GV_GFI) { // position of geoid height (in degrees)
+    d1 = ve[GV_GFI] - vi[GV_GFI]; d2 = ve[GV_GLA] - vi[GV_GLA];
+    dh = xfmax(dh, 0.001*PI/180.0*ellips[1].a*sqrt(d1*d1 + d2*d2)); // geoid slope < 1 mm/m
+  }
+  return xfmax(m, dh);
+} /* grid_dist */
+
+
+// ----------------------------------------------------------------------------
+// grid_build
+// Sample nodes with spacing dx,dy over input area xmin..xmax, ymin..ymax
+// and measure max. deviation from exact conversion in the middle of cells
+// and on cell edges (at input heights 0, 1000 and 3000 m).
+// Returns 0 if OK or -1 if memory can't be allocated.
+// ----------------------------------------------------------------------------
+static int grid_build(GEO_GRID *grid, double xmin, double xmax, double ymin, double ymax,
+                      double dx, double dy)
+{
+  double ve[GV_MAX], vi[GV_MAX], x, y, d;
+  int ix, iy, kk, ll;
+  static const double th[3] = {0.0, 1000.0, 3000.0}; // test heights
+  static const double tc[3][2] = {{0.5, 0.5}, {0.5, 0.0}, {0.0, 0.5}}; // test points in cell
+
+  free(grid->val);
+  grid->dx = dx; grid->dy = dy;
+  grid->rdx = 1.0/dx; grid->rdy = 1.0/dy;
+  grid->x0 = xmin - dx; grid->y0 = ymin - dy;
+  grid->nx = (int)ceil((xmax - xmin)/dx) + 3;
+  grid->ny = (int)ceil((ymax - ymin)/dy) + 3;
+  grid->val = (double *)malloc((size_t)grid->nx*grid->ny*grid->nc*sizeof(double));
+  if (grid->val == NULL) return -1;
+
+  for (iy = 0; iy < grid->ny; iy++)
+    for (ix = 0; ix < grid->nx; ix++) {
+      grid_node(&grid->plan, grid->nc, grid->href, grid->x0 + ix*dx, grid->y0 + iy*dy, ve);
+      memcpy(&grid->val[(iy*grid->nx + ix)*grid->nc], ve, grid->nc*sizeof(double));
+    }
+
+  // Deviation in all cells used for interpolation
+  grid->maxerr = 0.0;
+  for (iy = 1; iy <= grid->ny - 3; iy++)
+    for (ix = 1; ix <= grid->nx - 3; ix++)
+      for (kk = 0; kk < 3; kk++) {
+        x = grid->x0 + (ix + tc[kk][0])*dx;
+        y = grid->y0 + (iy + tc[kk][1])*dy;
+        if (!grid_interp(grid, x, y, vi)) continue; // on grid border
+        for (ll = 0; ll < 3; ll++) {
+          grid_exact(&grid->plan, x, y, th[ll], ve);
+          d = grid_dist(&grid->plan, grid->nc, ve, vi, th[ll]);
+          if (d > grid->maxerr) grid->maxerr = d;
+          if (grid->nc <= GV_H) break; // no height dependence
+        }
+      }
+  return 0;
+} /* grid_build */
+
+
+// ----------------------------------------------------------------------------
+// grid_bbox
+// Extend bounding box with point fi,la (in degrees) projected on input
+// ellipsoid of plan
+// ----------------------------------------------------------------------------
+static void grid_bbox(const GEO_PLAN *plan, double fi, double la,
+                      double *xmin, double *xmax, double *ymin, double *ymax)
+{
+  double x, y;
+
+  proj_fila2xy(plan->tmsel, fi*PI/180.0, la*PI/180.0, &x, &y, plan->iid);
+  if (x < *xmin) *xmin = x;
+  if (x > *xmax) *xmax = x;
+  if (y < *ymin) *ymin = y;
+  if (y > *ymax) *ymax = y;
+} /* grid_bbox */
+
+
+// ----------------------------------------------------------------------------
+// grid_area
+// Input area of plan covering the area of geoid model plan->gid
+// ----------------------------------------------------------------------------
+static void grid_area(const GEO_PLAN *plan, double *xmin, double *xmax, double *ymin, double *ymax)
+{
+  const GEO_GEOID *g;
+  double fimin, fimax, lamin, lamax, t;
+  int ii;
+
+  g = &geoids[plan->gid];
+  if (g->val != NULL) {
+    fimin = g->fimin; fimax = g->fimax; lamin = g->lamin; lamax = g->lamax;
+  } else { // no geoid model, use default area
+    fimin = gfimin; fimax = gfimax; lamin = glamin; lamax = glamax;
+  }
+  if (plan->ifila) {
+    *xmin = fimin; *xmax = fimax; *ymin = lamin; *ymax = lamax;
+    return;
+  }
+  // projected border of geoid model area
+  *xmin = *ymin = 1e30; *xmax = *ymax = -1e30;
+  for (ii = 0; ii <= 100; ii++) {
+    t = ii/100.0;
+    grid_bbox(plan, fimin, lamin + t*(lamax - lamin), xmin, xmax, ymin, ymax);
+    grid_bbox(plan, fimax, lamin + t*(lamax - lamin), xmin, xmax, ymin, ymax);
+    grid_bbox(plan, fimin + t*(fimax - fimin), lamin, xmin, xmax, ymin, ymax);
+    grid_bbox(plan, fimin + t*(fimax - fimin), lamax, xmin, xmax, ymin, ymax);
+  }
+} /* grid_area */
+
+
+// ----------------------------------------------------------------------------
+// grid_output
+// Output coordinates of input point x,y,H from first nc interpolated values v
+// (height derivatives applied, geoid height calculated exactly)
+// ----------------------------------------------------------------------------
+static void grid_output(const GEO_PLAN *plan, int nc, double *v, double x, double y, double H,
+                        double *ox, double *oy, double *oh)
+{
+  double hin, hg, ht, gfi, gla;
+  int tr = plan->tr;
+
+  // Input height for Helmert transformation
+  hin = H; hg = H;
+  if (tr == 6) hin = hg = H + geoid_height(v[GV_GFI], v[GV_GLA], plan->gid);
+  ht = 0.0;
+  if (nc > GV_H) {
+    v[GV_X] += hin*v[GV_DX];
+    v[GV_Y] += hin*v[GV_DY];
+    ht = v[GV_H] + hin*v[GV_DH];
+  }
+
+  // Output height (see plan_heights)
+  if (plan->hsrc == GEO_HSRC_TRANS) H = ht;
+  else if (tr == 6 && plan->hsel != 1) H = hg;
+  if (plan->hgeoid != 0) {
+    if (plan->ifila) { gfi = x; gla = y; }                  // tr 2, 4
+    else if (tr == 5) { gfi = v[GV_GFI]; gla = v[GV_GLA]; }
+    else { gfi = v[GV_X]; gla = v[GV_Y]; }                  // tr 1, 3
+    H += plan->hgeoid*geoid_height(gfi, gla, plan->gid);
+  }
+  *ox = v[GV_X]; *oy = v[GV_Y]; *oh = H;
+} /* grid_output */
+
+
+// ----------------------------------------------------------------------------
+// plan_grid (tr 1-6 interpolated from grid)
+// Points outside grid are converted with exact plan
+// ----------------------------------------------------------------------------
+static int plan_grid(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                     const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  const GEO_GRID *grid = plan->grid;
+  double v[GV_MAX];
+  int ii;
+
+  for (ii = 0; ii < n; ii++) {
+    if (!grid_interp(grid, x[ii], y[ii], v)) {
+      grid->plan.kernel(&grid->plan, 1, &x[ii], &y[ii], &h[ii], &ox[ii], &oy[ii], &oh[ii], NULL);
+      continue;
+    }
+    grid_output(plan, grid->nc, v, x[ii], y[ii], h[ii], &ox[ii], &oy[ii], &oh[ii]);
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_grid */
+
+
+// ----------------------------------------------------------------------------
+// geo_grid_init
+// ----------------------------------------------------------------------------
+// Build interpolation grid for plan (tr 1-6) over the area of geoid model
+// with node spacing halved until max. deviation from exact conversion is
+// below tol (in m). Deviation is sampled (in cell centres and edge middles
+// at heights 0, 1000 and 3000 m), so it is not a strict bound for all
+// points. If successful, plan is switched to interpolation from grid (grid
+// must not be freed while plan is in use).
+// Returns 0 if OK, -1 if transformation is not supported (affine trans.),
+// -2 if memory can't be allocated or tol can't be reached.
+// ----------------------------------------------------------------------------
+int geo_grid_init(GEO_GRID *grid, GEO_PLAN *plan, double tol)
+{
+  double xmin, xmax, ymin, ymax, dx, dy, err;
+
+  memset(grid, 0, sizeof(GEO_GRID));
+  if (plan->tr < 1 || plan->tr > 6 || plan->zones || tol <= 0.0) return -1;
+  grid->plan = *plan; grid->plan.grid = NULL;
+  grid->nc = grid_nc(plan->tr);
+  grid->href = GRID_HREF;
+
+  // Input area (area of geoid model)
+  grid_area(plan, &xmin, &xmax, &ymin, &ymax);
+  if (plan->ifila) { dx = 0.05; dy = 0.05; }
+  else { dx = 5000.0; dy = 5000.0; }
+
+  for (err = -1.0; ; ) {
+    if ((xmax - xmin)/dx*(ymax - ymin)/dy > GRID_MAXNODES) break;
+    if (grid_build(grid, xmin, xmax, ymin, ymax, dx, dy) != 0) break;
+    if (grid->maxerr <= tol) {
+      plan->grid = grid;
+      plan->kernel = plan_grid;
+      return 0;
+    }
+    // stop if error doesn't decrease anymore (limited by height model)
+    if (err >= 0.0 && grid->maxerr > err/2.0) break;
+    err = grid->maxerr;
+    dx /= 2.0; dy /= 2.0;
+  }
+  geo_grid_free(grid);
+  return -2;
+} /* geo_grid_init */
+
+
+// ----------------------------------------------------------------------------
+// geo_grid_free
+// ----------------------------------------------------------------------------
+// Free memory of interpolation grid
+// ----------------------------------------------------------------------------
+void geo_grid_free(GEO_GRID *grid)
+{
+  free(grid->val);
+  grid->val = NULL;
+} /* geo_grid_free */
+
+
+// ----------------------------------------------------------------------------
+// Linearization cache
+// ----------------------------------------------------------------------------
+// Input area is divided into square cells. When the first point falls into a
+// cell, exact values (see GV_*) and their derivatives by x and y (secants
+// through the middles of cell edges) are calculated in cell centre and the
+// linear map is checked against exact conversion in cell corners, where its
+// deviation is the largest. Points in cells which pass the check are
+// converted with the linear map, others with exact conversion.
+#define JAC_CELL 50.0  // default cell size in m
+#define JAC_DIM  64    // cache entries per axis (power of 2, 64x64 cells)
+
+
+// ----------------------------------------------------------------------------
+// jac_cell
+// Calculate linear map of cell ix,iy and check its deviation
+// ----------------------------------------------------------------------------
+static void jac_cell(GEO_JAC *jac, GEO_JAC_CELL *c, int ix, int iy)
+{
+  double v0[GV_MAX], v1[GV_MAX], ve[GV_MAX], vi[GV_MAX], x, y, s, d, err;
+  int ii, kk, ll, nc = jac->nc;
+  static const double th[3] = {0.0, 1000.0, 3000.0}; // test heights
+
+  c->ix = ix; c->iy = iy;
+  s = 0.5*jac->cell;
+  c->xc = (ix + 0.5)*jac->cell; c->yc = (iy + 0.5)*jac->cell;
+  grid_node(&jac->plan, nc, GRID_HREF, c->xc, c->yc, c->v);
+  grid_node(&jac->plan, nc, GRID_HREF, c->xc - s, c->yc, v0);
+  grid_node(&jac->plan, nc, GRID_HREF, c->xc + s, c->yc, v1);
+  for (kk = 0; kk < nc; kk++) c->jx[kk] = (v1[kk] - v0[kk])*jac->rcell;
+  grid_node(&jac->plan, nc, GRID_HREF, c->xc, c->yc - s, v0);
+  grid_node(&jac->plan, nc, GRID_HREF, c->xc, c->yc + s, v1);
+  for (kk = 0; kk < nc; kk++) c->jy[kk] = (v1[kk] - v0[kk])*jac->rcell;
+
+  // Deviation in cell corners
+  err = 0.0;
+  for (ii = 0; ii < 4; ii++) {
+    x = (ii & 1) ? s : -s; y = (ii & 2) ? s : -s;
+    for (kk = 0; kk < nc; kk++) vi[kk] = c->v[kk] + x*c->jx[kk] + y*c->jy[kk];
+    for (ll = 0; ll < 3; ll++) {
+      grid_exact(&jac->plan, c->xc + x, c->yc + y, th[ll], ve);
+      d = grid_dist(&jac->plan, nc, ve, vi, th[ll]);
+      if (!(d <= err)) err = d; // also NaN
+      if (nc <= GV_H) break; // no height dependence
+    }
+  }
+  c->state = (err <= jac->tol) ? 1 : -1;
+  if (err > jac->maxerr && c->state > 0) jac->maxerr = err;
+} /* jac_cell */
+
+
+// ----------------------------------------------------------------------------
+// plan_jac (tr 1-6 with linear map of cell)
+// Points in cells failing deviation check are converted with exact plan
+// ----------------------------------------------------------------------------
+static int plan_jac(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                    const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  GEO_JAC *jac = plan->jac;
+  GEO_JAC_CELL *c;
+  double v[GV_MAX], fx, fy, dx, dy;
+  int ii, jj, kk, ix, iy, nc = jac->nc;
+
+  for (ii = 0, jj = 0; ii < n; ii++) { // jj: first point of exact run
+    fx = floor(x[ii]*jac->rcell); fy = floor(y[ii]*jac->rcell);
+    if (!(fabs(fx) < 1e9 && fabs(fy) < 1e9)) continue; // also NaN
+    ix = (int)fx; iy = (int)fy;
+    c = &jac->cells[(iy & (JAC_DIM - 1))*JAC_DIM + (ix & (JAC_DIM - 1))];
+    if (c->state == 0 || c->ix != ix || c->iy != iy) jac_cell(jac, c, ix, iy);
+    if (c->state < 0) continue;
+
+    // Convert run of points in failed cells at once
+    if (jj < ii) jac->plan.kernel(&jac->plan, ii - jj, &x[jj], &y[jj], &h[jj],
+                                  &ox[jj], &oy[jj], &oh[jj], NULL);
+    jac->nexact += ii - jj; jj = ii + 1;
+
+    dx = x[ii] - c->xc; dy = y[ii] - c->yc;
+    for (kk = 0; kk < nc; kk++) v[kk] = c->v[kk] + dx*c->jx[kk] + dy*c->jy[kk];
+    grid_output(plan, nc, v, x[ii], y[ii], h[ii], &ox[ii], &oy[ii], &oh[ii]);
+    jac->nlin++;
+  }
+  if (jj < n) jac->plan.kernel(&jac->plan, n - jj, &x[jj], &y[jj], &h[jj],
+                               &ox[jj], &oy[jj], &oh[jj], NULL);
+  jac->nexact += n - jj;
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_jac */
+
+
+// ----------------------------------------------------------------------------
+// geo_jac_init
+// ----------------------------------------------------------------------------
+// Initialize linearization cache for plan (tr 1-6) with cell size cell
+// (in m, 0: default 50 m) and max. deviation tol (in m) from exact
+// conversion. If successful, plan is switched to conversion with linear maps
+// of cells. Cache is filled while converting, so plan must not be shared
+// between threads and cache must not be freed while plan is in use.
+// Returns 0 if OK, -1 if transformation is not supported (affine trans.),
+// -2 if memory can't be allocated.
+// ----------------------------------------------------------------------------
+int geo_jac_init(GEO_JAC *jac, GEO_PLAN *plan, double tol, double cell)
+{
+  memset(jac, 0, sizeof(GEO_JAC));
+  if (plan->tr < 1 || plan->tr > 6 || plan->zones || tol <= 0.0) return -1;
+  jac->plan = *plan; jac->plan.jac = NULL;
+  jac->nc = grid_nc(plan->tr);
+  jac->tol = tol;
+  jac->cell = (cell > 0.0) ? cell : JAC_CELL;
+  if (plan->ifila) jac->cell /= PI/180.0*ellips[1].a; // m to degrees (approx.)
+  jac->rcell = 1.0/jac->cell;
+  jac->cells = (GEO_JAC_CELL *)calloc(JAC_DIM*JAC_DIM, sizeof(GEO_JAC_CELL));
+  if (jac->cells == NULL) return -2;
+  plan->jac = jac;
+  plan->kernel = plan_jac;
+  return 0;
+} /* geo_jac_init */
+
+
+// ----------------------------------------------------------------------------
+// geo_jac_free
+// ----------------------------------------------------------------------------
+// Free memory of linearization cache
+// ----------------------------------------------------------------------------
+void geo_jac_free(GEO_JAC *jac)
+{
+  free(jac->cells);
+  jac->cells = NULL;
+} /* geo_jac_free */
+
+
+// ----------------------------------------------------------------------------
+// Chebyshev approximation
+// ----------------------------------------------------------------------------
+// Values (see GV_*) are approximated over the input area of geoid model with
+// sums of c_ij*T_i(u)*T_j(v) (i+j <= deg), where u,v are input coordinates
+// scaled to -1..1. Coefficients are fitted offline (see gk-slo -gc) and
+// stored in geo_cheb.h, so conversion needs only polynomial evaluation and
+// geoid height lookup. Terms are ordered by total degree i+j, so values
+// which need less accuracy (height derivatives, position of geoid height)
+// use only the first terms.
+#define CHEB_NODES 48 // number of fitting nodes per axis
+#define CHEB_TEST 100 // number of test grid intervals per axis
+#define CHEB_SLACK 0.000001 // allowed growth of deviation when degree is lowered (in m)
+
+
+// ----------------------------------------------------------------------------
+// cheb_nodes
+// Values of T_i (i <= deg) in m Chebyshev nodes: tc[i*m + k]
+// ----------------------------------------------------------------------------
+static void cheb_nodes(int deg, int m, double *tc)
+{
+  int ii, kk;
+
+  for (ii = 0; ii <= deg; ii++)
+    for (kk = 0; kk < m; kk++) tc[ii*m + kk] = cos(ii*PI*(kk + 0.5)/m);
+} /* cheb_nodes */
+
+
+// ----------------------------------------------------------------------------
+// cheb_coef
+// Coefficients c[value][term] of total degree deg for first nc values f
+// sampled in m x m Chebyshev nodes (f[(k*m + l)*GV_MAX + value], T_i in nodes
+// from cheb_nodes), using discrete orthogonality of T_i in Chebyshev nodes.
+// Terms T_i(u)*T_l(v) are ordered by total degree i+l, then by i.
+// ----------------------------------------------------------------------------
+static void cheb_coef(int nc, int deg, int m, const double *tc, const double *f,
+                      double (*c)[GEO_CHEB_NCOEF])
+{
+  double s;
+  int ii, jj, kk, ll, mm, dd;
+
+  for (mm = 0; mm < nc; mm++) {
+    jj = 0;
+    for (dd = 0; dd <= deg; dd++)
+      for (ii = 0; ii <= dd; ii++, jj++) {
+        ll = dd - ii; s = 0.0;
+        for (kk = 0; kk < m*m; kk++)
+          s += f[kk*GV_MAX + mm]*tc[ii*m + kk/m]*tc[ll*m + kk%m];
+        c[mm][jj] = s*(ii ? 2.0 : 1.0)*(ll ? 2.0 : 1.0)/((double)m*m);
+      }
+  }
+} /* cheb_coef */
+
+
+// ----------------------------------------------------------------------------
+// plan_cheb (tr 1-6 with Chebyshev approximation)
+// Only values needed by plan are evaluated (vectorized, see cheb_vec), then
+// height derivatives and geoid heights are applied to whole chunk like in
+// exact kernels. Points outside approximation area are converted with exact
+// kernel.
+// ----------------------------------------------------------------------------
+static int plan_cheb(const GEO_PLAN *plan, int n, const double *x, const double *y,
+                     const double *h, double *ox, double *oy, double *oh, int *status)
+{
+  const GEO_CHEB *ch = plan->cheb;
+  double u[MAXCHUNK], w[MAXCHUNK], v[GV_MAX*MAXCHUNK], hg[MAXCHUNK], ch2[MAXCHUNK];
+  double *vx, *vy, *ht;
+  const double *hin, *gfi, *gla;
+  unsigned mask;
+  int ii, jj, m, nout, tr = plan->tr;
+
+  // Values needed for output (no transformed height if it isn't output,
+  // no position of geoid height if it isn't used)
+  mask = (1u << GV_X) | (1u << GV_Y);
+  if (ch->nc > GV_H) {
+    mask |= (1u << GV_DX) | (1u << GV_DY);
+    if (plan->hsrc == GEO_HSRC_TRANS) mask |= (1u << GV_H) | (1u << GV_DH);
+  }
+  if (tr == 6 || (tr == 5 && plan->hgeoid != 0)) mask |= (1u << GV_GFI) | (1u << GV_GLA);
+
+  for (ii = 0; ii < n; ii += m) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    nout = 0;
+    for (jj = 0; jj < m; jj++) {
+      u[jj] = (x[ii+jj] - ch->x0)*ch->sx; w[jj] = (y[ii+jj] - ch->y0)*ch->sy;
+      if (!(fabs(u[jj]) <= 1.0 && fabs(w[jj]) <= 1.0)) nout++; // also NaN
+    }
+    cheb_vec(ch, mask, m, u, w, v);
+    vx = &v[GV_X*m]; vy = &v[GV_Y*m];
+    ht = (mask & (1u << GV_H)) ? &v[GV_H*m] : NULL;
+
+    // Input height for Helmert transformation (H + Ng for tr 6)
+    hin = &h[ii];
+    if (tr == 6) {
+      geoid_height_vec(m, &v[GV_GFI*m], &v[GV_GLA*m], hg, plan->gid);
+      for (jj = 0; jj < m; jj++) hg[jj] += h[ii+jj];
+      hin = hg;
+    }
+    if (ch->nc > GV_H) {
+      for (jj = 0; jj < m; jj++) {
+        vx[jj] += hin[jj]*v[GV_DX*m + jj];
+        vy[jj] += hin[jj]*v[GV_DY*m + jj];
+      }
+      if (ht != NULL)
+        for (jj = 0; jj < m; jj++) ht[jj] += hin[jj]*v[GV_DH*m + jj];
+    }
+
+    // Output height (geoid height at input fi,la for tr 2, 4)
+    if (plan->ifila) { gfi = &x[ii]; gla = &y[ii]; }
+    else if (tr == 5) { gfi = &v[GV_GFI*m]; gla = &v[GV_GLA*m]; }
+    else { gfi = vx; gla = vy; }
+    plan_heights(plan, m, (tr == 6 && plan->hsel != 1) ? hg : &h[ii], ht, gfi, gla, ch2);
+
+    for (jj = 0; jj < m; jj++) {
+      if (nout > 0 && !(fabs(u[jj]) <= 1.0 && fabs(w[jj]) <= 1.0)) {
+        plan->exact(plan, 1, &x[ii+jj], &y[ii+jj], &h[ii+jj], &ox[ii+jj], &oy[ii+jj],
+                    &oh[ii+jj], NULL);
+        continue;
+      }
+      ox[ii+jj] = vx[jj]; oy[ii+jj] = vy[jj]; oh[ii+jj] = ch2[jj];
+    }
+  }
+  if (status != NULL) for (ii = 0; ii < n; ii++) status[ii] = 1;
+  return n;
+} /* plan_cheb */
+
+
+// ----------------------------------------------------------------------------
+// cheb_dev
+// Max. deviation of approximation ch from exact values ve[((k*(CHEB_TEST+1)
+// + l)*3 + height)*GV_MAX] on regular grid of test points over area
+// xmin..xmax, ymin..ymax (at input heights 0, 1000 and 3000 m)
+// ----------------------------------------------------------------------------
+static const double cheb_th[3] = {0.0, 1000.0, 3000.0}; // test heights
+
+static double cheb_dev(const GEO_PLAN *plan, const GEO_CHEB *ch, const double *ve,
+                       double xmin, double xmax, double ymin, double ymax)
+{
+  double u[CHEB_TEST+1], w[CHEB_TEST+1], v[GV_MAX*(CHEB_TEST+1)], vi[GV_MAX];
+  double d, maxerr = 0.0;
+  int ii, kk, ll, mm, n = CHEB_TEST + 1;
+
+  for (kk = 0; kk < n; kk++) {
+    for (ll = 0; ll < n; ll++) {
+      u[ll] = (xmin + kk*(xmax - xmin)/CHEB_TEST - ch->x0)*ch->sx;
+      w[ll] = (ymin + ll*(ymax - ymin)/CHEB_TEST - ch->y0)*ch->sy;
+    }
+    cheb_vec(ch, (1u << ch->nc) - 1, n, u, w, v);
+    for (ll = 0; ll < n; ll++) {
+      if (!(fabs(u[ll]) <= 1.0 && fabs(w[ll]) <= 1.0)) continue;
+      for (mm = 0; mm < ch->nc; mm++) vi[mm] = v[mm*n + ll];
+      for (ii = 0; ii < 3; ii++) {
+        d = grid_dist(plan, ch->nc, &ve[((kk*n + ll)*3 + ii)*GV_MAX], vi, cheb_th[ii]);
+        if (!(d <= maxerr)) maxerr = d; // also NaN
+        if (ch->nc <= GV_H) break; // no height dependence
+      }
+    }
+  }
+  return maxerr;
+} /* cheb_dev */
+
+
+// ----------------------------------------------------------------------------
+// geo_cheb_fit
+// ----------------------------------------------------------------------------
+// Fit Chebyshev approximation of total degree deg (max. GEO_CHEB_MAXDEG, 0:
+// lowest degree with max. deviation within 1 um of max. degree) for
+// transformation tr (1-6) over the input area of geoid model (values are
+// sampled in Chebyshev nodes, series truncated to total degree deg) and
+// measure max. deviation from exact conversion on regular grid of test
+// points (at input heights 0, 1000 and 3000 m). Degree of height derivatives
+// and position of geoid height is then lowered as long as max. deviation
+// grows by less than 1 um.
+// Returns 0 if OK, -1 if transformation or degree is not supported,
+// -2 if memory can't be allocated.
+// ----------------------------------------------------------------------------
+int geo_cheb_fit(GEO_CHEB *ch, int tr, int deg)
+{
+  GEO_CTX ctx; GEO_PLAN plan;
+  double xmin, xmax, ymin, ymax, x, y, err, *f, *tc, *ve;
+  int ii, kk, ll, nc, dd, m = CHEB_NODES, nt = CHEB_TEST + 1;
+
+  memset(ch, 0, sizeof(GEO_CHEB));
+  if (tr < 1 || tr > 6 || deg < 0 || deg > GEO_CHEB_MAXDEG) return -1;
+  geo_ctx_init(&ctx); ctx.tmsel = 0; ctx.csel = 0;
+  geo_plan_init(&plan, tr, &ctx);
+  nc = grid_nc(tr);
+
+  f = (double *)malloc((m*m*GV_MAX + (GEO_CHEB_MAXDEG+1)*m + nt*nt*3*GV_MAX)*sizeof(double));
+  if (f == NULL) return -2;
+  tc = f + m*m*GV_MAX; ve = tc + (GEO_CHEB_MAXDEG+1)*m;
+
+  grid_area(&plan, &xmin, &xmax, &ymin, &ymax);
+  ch->tr = tr; ch->nc = nc;
+  ch->x0 = (xmin + xmax)/2.0; ch->sx = 2.0/(xmax - xmin);
+  ch->y0 = (ymin + ymax)/2.0; ch->sy = 2.0/(ymax - ymin);
+
+  // Values in Chebyshev nodes (coefficients don't depend on truncation)
+  ch->deg = (deg > 0) ? deg : GEO_CHEB_MAXDEG;
+  cheb_nodes(ch->deg, m, tc);
+  for (kk = 0; kk < m; kk++)
+    for (ll = 0; ll < m; ll++)
+      grid_node(&plan, nc, GRID_HREF, ch->x0 + tc[m + kk]/ch->sx, ch->y0 + tc[m + ll]/ch->sy,
+                &f[(kk*m + ll)*GV_MAX]);
+  cheb_coef(nc, ch->deg, m, tc, f, ch->c);
+
+  // Exact values on regular grid of test points
+  for (kk = 0; kk < nt; kk++)
+    for (ll = 0; ll < nt; ll++) {
+      x = xmin + kk*(xmax - xmin)/CHEB_TEST;
+      y = ymin + ll*(ymax - ymin)/CHEB_TEST;
+      for (ii = 0; ii < 3; ii++) grid_exact(&plan, x, y, cheb_th[ii], &ve[((kk*nt + ll)*3 + ii)*GV_MAX]);
+    }
+
+  // Total degree (terms above it are set to 0)
+  for (ii = 0; ii < nc; ii++) ch->vdeg[ii] = ch->deg;
+  ch->maxerr = cheb_dev(&plan, ch, ve, xmin, xmax, ymin, ymax);
+  if (deg == 0) {
+    err = ch->maxerr;
+    for (dd = 1; dd < GEO_CHEB_MAXDEG; dd++) {
+      for (ii = 0; ii < nc; ii++) ch->vdeg[ii] = dd;
+      ch->maxerr = cheb_dev(&plan, ch, ve, xmin, xmax, ymin, ymax);
+      if (ch->maxerr <= err + CHEB_SLACK) break;
+    }
+    if (dd == GEO_CHEB_MAXDEG) ch->maxerr = err;
+    ch->deg = dd;
+    for (ii = 0; ii < nc; ii++) ch->vdeg[ii] = dd;
+  }
+  err = ch->maxerr;
+
+  // Lower degree of height derivatives and position of geoid height
+  for (kk = GV_DX; kk < nc; kk++) {
+    for (dd = 0; dd < ch->deg; dd++) {
+      ch->vdeg[kk] = dd;
+      ch->maxerr = cheb_dev(&plan, ch, ve, xmin, xmax, ymin, ymax);
+      if (ch->maxerr <= err + CHEB_SLACK) break;
+    }
+    if (dd == ch->deg) ch->vdeg[kk] = dd;
+  }
+  ch->maxerr = cheb_dev(&plan, ch, ve, xmin, xmax, ymin, ymax);
+
+  // Unused coefficients are 0 (see gk-slo -gc)
+  for (ii = 0; ii < nc; ii++)
+    for (kk = (ch->vdeg[ii] + 1)*(ch->vdeg[ii] + 2)/2; kk < GEO_CHEB_NCOEF; kk++)
+      ch->c[ii][kk] = 0.0;
+  free(f);
+  return 0;
+} /* geo_cheb_fit */
+
+
+// ----------------------------------------------------------------------------
+// Single precision local approximation
+// ----------------------------------------------------------------------------
+// Output x,y (or fi,la) minus converted origin are approximated around origin
+// with sums of c_ij*T_i(u)*T_j(v) (i+j <= GEO_F32_DEG), where u,v are input
+// coordinates minus origin, scaled to -1..1 over the approximation area.
+// Offsets and coefficients are small, so they can be evaluated in single
+// precision (twice as many points per vector as in double precision).
+#define F32_NODES 8   // number of fitting nodes per axis
+#define F32_RADIUS 10000.0 // default radius of approximation area (in m)
+
+
+// ----------------------------------------------------------------------------
+// geo_f32_init
+// ----------------------------------------------------------------------------
+// Fit single precision approximation f of transformation in plan (tr 1-6)
+// over area within r m (0: 10 km) from origin x0,y0 (input coordinates)
+// for input height h (heights are not converted) and measure max. deviation
+// of single precision evaluation from exact conversion.
+// Returns 0 if OK, -1 if transformation is not supported.
+// ----------------------------------------------------------------------------
+int geo_f32_init(GEO_F32 *f, const GEO_PLAN *plan, double x0, double y0, double r, double h)
+{
+  double tc[(GEO_F32_DEG+1)*F32_NODES], c[GV_H][GEO_CHEB_NCOEF];
+  double vn[F32_NODES*F32_NODES*GV_MAX], ve[GV_MAX], vi[GV_MAX];
+  double rx, ry, x, y, d;
+  int ii, kk, ll, m = F32_NODES;
+
+  memset(f, 0, sizeof(GEO_F32));
+  if (plan->tr < 1 || plan->tr > 6) return -1;
+  if (r <= 0.0) r = F32_RADIUS;
+  f->plan = *plan; f->tr = plan->tr; f->deg = GEO_F32_DEG;
+  f->x0 = x0; f->y0 = y0; f->r = r; f->h = h;
+
+  // Half width and height of approximation area in input coordinates
+  if (plan->ifila) {
+    rx = r/(ellips[plan->iid].a*PI/180.0);
+    ry = rx/cos(x0*PI/180.0);
+  }
+  else { rx = r; ry = r; }
+  f->sx = 1.0/rx; f->sy = 1.0/ry;
+
+  // Converted origin
+  grid_exact(plan, x0, y0, h, ve);
+  f->ox0 = ve[GV_X]; f->oy0 = ve[GV_Y];
+
+  // Values in Chebyshev nodes, coefficients relative to converted origin
+  cheb_nodes(f->deg, m, tc);
+  for (kk = 0; kk < m; kk++)
+    for (ll = 0; ll < m; ll++)
+      grid_exact(plan, x0 + tc[m + kk]*rx, y0 + tc[m + ll]*ry, h, &vn[(kk*m + ll)*GV_MAX]);
+  cheb_coef(GV_H, f->deg, m, tc, vn, c);
+  c[GV_X][0] -= f->ox0; c[GV_Y][0] -= f->oy0;
+  for (ii = 0; ii < GEO_F32_NCOEF; ii++) {
+    f->c[GV_X][ii] = (float)c[GV_X][ii];
+    f->c[GV_Y][ii] = (float)c[GV_Y][ii];
+  }
+
+  // Deviation on regular grid of test points (single precision evaluation)
+  for (kk = 0; kk <= 20; kk++)
+    for (ll = 0; ll <= 20; ll++) {
+      x = x0 + (kk - 10)*rx/10.0; y = y0 + (ll - 10)*ry/10.0;
+      grid_exact(plan, x, y, h, ve);
+      geo_f32_run(f, 1, &x, &y, &vi[GV_X], &vi[GV_Y]);
+      d = grid_dist(plan, GV_H, ve, vi, h);
+      if (!(d <= f->maxerr)) f->maxerr = d; // also NaN
+    }
+  return 0;
+} /* geo_f32_init */
+
+
+// ----------------------------------------------------------------------------
+// geo_f32_run
+// ----------------------------------------------------------------------------
+// Convert n points x,y (input coordinates) with single precision
+// approximation f to ox,oy (can be the same arrays as x,y): origin is
+// subtracted in double precision, offsets are converted in single precision
+// and converted origin is added back in double precision. Points outside
+// approximation area are converted exactly (at input height of f).
+// Returns number of converted points.
+// ----------------------------------------------------------------------------
+int geo_f32_run(const GEO_F32 *f, int n, const double *x, const double *y,
+                double *ox, double *oy)
+{
+  float u[MAXCHUNK], v[MAXCHUNK], ou[MAXCHUNK], ov[MAXCHUNK];
+  double h, oh;
+  int ii, jj, m;
+
+  for (ii = 0; ii < n; ii += MAXCHUNK) {
+    m = (n - ii < MAXCHUNK) ? n - ii : MAXCHUNK;
+    for (jj = 0; jj < m; jj++) {
+      u[jj] = (float)((x[ii+jj] - f->x0)*f->sx);
+      v[jj] = (float)((y[ii+jj] - f->y0)*f->sy);
+    }
+    cheb_f32_vec(m, f->deg, f->c[GV_X], f->c[GV_Y], u, v, ou, ov);
+    for (jj = 0; jj < m; jj++) {
+      if (fabsf(u[jj]) <= 1.0f && fabsf(v[jj]) <= 1.0f) {
+        ox[ii+jj] = f->ox0 + ou[jj]; oy[ii+jj] = f->oy0 + ov[jj];
+      }
+      else { // outside approximation area (also NaN)
+        h = f->h;
+        geo_plan_run(&f->plan, 1, &x[ii+jj], &y[ii+jj], &h, &ox[ii+jj], &oy[ii+jj], &oh, NULL);
+      }
+    }
+  }
+  return n;
+} /* geo_f32_run */
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,10 @@ typedef struct ellipsoid {
   // series' constants
   double A, B, C, D, E, F;
   double alfa, beta, gama, delta, epsilon;
+  // meridian arc length L = arc[0]*fi + sum(arc[k]*sin(2k*fi)), k = 1..5
+  double arc[6];
+  // Krueger n-series (6th order): rectifying radius, e, alpha and beta
+  double kA, ke, kalp[7], kbet[7];
 } ELLIPSOID;
 
 typedef struct helmert7 {
@@ -40,6 +44,7 @@ typedef struct helmert7 {
   double alfa, beta, gama; // rx, ry, rz
   double dm;               // s (scale)
   m33 *R;                  // rotation matrix
+  m33 *sR;                 // rotation matrix multiplied by scale (1 + s)
 } HELMERT7;
 
 typedef struct proj {
@@ -50,11 +55,42 @@ typedef struct proj {
   double lambda0; // meridian in radians
 } PROJ;
 
+#define GEO_MAXZONE 9 // number of Gauss-Krueger zones (see gkzones[])
+
 typedef struct gklm {
   double fimin, fimax, lamin, lamax;
   double xmin, xmax, ymin, ymax;
 } GKLM;
 
+#define GEO_TILE 8 // geoid grid tile size (GEO_TILE x GEO_TILE nodes)
+
+#define GEO_GEOID_MAGIC "GKGEOID1" // binary geoid model file (see geoid_save)
+#define GEO_GEOID_ORDER 0x01020304 // byte order check
+
+typedef struct geo_geoid_hdr { // header of binary geoid model file
+  char magic[8];  // GEO_GEOID_MAGIC
+  int order;      // GEO_GEOID_ORDER (files are in native byte order)
+  int nx, ny;     // number of nodes (fi, la)
+  int tx, ty;     // number of tiles (fi, la)
+  int base;       // base height in mm
+  double fimin, fimax, lamin, lamax; // area of model (in degrees)
+  double dfi, dla; // distance between nodes (in degrees)
+  double dla0;    // la step of cell origins in interpolation (usually dla)
+} GEO_GEOID_HDR;  // followed by heights and validity bitmap of all tiles
+
+typedef struct geo_geoid { // compact geoid model (see geoid_pack)
+  int nx, ny;     // number of nodes (fi, la)
+  int tx, ty;     // number of tiles (fi, la)
+  int base;       // base height in mm
+  double fimin, fimax, lamin, lamax; // area of model (in degrees)
+  double dfi, dla; // distance between nodes (in degrees)
+  double dla0;    // la step of cell origins in interpolation (usually dla)
+  const short *val; // tiles of heights in mm relative to base (row by row)
+  const unsigned char *valid; // validity bitmap (one byte per tile row)
+  void *map;      // mapped file (NULL: compiled-in model)
+  size_t mapsize;
+} GEO_GEOID;
+
 typedef struct geogra { // geodetic/geographic coordinates
   double fi; // fi, latitude
   double la; // lambda, longitude
@@ -81,6 +117,112 @@ typedef struct aft { // affine transformation table
   double a, b, c, d, e, f; // AFT parameters
 } AFT;
 
+// Height source and skippable stages of conversion plan
+#define GEO_HSRC_INPUT  0 // output height from input height
+#define GEO_HSRC_TRANS  1 // output height from transformed (ellipsoidal) height
+#define GEO_SKIP_GEOID  1 // geoid height not needed
+#define GEO_SKIP_HEIGHT 2 // transformed height not needed
+
+typedef struct geo_ctx { // conversion context (see geo_ctx_init)
+  int gid_wgs;  // geoid on WGS 84 (1: slo2000, 2: egm2008)
+  int hsel;     // output height (-1: default, 0: transformed, 1: copied, 2: geoid)
+  int tmsel;    // TM projection series (0: tan-power, 1: Krueger n-series)
+  int last_tri; // last found AFT triangle (-1: none)
+  double gtol;  // interpolation grid tolerance in m (0: exact conversion)
+  double jtol;  // linearization cache tolerance in m (0: exact conversion)
+  int csel;     // Chebyshev approximation (0: exact conversion, 1: tr 1, 3-6)
+  int nthr;     // number of threads in batch conversions (0: all CPUs)
+  int zsel;     // multi-zone GK coordinates (zone number in front of easting)
+} GEO_CTX;
+
+typedef struct geo_plan GEO_PLAN;
+typedef int (*GEO_KERNEL)(const GEO_PLAN *plan, int n, const double *x,
+  const double *y, const double *h, double *ox, double *oy, double *oh, int *status);
+
+struct geo_plan { // conversion plan (see geo_plan_init)
+  int tr;           // transformation (1-12)
+  int hsel;         // output height (-1: default, 0: transformed, 1: copied, 2: geoid)
+  int gid;          // geoid on WGS 84 (1: slo2000, 2: egm2008)
+  int tmsel;        // TM projection series (0: tan-power, 1: Krueger n-series)
+  int iid, oid;     // input/output ellipsoid (0: bessel, 1: wgs84)
+  int ifila, ofila; // input/output coordinates are fi,la (otherwise x,y)
+  int hsrc;         // output height source (GEO_HSRC_*)
+  int hgeoid;       // geoid height: 0: none, 1: added, -1: subtracted
+  int skip;         // stages which can be skipped (GEO_SKIP_*)
+  int nthr;         // number of threads in geo_plan_run()
+  int zones;        // GK coordinates in their own zones (tr 3-6)
+  int *hint;        // AFT triangle hint kept between calls (NULL: per call)
+  HELMERT7 *h7;     // Helmert parameters (NULL if not used)
+  GEO_KERNEL kernel;
+  const struct geo_grid *grid; // interpolation grid (NULL: exact conversion)
+  struct geo_jac *jac;         // linearization cache (NULL: exact conversion)
+  const struct geo_cheb *cheb; // Chebyshev approximation (NULL: exact conversion)
+  GEO_KERNEL exact;            // exact kernel (used outside approximation area)
+};
+
+typedef struct geo_grid { // interpolation grid (see geo_grid_init)
+  GEO_PLAN plan;    // exact conversion plan (used outside grid)
+  double x0, y0;    // input coordinates of first node
+  double dx, dy;    // node spacing
+  double rdx, rdy;  // 1/dx, 1/dy
+  int nx, ny;       // number of nodes
+  int nc;           // number of values per node
+  double href;      // reference height for height derivatives
+  double *val;      // node values (nx*ny*nc)
+  double maxerr;    // max. sampled deviation from exact conversion (in m)
+} GEO_GRID;
+
+#define GEO_CHEB_MAXDEG 10 // max. total degree of Chebyshev approximation
+#define GEO_CHEB_NCOEF ((((GEO_CHEB_MAXDEG+1)*(GEO_CHEB_MAXDEG+2)/2) + 3) & ~3) // padded to 4
+
+typedef struct geo_cheb { // Chebyshev approximation (see geo_cheb_fit)
+  int tr;           // transformation (1-6)
+  int deg;          // total degree (0: no approximation)
+  int nc;           // number of values (see grid values in geo.c)
+  int vdeg[8];      // total degree of each value (<= deg)
+  double x0, y0;    // centre of input area
+  double sx, sy;    // 2/(input area width, height)
+  double maxerr;    // max. deviation from exact conversion (in m)
+  double c[8][GEO_CHEB_NCOEF]; // coefficients of T_i(u)*T_j(v), ordered by i+j <= deg
+} GEO_CHEB;
+
+#define GEO_F32_DEG 4   // total degree of single precision approximation
+#define GEO_F32_NCOEF 16 // (GEO_F32_DEG+1)*(GEO_F32_DEG+2)/2 padded to 4
+
+typedef struct geo_f32 { // single precision local approximation (see geo_f32_init)
+  GEO_PLAN plan;    // exact conversion plan (used outside approximation area)
+  int tr;           // transformation (1-6)
+  int deg;          // total degree
+  double x0, y0;    // origin (input coordinates)
+  double ox0, oy0;  // converted origin (output coordinates)
+  double sx, sy;    // 1/(half width, height of approximation area)
+  double r;         // radius of approximation area (in m)
+  double h;         // input height used for approximation
+  double maxerr;    // max. deviation from exact conversion (in m)
+  float c[2][GEO_F32_NCOEF]; // coefficients of T_i(u)*T_j(v) for x,y minus origin
+} GEO_F32;
+
+typedef struct geo_jac_cell { // cell of linearization cache
+  int ix, iy;       // cell index
+  int state;        // 0: empty, 1: linear map, -1: exact conversion
+  double xc, yc;    // input coordinates of cell centre
+  double v[8];      // values in cell centre (see grid values in geo.c)
+  double jx[8];     // derivatives of values by x
+  double jy[8];     // derivatives of values by y
+} GEO_JAC_CELL;
+
+typedef struct geo_jac { // linearization cache (see geo_jac_init)
+  GEO_PLAN plan;    // exact conversion plan (used in cells failing check)
+  double cell;      // cell size (in input units)
+  double rcell;     // 1/cell
+  double tol;       // max. allowed deviation from exact conversion (in m)
+  int nc;           // number of values per cell
+  GEO_JAC_CELL *cells;
+  double maxerr;    // max. deviation in linearized cells (in m)
+  long nlin;        // number of points converted with linear map
+  long nexact;      // number of points converted exactly
+} GEO_JAC;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -103,7 +245,16 @@ void ellipsoid_init();
 void h7_precalc(HELMERT7 *h7);
 void params_init();
 
+int geoid_pack(GEO_GEOID *g, const double *src, int nx, int ny, short *val,
+               unsigned char *valid);
+int geoid_load(int gid, const char *fname);
+int geoid_save(int gid, const char *fname);
+int geoid_load_file(int gid, const char *fname, char *msg);
+void geoid_free(int gid);
+void geoid_cell_coef(const GEO_GEOID *g, int ix, int iy, double *cf);
 double geoid_height(double fi, double la, int gid);
+double arc_length(double fi, int oid);
+double arc_length_sum(double fi, int oid, int alg);
 
 int point_in_bounding_box(double x1, double y1, double x2, double y2, double x3, double y3, double x, double y);
 double side(double x1, double y1, double x2, double y2, double x, double y);
@@ -111,6 +262,29 @@ int point_in_triangle(double x1, double y1, double x2, double y2, double x3, dou
 double dist_to_segm(double x1, double y1, double x2, double y2, double x, double y);
 int coord_in_triangle(GEOUTM in, AFT aft);
 
+void xy2fila_rad(double x, double y, double *fi, double *la, int oid);
+void fila2xy_rad(double fi, double la, double *x, double *y, int oid);
+void xyz2fila_rad(double X, double Y, double Z, double *fi, double *la, double *h, int oid);
+void fila2xyz_rad(double fi, double la, double h, double *X, double *Y, double *Z, int oid);
+void xyz2xyz_h7(double X, double Y, double Z, double *oX, double *oY, double *oZ,
+                const HELMERT7 *h7);
+
+void geo_ctx_init(GEO_CTX *ctx);
+void geo_ctx_default_update(void);
+
+void xy2fila_ellips_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out, int oid);
+void fila_ellips2xy_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out, int oid);
+void gkxy2fila_wgs_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out);
+void fila_wgs2gkxy_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out);
+void gkxy2tmxy_ctx(GEO_CTX *ctx, GEOUTM in, GEOUTM *out);
+void tmxy2gkxy_ctx(GEO_CTX *ctx, GEOUTM in, GEOUTM *out);
+void tmxy2fila_wgs_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out);
+void fila_wgs2tmxy_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out);
+void gkxy2fila_wgs_aft_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out);
+void fila_wgs2gkxy_aft_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out);
+int xy2fila_ellips_loop_ctx(GEO_CTX *ctx, GEOUTM in, GEOGRA *out, int oid);
+int fila_ellips2xy_loop_ctx(GEO_CTX *ctx, GEOGRA in, GEOUTM *out, int oid);
+
 void xy2fila_ellips(GEOUTM in, GEOGRA *out, int oid);
 void fila_ellips2xy(GEOGRA in, GEOUTM *out, int oid);
 int xy2fila_ellips_loop(GEOUTM in, GEOGRA *out, int oid);
@@ -129,6 +303,66 @@ void fila_wgs2tmxy(GEOGRA in, GEOUTM *out);
 void gkxy2fila_wgs_aft(GEOUTM in, GEOGRA *out, int *last_tri);
 void fila_wgs2gkxy_aft(GEOGRA in, GEOUTM *out, int *last_tri);
 
+void fila2xy_krueger(double fi, double la, double *x, double *y, int oid);
+void xy2fila_krueger(double x, double y, double *fi, double *la, int oid);
+void fila2xy_krueger_proj(const PROJ *pj, double fi, double la, double *x, double *y, int oid);
+void xy2fila_krueger_proj(const PROJ *pj, double x, double y, double *fi, double *la, int oid);
+void fila2xy_krueger_rad(double fi, double la, double *x, double *y, int oid);
+void xy2fila_krueger_rad(double x, double y, double *fi, double *la, int oid);
+void fila2xy_krueger_rad_proj(const PROJ *pj, double fi, double la, double *x, double *y, int oid);
+void xy2fila_krueger_rad_proj(const PROJ *pj, double x, double y, double *fi, double *la, int oid);
+void xy2fila_rad_proj(const PROJ *pj, double x, double y, double *fi, double *la, int oid);
+void fila2xy_rad_proj(const PROJ *pj, double fi, double la, double *x, double *y, int oid);
+
+int geo_plan_init(GEO_PLAN *plan, int tr, const GEO_CTX *ctx);
+int geo_plan_run(const GEO_PLAN *plan, int n, const double *x, const double *y, const double *h,
+                 double *ox, double *oy, double *oh, int *status);
+int geo_convert_batch_ctx(const GEO_CTX *ctx, int tr, int n, const double *x, const double *y,
+                          const double *h, double *ox, double *oy, double *oh, int *status);
+int geo_convert_batch(int tr, int n, const double *x, const double *y, const double *h,
+                      double *ox, double *oy, double *oh, int *status);
+int geo_geoid_batch(int gid, int dir, int n, const double *fi, const double *la,
+                    const double *h, double *oh);
+int geo_ncpu();
+void geo_pool_free();
+int geo_plan_inverse(GEO_PLAN *inv, const GEO_PLAN *plan, const GEO_CTX *ctx);
+int geo_plan_check(const GEO_PLAN *inv, int n, const double *x, const double *y,
+                   const double *ox, const double *oy, const double *oh,
+                   double tol, double *maxerr);
+int geo_grid_init(GEO_GRID *grid, GEO_PLAN *plan, double tol);
+void geo_grid_free(GEO_GRID *grid);
+int geo_jac_init(GEO_JAC *jac, GEO_PLAN *plan, double tol, double cell);
+void geo_jac_free(GEO_JAC *jac);
+int geo_cheb_fit(GEO_CHEB *ch, int tr, int deg);
+int geo_f32_init(GEO_F32 *f, const GEO_PLAN *plan, double x0, double y0, double r, double h);
+int geo_f32_run(const GEO_F32 *f, int n, const double *x, const double *y,
+                double *ox, double *oy);
+
+// Vectorized kernels (geo_simd.c)
+void fila_ellips2xy_vec(int n, const double *fi, const double *la,
+                        double *x, double *y, int oid);
+void xy2fila_ellips_vec(int n, const double *x, const double *y,
+                        double *fi, double *la, int oid);
+void fila_ellips2fila_helmert_vec(int n, const double *fi, const double *la,
+       const double *h, double *ofi, double *ola, double *oh,
+       HELMERT7 h7, int iid, int oid);
+void cheb_f32_vec(int n, int deg, const float *c0, const float *c1,
+                  const float *u, const float *v, float *ou, float *ov);
+void cheb_vec(const GEO_CHEB *ch, unsigned mask, int n, const double *u, const double *v,
+              double *val);
+void fila_ellips2xy_proj_vec(const PROJ *pj, int n, const double *fi, const double *la,
+                             double *x, double *y, int oid);
+void xy2fila_ellips_proj_vec(const PROJ *pj, int n, const double *x, const double *y,
+                             double *fi, double *la, int oid);
+void fila2xy_krueger_proj_vec(const PROJ *pj, int n, const double *fi, const double *la,
+                              double *x, double *y, int oid);
+void xy2fila_krueger_proj_vec(const PROJ *pj, int n, const double *x, const double *y,
+                              double *fi, double *la, int oid);
+void geoid_height_vec(int n, const double *fi, const double *la, double *Ng, int gid);
+int geo_simd_init(int repro);
+int geo_simd_width();
+const char *geo_simd_name();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,408 @@
+// GK - Converter between Gauss-Krueger/TM and WGS84 coordinates for Slovenia
+// Copyright (c) 2014-2019 Matjaz Rihtar <matjaz@eunet.si>
+// All rights reserved.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see http://www.gnu.org/licenses/
+//
+// geo.hpp: Header-only C++ conversion kernels, specialized at compile time
+//
+// geo::Converter<From, To, Height> instantiates the whole conversion chain
+// for one point with constexpr ellipsoid, projection and Helmert constants,
+// so the compiler can inline and constant-fold it. Same algorithms as in
+// geo.c (L1/L4, PS1, FI1, H71), tan-power series only. Only the geoid height
+// is taken from geo.c (geoid_height(), ellipsoid_init() and params_init()
+// must be called before). Arrays of points are converted with the
+// vectorized batch kernels of geo.c (conversion plan built once per
+// converter). Constants are checked against those of geo.c
+// (check_constants()) when the first converter is made; if they differ,
+// single points are converted with geo.c as well.
+//
+#ifndef _GEO_HPP_DEFINED
+#define _GEO_HPP_DEFINED
+
+#include <math.h>
+#include "geo.h"
+
+extern "C" {
+extern ELLIPSOID ellips[3];   // in geo.c
+extern PROJ tm;               // in geo.c
+extern HELMERT7 slo7, slo7inv; // in geo.c
+}
+
+namespace geo {
+
+enum class From { D48GK, D96TM, ETRS89 };
+enum class To { D48GK, D96TM, ETRS89 };
+enum class Height { // same values as hsel
+  Default = -1, Transformed = 0, Copied = 1, Geoid = 2
+};
+
+namespace detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+// ----------------------------------------------------------------------------
+// Ellipsoid constants (see ellipsoid_precalc and series_precalc in geo.c)
+// ----------------------------------------------------------------------------
+struct Ellipsoid {
+  double a, b, a2, b2, c, e2, e2_;
+  double arc[6]; // meridian arc length series (L1)
+};
+
+constexpr double sq(double x) { return x*x; }
+constexpr double e2(double f) { return f*(2 - f); }
+constexpr double e2_(double f) { return e2(f)/sq(1 - f); }
+
+// Series' constants A..F for E2 = e2_ (L1)
+constexpr double sA(double E2) {
+  return 1.0 - 3.0/4.0*E2 + 45.0/64.0*sq(E2) - 175.0/256.0*(sq(E2)*E2)
+    + 11025.0/16384.0*sq(sq(E2)) - 43659.0/65536.0*((sq(E2)*E2)*sq(E2));
+}
+constexpr double sB(double E2) {
+  return -3.0/4.0*E2 + 15.0/16.0*sq(E2) - 525.0/512.0*(sq(E2)*E2)
+    + 2205.0/2048.0*sq(sq(E2)) - 72765.0/65536.0*((sq(E2)*E2)*sq(E2));
+}
+constexpr double sC(double E2) {
+  return 15.0/64.0*sq(E2) - 105.0/256.0*(sq(E2)*E2) + 2205.0/4096.0*sq(sq(E2))
+    - 10395.0/16384.0*((sq(E2)*E2)*sq(E2));
+}
+constexpr double sD(double E2) {
+  return -35.0/512.0*(sq(E2)*E2) + 315.0/2048.0*sq(sq(E2))
+    - 31185.0/131072.0*((sq(E2)*E2)*sq(E2));
+}
+constexpr double sE(double E2) {
+  return 315.0/16384.0*sq(sq(E2)) - 3465.0/65536.0*((sq(E2)*E2)*sq(E2));
+}
+constexpr double sF(double E2) {
+  return -639.0/131072.0*((sq(E2)*E2)*sq(E2));
+}
+
+constexpr Ellipsoid make_ellipsoid(double a, double f) {
+  return Ellipsoid{ a, a*(1 - f), sq(a), sq(a*(1 - f)), a/(1 - f), e2(f), e2_(f),
+    { a/(1 - f)*sA(e2_(f)), a/(1 - f)*sB(e2_(f))/2.0, a/(1 - f)*sC(e2_(f))/4.0,
+      a/(1 - f)*sD(e2_(f))/6.0, a/(1 - f)*sE(e2_(f))/8.0,
+      a/(1 - f)*sF(e2_(f))/10.0 } };
+}
+
+// Bessel 1841 (D48/GK) and WGS 84 (D96/TM, ETRS89), as in ellipsoid_init
+constexpr Ellipsoid bessel = make_ellipsoid(6377397.155, 1/299.1528128);
+constexpr Ellipsoid wgs84 = make_ellipsoid(6378137.0, 1/298.257223563);
+
+// TM/GK projection for Slovenia, as in params_init
+constexpr double tm_scale = 0.9999;
+constexpr double tm_false_easting = 500000;
+constexpr double tm_false_northing = -5000000;
+constexpr double tm_lambda0 = 15*PI/180.0;
+
+// ----------------------------------------------------------------------------
+// Helmert rotation matrix multiplied by scale (see h7_precalc, H71)
+// ----------------------------------------------------------------------------
+struct Helmert {
+  double dX, dY, dZ;
+  double sR[9];
+};
+
+// sin/cos of small angles (a few arc seconds), exact to double precision
+constexpr double ssin(double x) { return x*(1.0 - x*x/6.0*(1.0 - x*x/20.0*(1.0 - x*x/42.0))); }
+constexpr double scos(double x) { return 1.0 - x*x/2.0*(1.0 - x*x/12.0*(1.0 - x*x/30.0)); }
+constexpr double arcsec(double s) { return (s/3600.0)*PI/180.0; }
+
+// R = R1(gama)*R2(beta)*R3(alfa), multiplied by (1 + s)
+constexpr Helmert make_helmert(double dX, double dY, double dZ, double alfa,
+                               double beta, double gama, double dm) {
+  return Helmert{ dX, dY, dZ, {
+    (1.0 + dm*1e-6)*(scos(arcsec(gama))*scos(arcsec(beta))),
+    (1.0 + dm*1e-6)*(scos(arcsec(gama))*ssin(arcsec(beta))*ssin(arcsec(alfa)) + ssin(arcsec(gama))*scos(arcsec(alfa))),
+    (1.0 + dm*1e-6)*(-scos(arcsec(gama))*ssin(arcsec(beta))*scos(arcsec(alfa)) + ssin(arcsec(gama))*ssin(arcsec(alfa))),
+    (1.0 + dm*1e-6)*(-ssin(arcsec(gama))*scos(arcsec(beta))),
+    (1.0 + dm*1e-6)*(-ssin(arcsec(gama))*ssin(arcsec(beta))*ssin(arcsec(alfa)) + scos(arcsec(gama))*scos(arcsec(alfa))),
+    (1.0 + dm*1e-6)*(ssin(arcsec(gama))*ssin(arcsec(beta))*scos(arcsec(alfa)) + scos(arcsec(gama))*ssin(arcsec(alfa))),
+    (1.0 + dm*1e-6)*(ssin(arcsec(beta))),
+    (1.0 + dm*1e-6)*(-scos(arcsec(beta))*ssin(arcsec(alfa))),
+    (1.0 + dm*1e-6)*(scos(arcsec(beta))*scos(arcsec(alfa))) } };
+}
+
+// Parameters for Slovenia, as in params_init
+constexpr Helmert slo7 = make_helmert(409.545088, 72.164092, 486.871732,
+  -3.085957, -5.469110, 11.020289, 17.919665);
+constexpr Helmert slo7inv = make_helmert(-409.520465, -72.191827, -486.872387,
+  3.086250, 5.468945, -11.020370, -17.919456);
+
+// ----------------------------------------------------------------------------
+// Conversion stages (fi,la in radians), see *_rad routines in geo.c
+// ----------------------------------------------------------------------------
+inline double arc_length(const Ellipsoid &el, double fi)
+{
+  double s2 = sin(2.0*fi), c2 = cos(2.0*fi), b1 = 0.0, b2 = 0.0, b3;
+
+  for (int k = 5; k >= 1; k--) {
+    b3 = b2; b2 = b1;
+    b1 = el.arc[k] + 2.0*c2*b2 - b3;
+  }
+  return el.arc[0]*fi + b1*s2;
+}
+
+inline void xy2fila(const Ellipsoid &el, double x, double y, double &fi, double &la)
+{
+  double ab, fi0, dif, sinFi0, cosFi0, cos2Fi0, tanFi0, tan2Fi0, tan4Fi0, tan6Fi0;
+  double N, ni2, ni4, v;
+  int n;
+
+  x = (x - tm_false_northing)/tm_scale;
+  y = (y - tm_false_easting)/tm_scale;
+
+  ab = el.a + el.b;
+  fi0 = 2.0*x/ab; // first estimate
+  dif = 1.0; n = 15;
+  while (fabs(dif) >= 1e-18 && n > 0) {
+    dif = 2.0*(x - arc_length(el, fi0))/ab;
+    fi0 += dif;
+    n--;
+  }
+
+  sinFi0 = sin(fi0); cosFi0 = cos(fi0);
+  cos2Fi0 = cosFi0*cosFi0;
+  tanFi0 = sinFi0/cosFi0;
+  tan2Fi0 = tanFi0*tanFi0; tan4Fi0 = tan2Fi0*tan2Fi0; tan6Fi0 = tan4Fi0*tan2Fi0;
+
+  N = el.c/sqrt(1.0 + el.e2_*cos2Fi0);
+  ni2 = el.e2_*cos2Fi0;
+  ni4 = ni2*ni2;
+
+  v = y/N; v = v*v;
+  fi = fi0 + tanFi0*v*(-(1.0 + ni2)/2.0
+    + v*((5.0 + 3.0*tan2Fi0 + 6.0*ni2 - 6.0*tan2Fi0*ni2 - 3.0*ni4
+          - 9.0*tan2Fi0*ni4)/24.0
+    + v*((-61.0 - 90.0*tan2Fi0 - 45.0*tan4Fi0 - 107.0*ni2 + 162.0*tan2Fi0*ni2
+          + 45.0*tan4Fi0*ni2)/720.0
+    + v*(1385.0 + 3633.0*tan2Fi0 + 4095.0*tan4Fi0 + 1575.0*tan6Fi0)/40320.0)));
+
+  la = tm_lambda0 + y/(N*cosFi0)*(1.0
+    + v*((-1.0 - 2.0*tan2Fi0 - ni2)/6.0
+    + v*((5.0 + 28.0*tan2Fi0 + 24.0*tan4Fi0 + 8.0*tan2Fi0*ni2 + 6.0*ni2)/120.0
+    + v*(-61.0 - 662.0*tan2Fi0 - 1320.0*tan4Fi0 - 720.0*tan6Fi0)/5040.0)));
+}
+
+inline void fila2xy(const Ellipsoid &el, double fi, double la, double &x, double &y)
+{
+  double dl, dl2, sinFi, cosFi, cos2Fi, tanFi, tan2Fi, tan4Fi, tan6Fi;
+  double N, ni2, ni4, L, u;
+
+  dl = la - tm_lambda0;
+  sinFi = sin(fi); cosFi = cos(fi);
+  dl2 = dl*dl;
+  cos2Fi = cosFi*cosFi;
+  tanFi = sinFi/cosFi;
+  tan2Fi = tanFi*tanFi; tan4Fi = tan2Fi*tan2Fi; tan6Fi = tan4Fi*tan2Fi;
+
+  N = el.c/sqrt(1.0 + el.e2_*cos2Fi);
+  ni2 = el.e2_*cos2Fi;
+  ni4 = ni2*ni2;
+  L = arc_length(el, fi);
+
+  u = cos2Fi*dl2;
+  x = L + N*sinFi*cosFi*dl2*(1.0/2.0
+    + u*((5.0 - tan2Fi + 9.0*ni2 + 4.0*ni4)/24.0
+    + u*((61.0 - 58.0*tan2Fi + tan4Fi + 270.0*ni2 - 330.0*tan2Fi*ni2)/720.0
+    + u*(1385.0 - 3111.0*tan2Fi + 543.0*tan4Fi - tan6Fi)/40320.0)));
+
+  y = N*cosFi*dl*(1.0
+    + u*((1.0 - tan2Fi + ni2)/6.0
+    + u*((5.0 - 18.0*tan2Fi + tan4Fi + 14.0*ni2 - 58.0*tan2Fi*ni2)/120.0
+    + u*(61.0 - 479.0*tan2Fi + 179.0*tan4Fi - tan6Fi)/5040.0)));
+
+  x = x*tm_scale + tm_false_northing;
+  y = y*tm_scale + tm_false_easting;
+}
+
+inline void fila2xyz(const Ellipsoid &el, double fi, double la, double h,
+                     double &X, double &Y, double &Z)
+{
+  double sinFi = sin(fi), cosFi = cos(fi);
+  double N = el.a/sqrt(1.0 - el.e2*sinFi*sinFi);
+
+  X = (N + h)*cosFi*cos(la);
+  Y = (N + h)*cosFi*sin(la);
+  Z = ((el.b2/el.a2)*N + h)*sinFi;
+}
+
+inline void xyz2fila(const Ellipsoid &el, double X, double Y, double Z,
+                     double &fi, double &la, double &h)
+{
+  double p, O, sinO, cosO, sinFi, N;
+
+  // Bowring's algorithm (FI1)
+  p = sqrt(X*X + Y*Y);
+  O = atan2(Z*el.a, p*el.b);
+  sinO = sin(O); cosO = cos(O);
+  fi = atan2(Z + el.e2_*el.b*(sinO*sinO*sinO), p - el.e2*el.a*(cosO*cosO*cosO));
+  sinFi = sin(fi);
+  N = el.a/sqrt(1.0 - el.e2*sinFi*sinFi);
+  la = atan2(Y, X);
+  h = p/cos(fi) - N;
+}
+
+inline void helmert(const Helmert &h7, double X, double Y, double Z,
+                    double &oX, double &oY, double &oZ)
+{
+  oX = h7.dX + h7.sR[0]*X + h7.sR[1]*Y + h7.sR[2]*Z;
+  oY = h7.dY + h7.sR[3]*X + h7.sR[4]*Y + h7.sR[5]*Z;
+  oZ = h7.dZ + h7.sR[6]*X + h7.sR[7]*Y + h7.sR[8]*Z;
+}
+
+// ----------------------------------------------------------------------------
+// Constants check
+// ----------------------------------------------------------------------------
+inline int differ(double c, double v) { return fabs(c - v) > 1e-15*fabs(v); }
+
+inline int differ(const Ellipsoid &el, const ELLIPSOID &e)
+{
+  int k, nd;
+
+  nd = differ(el.a, e.a) + differ(el.b, e.b) + differ(el.a2, e.a2)
+     + differ(el.b2, e.b2) + differ(el.c, e.c) + differ(el.e2, e.e2)
+     + differ(el.e2_, e.e2_);
+  for (k = 0; k < 6; k++) nd += differ(el.arc[k], e.arc[k]);
+  return nd;
+}
+
+inline int differ(const Helmert &h7, const HELMERT7 &h)
+{
+  int k, nd;
+
+  nd = differ(h7.dX, h.dX) + differ(h7.dY, h.dY) + differ(h7.dZ, h.dZ);
+  for (k = 0; k < 9; k++) nd += differ(h7.sR[k], (*h.sR)[k/3][k%3]);
+  return nd;
+}
+
+// Transformation number (same as gk-slo -t), 0 if not supported
+constexpr int trans(From f, To t) {
+  return (f == From::D96TM && t == To::ETRS89) ? 1 :
+         (f == From::ETRS89 && t == To::D96TM) ? 2 :
+         (f == From::D48GK && t == To::ETRS89) ? 3 :
+         (f == From::ETRS89 && t == To::D48GK) ? 4 :
+         (f == From::D48GK && t == To::D96TM) ? 5 :
+         (f == From::D96TM && t == To::D48GK) ? 6 : 0;
+}
+
+} // namespace detail
+
+// ----------------------------------------------------------------------------
+// check_constants
+// ----------------------------------------------------------------------------
+// Compare constexpr constants with those calculated by ellipsoid_init() and
+// params_init() in geo.c (which must be called before).
+// Returns number of constants which differ (0 if all are the same).
+// ----------------------------------------------------------------------------
+inline int check_constants()
+{
+  using namespace detail;
+
+  return differ(bessel, ellips[0]) + differ(wgs84, ellips[1])
+    + differ(tm_scale, tm.scale) + differ(tm_false_easting, tm.false_easting)
+    + differ(tm_false_northing, tm.false_northing)
+    + differ(tm_lambda0, tm.lambda0)
+    + differ(slo7, ::slo7) + differ(slo7inv, ::slo7inv);
+} /* check_constants */
+
+// ----------------------------------------------------------------------------
+// Converter
+// ----------------------------------------------------------------------------
+// Conversion from CRS F to CRS T with output height H (same results as
+// geo_convert_batch() with corresponding tr and hsel). All decisions for
+// single points are made at compile time, only the geoid id is selected at
+// run time. Arrays are converted with plan of geo.c (tan-power series, exact
+// conversion, threads as set in nthr).
+// ----------------------------------------------------------------------------
+template <From F, To T, Height H = Height::Default>
+class Converter {
+  static constexpr int tr = detail::trans(F, T);
+  static constexpr int hs = static_cast<int>(H);
+  static_assert(tr != 0, "geo::Converter: unsupported transformation");
+
+  // Output height (see geo_plan_init): from transformed height?
+  // geoid height added (1) or subtracted (-1)?
+  static constexpr bool htrans =
+    (tr == 3 && hs != 1 && hs != 2) || (tr == 4 && hs == 0) ||
+    (tr == 5 && hs != 1) || (tr == 6 && hs != 1 && hs != 2);
+  static constexpr int hgeoid =
+    ((tr == 1 || tr == 9) && hs != 1) || (tr == 3 && hs == 2) ? 1 :
+    ((tr == 2 || tr == 10) && hs != 1) || (tr == 4 && hs != 1 && hs != 0) ||
+    (tr == 5 && hs != 1 && hs != 0) ? -1 : 0;
+
+  int gid;       // geoid on WGS 84 (1: slo2000, 2: egm2008)
+  bool constok;  // constants are the same as in geo.c
+  GEO_PLAN plan; // batch conversion plan
+
+public:
+  explicit Converter(int g = 1) : gid(g)
+  {
+    static const bool ok = check_constants() == 0; // checked once
+    GEO_CTX ctx;
+
+    constok = ok;
+    geo_ctx_init(&ctx);
+    ctx.gid_wgs = g; ctx.hsel = hs; ctx.tmsel = 0;
+    ctx.gtol = 0.0; ctx.jtol = 0.0; ctx.csel = 0; ctx.zsel = 0;
+    geo_plan_init(&plan, tr, &ctx);
+  }
+
+  // Convert one point: x,y,h are GK/TM x,y,H or fi,la,h (in degrees)
+  inline void operator()(double x, double y, double h,
+                         double &ox, double &oy, double &oh) const
+  {
+    using namespace detail;
+    double fi, la, ht, X, Y, Z, oX, oY, oZ, hg;
+
+    if (!constok) { geo_plan_run(&plan, 1, &x, &y, &h, &ox, &oy, &oh, NULL); return; }
+
+    ht = h; hg = h;
+    // Input coordinates to fi,la in radians
+    if (F == From::ETRS89) { fi = x*PI/180.0; la = y*PI/180.0; }
+    else xy2fila(F == From::D48GK ? bessel : wgs84, x, y, fi, la);
+
+    // Helmert transformation between datums
+    if (tr >= 3) {
+      if (tr == 6) hg = h + geoid_height(fi*180.0/PI, la*180.0/PI, gid);
+      fila2xyz(F == From::D48GK ? bessel : wgs84, fi, la, hg, X, Y, Z);
+      helmert(F == From::D48GK ? slo7 : slo7inv, X, Y, Z, oX, oY, oZ);
+      xyz2fila(F == From::D48GK ? wgs84 : bessel, oX, oY, oZ, fi, la, ht);
+    }
+
+    // Output height
+    oh = htrans ? ht : (tr == 6 && hs == 2) ? hg : h;
+    if (hgeoid != 0) {
+      if (tr == 2 || tr == 4)
+        oh += hgeoid*geoid_height(x, y, gid); // on input fi,la
+      else
+        oh += hgeoid*geoid_height(fi*180.0/PI, la*180.0/PI, gid);
+    }
+
+    // fi,la to output coordinates
+    if (T == To::ETRS89) { ox = fi*180.0/PI; oy = la*180.0/PI; }
+    else fila2xy(T == To::D48GK ? bessel : wgs84, fi, la, ox, oy);
+  }
+
+  // Convert n points stored in separate arrays (can be the same arrays)
+  // with vectorized batch kernels (see geo_plan_run())
+  void operator()(int n, const double *x, const double *y, const double *h,
+                  double *ox, double *oy, double *oh) const
+  {
+    geo_plan_run(&plan, n, x, y, h, ox, oy, oh, NULL);
+  }
+};
+
+} // namespace geo
+
+#endif //_GEO_HPP_DEFINED
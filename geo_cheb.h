@@ -0,0 +1,192 @@
+// GK - Converter between Gauss-Krueger/TM and WGS84 coordinates for Slovenia
+// Copyright (c) 2014-2019 Matjaz Rihtar <matjaz@eunet.si>
+// All rights reserved.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see http://www.gnu.org/licenses/
+//
+// geo_cheb.h: Chebyshev approximation of transformations 1-6 for Slovenia
+// (generated with gk-slo -gc, don't edit)
+//
+GEO_CHEB geo_cheb[6] = {
+{1, 7, 2, {7, 7, 0, 0, 0, 0, 0, 0}, 110219.78549878718, 500000, 1.0204797503699432e-05, 7.2797841111417016e-06, 1.144e-07, { // max. deviation 1.144e-07 m
+  {46.124809442687166,4.3977167586540926e-15,0.88147546156704115,-0.0069110448283122477,
+   1.30759600678074e-15,-3.5823124810695374e-05,4.6752725148103818e-15,-0.00021138616610780512,
+   -9.7452909939319305e-16,-9.4816633741976215e-09,5.4732268453847351e-07,2.0970879354030734e-16,
+   -1.6727795966916166e-06,1.0732155904709846e-15,4.9986417474359413e-10,4.1386647195748892e-15,
+   2.9924897572265586e-08,5.057682667736824e-16,-1.7572185632512099e-08,-7.4014868308343765e-17,
+   -1.8948978189017554e-12,-5.3961125691238801e-11,-3.8241015292644283e-16,5.4192401183823024e-10,
+   5.9211894646675012e-16,-1.732047468413119e-10,-1.5543122344752192e-15,-3.42627161210708e-14,
+   4.6259292692714859e-16,-4.8281255536784962e-12,-2.7138785046392718e-16,8.8972779761004663e-12,
+   4.0708177569589072e-16,-1.7392260471322313e-12,-5.3043988954313034e-16,-3.8857805861880479e-15},
+  {14.999999999999993,1.777720658826877,1.0800002867325828e-14,-7.1701903673708023e-16,
+   0.028357652708787984,-5.2920630840465792e-15,-0.00010854390560758536,3.8857805861880479e-16,
+   0.00033097300724686346,-2.1896065207885031e-15,-1.2274132327800342e-15,-6.2824237990014948e-06,
+   -7.0930915462162773e-17,3.1922894539737623e-06,-5.4200471271630904e-15,1.2584420858780593e-08,
+   0,-1.27764296152059e-07,1.5419764230904951e-16,3.2448407482559773e-08,
+   4.7909207465421687e-15,-1.6761283718993682e-15,1.2535755674244105e-09,1.5111368946286853e-16,
+   -2.122755832223433e-09,-4.3175339846533866e-17,3.2329370045245143e-10,-3.5002864804154242e-15,
+   -1.7723076093132148e-12,-9.8686491077791687e-17,3.7708385796580361e-11,5.2427198385076835e-17,
+   -3.1929307963017725e-11,-3.3923481307990897e-17,3.240028615773364e-12,2.2651633655199375e-15}
+}},
+{2, 6, 2, {6, 6, 0, 0, 0, 0, 0, 0}, 46.125, 15, 1.1428571428571428, 0.5714285714285714, 3.071e-07, { // max. deviation 3.071e-07 m
+  {110217.05414354462,1.2287652377077999e-11,97248.953400388418,744.34743393192082,
+   1.5834050120449521e-11,3.5645337291146024,7.3043793236138299e-12,-0.86056269780189298,
+   -1.1652900866465643e-12,-0.00055861323554987996,0.027429135339502864,2.9305940390461022e-12,
+   -0.17365348446938988,8.1791363805273757e-13,-6.9342181736449973e-05,7.5238580797708388e-12,
+   -0.001369019146361931,-3.5337658725135648e-12,2.9630995802184163e-05,3.8527206116769873e-12,
+   1.1915785888858308e-09,-2.0991985631250525e-08,4.5790531860095346e-12,-5.1171333521122306e-06,
+   -4.1116739642651128e-12,3.3771079649290591e-06,1.3800318912318391e-12,7.6018283026415801e-10},
+  {500000,135233.12563505411,6.8641586242140163e-10,-1.768461920114027e-11,
+   -2141.5826913821734,-4.9516933763192758e-11,-0.19782274065760752,1.3743475493457582e-11,
+   -7.9380411859259157,-6.871737746728791e-12,-3.80471950241675e-11,-0.15778798937036401,
+   -4.7495834425919587e-12,0.020448490105182928,-1.4663075691916877e-10,-0.00019024087967207178,
+   3.233758939637078e-12,0.0013389988927075239,6.5685728461378151e-12,4.0867533546891842e-05,
+   -7.9126039054244757e-11,-4.7142142041896782e-11,1.9245463691832913e-07,-4.9516933763192761e-12,
+   1.0527387530601118e-05,-1.616879469818539e-12,-4.9875375730658156e-08,-4.2443086082736654e-12}
+}},
+{3, 7, 6, {7, 7, 7, 3, 3, 0, 0, 0}, 109700.7064666911, 500000, 1.0205936274208799e-05, 7.2806655075524797e-06, 9.274e-06, { // max. deviation 9.274e-06 m
+  {46.124508606764898,4.5166044090852145e-05,0.88138657454349412,-0.0069093369997591282,
+   8.1913256554254513e-07,-3.5871122085757217e-05,-4.9567494491636274e-09,-0.00021132271790920884,
+   8.7509216909846064e-09,-8.5932468424982425e-09,5.470873011281796e-07,-2.6741138932824998e-10,
+   -1.6720690606048589e-06,8.6055360368517436e-11,5.0031955738876688e-10,7.3398077739107574e-13,
+   2.9909093041741784e-08,-5.2566963128065757e-12,-1.7563336069454433e-08,8.6754060725348207e-13,
+   -1.9121371153119071e-12,-5.3926579251455879e-11,6.8069007220906817e-14,5.4157571020378248e-10,
+   -8.617797833368159e-14,-1.730964507531654e-10,8.5487172896137054e-15,-2.6127248512845352e-14,
+   6.3529428631328403e-16,-4.8244864893200023e-12,1.9243865760169379e-15,8.8904439365933285e-12,
+   -1.2335811384723961e-15,-1.7380911524848368e-12,1.603655480014115e-16,-6.7230172046745588e-16},
+  {14.995208056680061,1.777514672333538,-4.6313925031463451e-05,7.8013375140462138e-07,
+   0.028350759506645673,-3.961479462953764e-07,-0.00010850750792166612,4.8043365970714312e-08,
+   0.00033086836276047558,-4.0620478323575666e-09,-1.5641247402214337e-10,-6.279614185367155e-06,
+   9.5254968727568711e-10,3.1909233428205496e-06,-4.0220914561868902e-11,1.2577310270427905e-08,
+   -1.5688120555721084e-11,-1.2769459058358122e-07,1.5933026503094853e-11,3.2431332030396433e-08,
+   -4.0596846871841937e-13,2.9262086580988329e-14,1.2527352612047418e-09,-4.7079007359229763e-13,
+   -2.1213738913653892e-09,2.3940725944903026e-13,3.2308904625762597e-10,-6.0152500264760219e-15,
+   -1.770998471330011e-12,4.1047412382668981e-15,3.7679134503834338e-11,-1.0735239857556027e-14,
+   -3.1905388824742746e-11,3.253570252720945e-15,3.236978586408491e-12,4.9728739644668467e-15},
+  {46.251952288773786,-0.76536181104944456,1.6130303110448607,-0.08159906528850093,
+   0.00024934395868217131,-0.038002130510219695,2.8550135946739078e-05,-0.00029241490273956838,
+   -8.6196268271147381e-07,-4.3071373074576869e-05,4.1344029959527398e-06,-3.0845349657187484e-08,
+   4.4370013224536026e-06,-3.5379452084032752e-09,1.9400153708184734e-07,-1.2563594855821394e-09,
+   1.9264233220973715e-08,1.4444290208359689e-10,8.6347062463095394e-09,5.3066575824958467e-11,
+   3.6701105117960725e-10,-2.0937376523890963e-10,-2.3707825825959441e-11,-1.9961427572607388e-10,
+   -6.1631601057222776e-11,2.1622000486350618e-11,-7.1216970592363149e-11,3.2114841650196818e-11,
+   7.944065158780076e-12,-3.6399068944111455e-11,-3.3285362120870507e-11,-3.3544426495761094e-11,
+   1.6985906508498121e-11,3.9352743286258374e-11,-1.0264949384324811e-11,-3.9055314537961294e-11},
+  {-1.4826806705386323e-10,-1.1428571509933543e-12,1.396696264166818e-11,-2.110041968511161e-13,
+   -3.35607475112369e-14,2.2533527454951371e-14,1.7531618052532923e-16,-8.7713781531711874e-15,
+   -2.6450095726649055e-16,-1.4633277759825469e-16},
+  {7.2078836963073073e-11,2.5982123496019822e-11,1.1250092946255968e-12,-2.6164226292137024e-14,
+   8.2662850850536037e-13,1.3286700508381163e-14,-4.2480260747197008e-15,-1.5113188274639061e-15,
+   1.294208414850485e-14,1.2775029040441906e-16},
+  {1.0000179195313752}
+}},
+{4, 6, 6, {6, 6, 6, 2, 2, 0, 0, 0}, 46.125, 15, 1.1428571428571428, 0.5714285714285714, 1.004e-05, { // max. deviation 1.004e-05 m
+  {109731.58596930867,3.2108777349701745,97247.920191868543,744.32770409715908,
+   0.057341800010255559,3.5705659347886956,0.00047135556683978547,-0.85889161912181877,
+   -0.0012329638886272834,-0.00065382190583957508,0.027433170693121331,-1.4811509733666147e-05,
+   -0.17367178854499976,-2.2547957946193896e-06,-6.9425481852489516e-05,1.2346426893196217e-08,
+   -0.0013690899206943009,-1.8665499763099231e-07,2.9555662229717604e-05,2.3920348566106341e-08,
+   1.503888963977968e-09,-2.0690671299740238e-08,-2.5259952154657288e-09,-5.121350341141806e-06,
+   2.8529017173342357e-09,3.3784158404159825e-06,2.4559514915583551e-11,5.8441824219496796e-10},
+  {500370.32605608169,135231.68390148893,-2.3107136189231721,0.019963645644414402,
+   -2141.5260519651692,-0.019536439666555654,-0.19743460546007757,-0.0020336688561049718,
+   -7.9390165546188252,2.161164072984118e-05,-2.5716864102933969e-06,-0.15781118540851619,
+   7.8535119124959838e-06,0.020452629029225337,9.7198961965558638e-08,-0.00019025075577398334,
+   -8.8717772289075782e-08,0.0013390077608871958,1.566242847022497e-07,4.0904179412690508e-05,
+   2.7284841053187847e-12,-3.3231925853114164e-10,1.9028033825129063e-07,4.1470937301508251e-09,
+   1.0531239543828027e-05,-4.5686950519060093e-10,-4.9984515094870908e-08,-4.3049415883918605e-11},
+  {-46.252677692091112,0.75436089981471133,-1.6033943191770283,0.06685275925841716,
+   -0.012186220759248098,0.037371501737819807,-2.9327866322444624e-05,-0.0010634468591474617,
+   -4.1565468934104092e-05,4.5034689787775634e-05,-1.2995241640124789e-06,4.7383753528270251e-07,
+   -3.8797474689476902e-06,1.1800543602773988e-07,-1.8265753288905353e-07,3.6182354026495189e-10,
+   2.0668686108295098e-08,1.6088540129762425e-09,1.0282118823035091e-08,1.3096141455232807e-10,
+   -6.0205191449508932e-10,1.5621948179500578e-12,-1.5728258202014129e-11,9.395544835971098e-11,
+   4.5079989124335246e-12,9.1380976859530464e-11,4.368727601899991e-13,1.9805441237647554e-11},
+  {1.6455738661736419e-05,2.4590964701953401e-09,-1.5392949910557286e-06,-1.0971298800334904e-08,
+   -7.6959270187393364e-11,-2.6516248844592002e-09},
+  {-5.5764376686637608e-06,-2.3390211133794947e-06,1.816559977302665e-09,-3.0571196420280611e-11,
+   2.8726059003358139e-08,-5.3087861534594642e-12},
+  {0.99998208040859127}
+}},
+{5, 5, 8, {5, 5, 5, 1, 1, 0, 5, 5}, 109700.7064666911, 500000, 1.0205936274208799e-05, 7.2806655075524797e-06, 6.333e-05, { // max. deviation 6.333e-05 m
+  {110186.18249651666,-3.2617479816979196,97983.232901487951,0.012175672464492335,
+   -0.11072755685759085,-0.0061801640261367969,-6.4928254870564065e-05,-0.001145436531572841,
+   0.00019735681230612399,9.7769057797828893e-05,2.9881863225808854e-07,-2.1133627525513375e-06,
+   -1.9377242463431485e-06,1.0758931870845522e-06,7.6656050396195496e-08,-4.5070673119577503e-10,
+   -1.1640028990061385e-08,4.6116970982742105e-09,1.1689871194499169e-08,-1.1657416760297363e-09,
+   -2.0934641674506971e-10},
+  {499629.66863166046,137351.54599406465,2.3270685649483513,-0.03881598168926656,
+   -0.034641299876057019,0.01974869252919436,-0.00026866266014419834,0.00027707220720508811,
+   0.00081792528777037258,-2.3466762639954039e-05,-3.6951471176709879e-07,-1.7925588811825339e-06,
+   2.261862694770874e-06,9.0287236768441892e-07,-9.5926477822811449e-08,8.5627915622252555e-09,
+   3.2740798714156778e-09,1.6449929616000091e-08,-3.2864085773730443e-09,-4.2479465870807571e-09,
+   6.0885617535354361e-11},
+  {46.251952288773786,-0.76536181104944456,1.6130303110448607,-0.08159906528850093,
+   0.00024934395868217131,-0.038002130510219695,2.8550135946739078e-05,-0.00029241490273956838,
+   -8.6196268271147381e-07,-4.3071373074576869e-05,4.1344029959527398e-06,-3.0845349657187484e-08,
+   4.4370013224536026e-06,-3.5379452084032752e-09,1.9400153708184734e-07,-1.2563594855821394e-09,
+   1.9264233220973715e-08,1.4444290208359689e-10,8.6347062463095394e-09,5.3066575824958467e-11,
+   3.6701105117960725e-10},
+  {-1.6456516070320494e-05,-2.5799717149972393e-09,1.5509241831228026e-06},
+  {5.5697217823333429e-06,2.3757302451202798e-06,-1.792198855307837e-09},
+  {1.0000179195313752},
+  {46.124508606764898,4.5166044090852145e-05,0.88138657454349412,-0.0069093369997591282,
+   8.1913256554254513e-07,-3.5871122085757217e-05,-4.9567494491636274e-09,-0.00021132271790920884,
+   8.7509216909846064e-09,-8.5932468424982425e-09,5.470873011281796e-07,-2.6741138932824998e-10,
+   -1.6720690606048589e-06,8.6055360368517436e-11,5.0031955738876688e-10,7.3398077739107574e-13,
+   2.9909093041741784e-08,-5.2566963128065757e-12,-1.7563336069454433e-08,8.6754060725348207e-13,
+   -1.9121371153119071e-12},
+  {14.995208056680061,1.777514672333538,-4.6313925031463451e-05,7.8013375140462138e-07,
+   0.028350759506645673,-3.961479462953764e-07,-0.00010850750792166612,4.8043365970714312e-08,
+   0.00033086836276047558,-4.0620478323575666e-09,-1.5641247402214337e-10,-6.279614185367155e-06,
+   9.5254968727568711e-10,3.1909233428205496e-06,-4.0220914561868902e-11,1.2577310270427905e-08,
+   -1.5688120555721084e-11,-1.2769459058358122e-07,1.5933026503094853e-11,3.2431332030396433e-08,
+   -4.0596846871841937e-13}
+}},
+{6, 5, 8, {5, 5, 5, 2, 2, 0, 4, 5}, 110219.78549878718, 500000, 1.0204797503699432e-05, 7.2797841111417016e-06, 9.480e-06, { // max. deviation 9.480e-06 m
+  {109734.31702819132,3.2619918600719178,97992.083796520106,-0.012172719332577723,
+   0.11076314804024731,0.0061812112858569256,6.4955091340203173e-05,0.0011457720096075263,
+   -0.00019743524469756975,-9.7832852653646616e-05,-2.9621963430296699e-07,2.1170212770963794e-06,
+   1.9379830481132862e-06,-1.0776626248166899e-06,-7.6824103227105908e-08,5.0597116619933835e-10,
+   1.161646107700815e-08,-4.5987336408062322e-09,-1.1740648157380443e-08,1.1140899560915487e-09,
+   4.4511081240569994e-10},
+  {500370.32688233629,137365.24665505125,-2.3272030209497845,0.038827893317021439,
+   0.034640516246225966,-0.019755282492345334,0.0002687718607982485,-0.00027718704485677235,
+   -0.00081832905794322467,2.3475566447612233e-05,3.7012715539377598e-07,1.7924812709679827e-06,
+   -2.2656993476428197e-06,-9.0345464640348735e-07,9.6102515575087935e-08,1.1574886432046899e-08,
+   -3.2712503323434956e-09,-1.6583423227226984e-08,3.2638733197624483e-09,4.2218744056299329e-09,
+   9.9134922493249178e-11},
+  {-46.249640909384148,0.76625890656573648,-1.6131272823108957,0.081615593869164005,
+   -0.00024833680895280312,0.038008963398069986,-2.8596784722858784e-05,0.00029250296209638719,
+   8.5068561856477879e-07,4.3089714507184139e-05,-4.1358249315467015e-06,3.0695522161098644e-08,
+   -4.4389027867359273e-06,3.6194254630454261e-09,-1.9408980404965624e-07,1.2591915843351842e-09,
+   -1.9269386148441154e-08,-4.7051177768745824e-11,-8.5265403256447793e-09,-1.0195190370944197e-11,
+   -4.0762642644014907e-10},
+  {1.6455679186846156e-05,2.4977733092325329e-09,-1.5510533386754632e-06,8.3270155461249342e-10,
+   -3.8893149347355379e-11,-2.6378766201442494e-09},
+  {-5.5764391161498271e-06,-2.3759600725653612e-06,1.8290086059949084e-09,-4.5891404652058146e-11,
+   -8.5165411515007501e-09,-5.4440693881182576e-12},
+  {0.99998208040849001},
+  {46.124809442687166,4.3977167586540926e-15,0.88147546156704115,-0.0069110448283122477,
+   1.30759600678074e-15,-3.5823124810695374e-05,4.6752725148103818e-15,-0.00021138616610780512,
+   -9.7452909939319305e-16,-9.4816633741976215e-09,5.4732268453847351e-07,2.0970879354030734e-16,
+   -1.6727795966916166e-06,1.0732155904709846e-15,4.9986417474359413e-10},
+  {14.999999999999993,1.777720658826877,1.0800002867325828e-14,-7.1701903673708023e-16,
+   0.028357652708787984,-5.2920630840465792e-15,-0.00010854390560758536,3.8857805861880479e-16,
+   0.00033097300724686346,-2.1896065207885031e-15,-1.2274132327800342e-15,-6.2824237990014948e-06,
+   -7.0930915462162773e-17,3.1922894539737623e-06,-5.4200471271630904e-15,1.2584420858780593e-08,
+   0,-1.27764296152059e-07,1.5419764230904951e-16,3.2448407482559773e-08,
+   4.7909207465421687e-15}
+}}
+};
@@ -0,0 +1,1397 @@
+// GK - Converter between Gauss-Krueger/TM and WGS84 coordinates for Slovenia
+// Copyright (c) 2014-2019 Matjaz Rihtar <matjaz@eunet.si>
+// All rights reserved.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see http://www.gnu.org/licenses/
+//
+// geo_simd.c: Vectorized (SSE2/AVX2/AVX-512) coordinate conversion kernels
+//
+// This file is compiled once for each instruction set: with default flags
+// (SSE2, also contains run-time dispatch) and with -DGEO_SIMD_VARIANT and
+// -mavx2 -mfma or -mavx512f -mfma for kernels selected at run time by cpuid.
+//
+#include "common.h"
+#include "geo.h"
+#include <pthread.h>
+
+#ifdef _MSC_VER
+#define INLINE __inline
+#else
+#define INLINE inline
+#endif
+
+// Select vector instruction set (determined by compiler flags)
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define VLEN 8 // number of doubles in vector
+#define VNAME "AVX-512"
+#define VKERNELS geo_simd_avx512
+typedef __m512d vdbl;
+typedef __m512i vint;
+#define vset1(a)     _mm512_set1_pd(a)
+#define vload(p)     _mm512_loadu_pd(p)
+#define vstore(p, a) _mm512_storeu_pd(p, a)
+#define vadd         _mm512_add_pd
+#define vsub         _mm512_sub_pd
+#define vmul         _mm512_mul_pd
+#define vdiv         _mm512_div_pd
+#define vsqrt        _mm512_sqrt_pd
+#define vbits        _mm512_castpd_si512
+#define vdbls        _mm512_castsi512_pd
+#define vand(a, b)   vdbls(_mm512_and_si512(vbits(a), vbits(b)))    // no AVX512DQ
+#define vandnot(a, b) vdbls(_mm512_andnot_si512(vbits(a), vbits(b)))
+#define vor(a, b)    vdbls(_mm512_or_si512(vbits(a), vbits(b)))
+#define vxor(a, b)   vdbls(_mm512_xor_si512(vbits(a), vbits(b)))
+#define vmin         _mm512_min_pd
+#define vmax         _mm512_max_pd
+#define vcmpgt(a, b) vdbls(_mm512_maskz_set1_epi64(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ), -1))
+#define viadd        _mm512_add_epi64
+#define visub        _mm512_sub_epi64
+#define viand        _mm512_and_si512
+#define vislli       _mm512_slli_epi64
+#define visrli       _mm512_srli_epi64
+#define viset1(a)    _mm512_set1_epi64(a)
+#define vcmpge(a, b) vdbls(_mm512_maskz_set1_epi64(_mm512_cmp_pd_mask(a, b, _CMP_GE_OQ), -1))
+typedef __m256i vidx; // 32-bit indexes
+#define vtoidx       _mm512_cvttpd_epi32
+#define vfromidx     _mm512_cvtepi32_pd
+#define vidxeq(i, k) (_mm256_movemask_epi8(_mm256_cmpeq_epi32(i, _mm256_set1_epi32(k))) == -1)
+#define vidx0(i)     _mm_cvtsi128_si32(_mm256_castsi256_si128(i))
+#define FLEN 16 // number of floats in vector
+typedef __m512 vflt;
+#define fset1(a)     _mm512_set1_ps(a)
+#define fload(p)     _mm512_loadu_ps(p)
+#define fstore(p, a) _mm512_storeu_ps(p, a)
+#define fadd         _mm512_add_ps
+#define fsub         _mm512_sub_ps
+#define fmul         _mm512_mul_ps
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define VLEN 4 // number of doubles in vector
+#define VNAME "AVX2"
+#define VKERNELS geo_simd_avx2
+typedef __m256d vdbl;
+typedef __m256i vint;
+#define vset1(a)     _mm256_set1_pd(a)
+#define vload(p)     _mm256_loadu_pd(p)
+#define vstore(p, a) _mm256_storeu_pd(p, a)
+#define vadd         _mm256_add_pd
+#define vsub         _mm256_sub_pd
+#define vmul         _mm256_mul_pd
+#define vdiv         _mm256_div_pd
+#define vsqrt        _mm256_sqrt_pd
+#define vand         _mm256_and_pd
+#define vandnot      _mm256_andnot_pd
+#define vor          _mm256_or_pd
+#define vxor         _mm256_xor_pd
+#define vmin         _mm256_min_pd
+#define vmax         _mm256_max_pd
+#define vcmpgt(a, b) _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define vbits        _mm256_castpd_si256
+#define vdbls        _mm256_castsi256_pd
+#define viadd        _mm256_add_epi64
+#define visub        _mm256_sub_epi64
+#define viand        _mm256_and_si256
+#define vislli       _mm256_slli_epi64
+#define visrli       _mm256_srli_epi64
+#define viset1(a)    _mm256_set1_epi64x(a)
+#define vcmpge(a, b) _mm256_cmp_pd(a, b, _CMP_GE_OQ)
+typedef __m128i vidx; // 32-bit indexes
+#define vtoidx       _mm256_cvttpd_epi32
+#define vfromidx     _mm256_cvtepi32_pd
+#define vidxeq(i, k) (_mm_movemask_epi8(_mm_cmpeq_epi32(i, _mm_set1_epi32(k))) == 0xFFFF)
+#define vidx0(i)     _mm_cvtsi128_si32(i)
+#define FLEN 8 // number of floats in vector
+typedef __m256 vflt;
+#define fset1(a)     _mm256_set1_ps(a)
+#define fload(p)     _mm256_loadu_ps(p)
+#define fstore(p, a) _mm256_storeu_ps(p, a)
+#define fadd         _mm256_add_ps
+#define fsub         _mm256_sub_ps
+#define fmul         _mm256_mul_ps
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VLEN 2 // number of doubles in vector
+#define VNAME "SSE2"
+#define VKERNELS geo_simd_base
+typedef __m128d vdbl;
+typedef __m128i vint;
+#define vset1(a)     _mm_set1_pd(a)
+#define vload(p)     _mm_loadu_pd(p)
+#define vstore(p, a) _mm_storeu_pd(p, a)
+#define vadd         _mm_add_pd
+#define vsub         _mm_sub_pd
+#define vmul         _mm_mul_pd
+#define vdiv         _mm_div_pd
+#define vsqrt        _mm_sqrt_pd
+#define vand         _mm_and_pd
+#define vandnot      _mm_andnot_pd
+#define vor          _mm_or_pd
+#define vxor         _mm_xor_pd
+#define vmin         _mm_min_pd
+#define vmax         _mm_max_pd
+#define vcmpgt       _mm_cmpgt_pd
+#define vbits        _mm_castpd_si128
+#define vdbls        _mm_castsi128_pd
+#define viadd        _mm_add_epi64
+#define visub        _mm_sub_epi64
+#define viand        _mm_and_si128
+#define vislli       _mm_slli_epi64
+#define visrli       _mm_srli_epi64
+#define viset1(a)    _mm_set_epi32(0, (int)(a), 0, (int)(a))
+#define vcmpge       _mm_cmpge_pd
+typedef __m128i vidx; // 32-bit indexes (lower two)
+#define vtoidx       _mm_cvttpd_epi32
+#define vfromidx     _mm_cvtepi32_pd
+#define vidxeq(i, k) ((_mm_movemask_epi8(_mm_cmpeq_epi32(i, _mm_set1_epi32(k))) & 0xFF) == 0xFF)
+#define vidx0(i)     _mm_cvtsi128_si32(i)
+#define FLEN 4 // number of floats in vector
+typedef __m128 vflt;
+#define fset1(a)     _mm_set1_ps(a)
+#define fload(p)     _mm_loadu_ps(p)
+#define fstore(p, a) _mm_storeu_ps(p, a)
+#define fadd         _mm_add_ps
+#define fsub         _mm_sub_ps
+#define fmul         _mm_mul_ps
+#else // no vector unit, use scalar code with the same kernels
+#define VLEN 1
+#define VNAME "scalar"
+#define VKERNELS geo_simd_base
+#define NO_SIMD
+typedef double vdbl;
+#define vset1(a)     (a)
+#define vload(p)     (*(p))
+#define vstore(p, a) (*(p) = (a))
+#define vadd(a, b)   ((a) + (b))
+#define vsub(a, b)   ((a) - (b))
+#define vmul(a, b)   ((a) * (b))
+#define vdiv(a, b)   ((a) / (b))
+#define vsqrt(a)     sqrt(a)
+#define FLEN 1
+typedef float vflt;
+#define fset1(a)     (a)
+#define fload(p)     (*(p))
+#define fstore(p, a) (*(p) = (a))
+#define fadd(a, b)   ((a) + (b))
+#define fsub(a, b)   ((a) - (b))
+#define fmul(a, b)   ((a) * (b))
+#endif
+#ifndef NO_SIMD
+#define vsel(m, a, b) vor(vand(m, a), vandnot(m, b)) // m ? a : b
+#endif
+
+// global variables
+extern ELLIPSOID ellips[3]; // in geo.c
+extern PROJ tm;             // in geo.c
+extern GEO_GEOID geoids[3]; // in geo.c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Kernels compiled for one instruction set
+typedef struct geo_simd {
+  const char *name;
+  int width; // number of points processed together
+  void (*fila2xy)(const PROJ *pj, int n, const double *fi, const double *la,
+                  double *x, double *y, int oid);
+  void (*xy2fila)(const PROJ *pj, int n, const double *x, const double *y,
+                  double *fi, double *la, int oid);
+  void (*helmert)(int n, const double *fi, const double *la, const double *h,
+                  double *ofi, double *ola, double *oh, HELMERT7 h7, int iid, int oid);
+  void (*chebf)(int n, int deg, const float *c0, const float *c1,
+                const float *u, const float *v, float *ou, float *ov);
+  void (*geoid)(const GEO_GEOID *g, int n, const double *fi, const double *la,
+                double *Ng);
+  void (*cheb)(const GEO_CHEB *ch, unsigned mask, int n, const double *u, const double *v,
+               double *val);
+  void (*krfila2xy)(const PROJ *pj, int n, const double *fi, const double *la,
+                    double *x, double *y, int oid);
+  void (*krxy2fila)(const PROJ *pj, int n, const double *x, const double *y,
+                    double *fi, double *la, int oid);
+} GEO_SIMD;
+
+// ----------------------------------------------------------------------------
+// vsincos
+// Sine and cosine of vector x (Cephes polynomials, |error| < 1e-16)
+// ----------------------------------------------------------------------------
+static INLINE void vsincos(vdbl x, vdbl *s, vdbl *c)
+{
+#ifdef NO_SIMD
+  *s = sin(x); *c = cos(x);
+#else
+  const double magic = 6755399441055744.0; // 1.5*2^52
+  vdbl q, r, z, ps, pc, swap, sgns, sgnc, sign;
+  vint iq, one;
+
+  // q = round(x/(pi/2)), integer part stays in low mantissa bits of q+magic
+  q = vadd(vmul(x, vset1(2.0/M_PI)), vset1(magic));
+  iq = vbits(q);
+  q = vsub(q, vset1(magic));
+
+  // Cody-Waite reduction to r in [-pi/4, pi/4]
+  r = vsub(x, vmul(q, vset1(1.57079625129699707031e+00)));
+  r = vsub(r, vmul(q, vset1(7.54978941586159635335e-08)));
+  r = vsub(r, vmul(q, vset1(5.39030285815811905290e-15)));
+  z = vmul(r, r);
+
+  ps = vset1(1.58962301576546568060e-10);
+  ps = vadd(vmul(ps, z), vset1(-2.50507477628578072866e-08));
+  ps = vadd(vmul(ps, z), vset1(2.75573136213857245213e-06));
+  ps = vadd(vmul(ps, z), vset1(-1.98412698295895385996e-04));
+  ps = vadd(vmul(ps, z), vset1(8.33333333332211858878e-03));
+  ps = vadd(vmul(ps, z), vset1(-1.66666666666666307295e-01));
+  ps = vadd(r, vmul(vmul(r, z), ps));
+
+  pc = vset1(-1.13585365213876817300e-11);
+  pc = vadd(vmul(pc, z), vset1(2.08757008419747316778e-09));
+  pc = vadd(vmul(pc, z), vset1(-2.75573141792967388112e-07));
+  pc = vadd(vmul(pc, z), vset1(2.48015872888517045348e-05));
+  pc = vadd(vmul(pc, z), vset1(-1.38888888888730564116e-03));
+  pc = vadd(vmul(pc, z), vset1(4.16666666666665929218e-02));
+  pc = vadd(vsub(vset1(1.0), vmul(z, vset1(0.5))), vmul(vmul(z, z), pc));
+
+  // Quadrant: bit 0 swaps sin/cos, bit 1 negates sin, bit 1 of q+1 negates cos
+  one = viset1(1);
+  sign = vset1(-0.0);
+  swap = vdbls(visub(viset1(0), viand(iq, one)));
+  sgns = vand(vdbls(vislli(iq, 62)), sign);
+  sgnc = vand(vdbls(vislli(viadd(iq, one), 62)), sign);
+  *s = vxor(vor(vand(swap, pc), vandnot(swap, ps)), sgns);
+  *c = vxor(vor(vand(swap, ps), vandnot(swap, pc)), sgnc);
+#endif
+} /* vsincos */
+
+
+// ----------------------------------------------------------------------------
+// vatan2
+// Arc tangent of vector y/x in range [-pi, pi] (Cephes polynomial)
+// ----------------------------------------------------------------------------
+static INLINE vdbl vatan2(vdbl y, vdbl x)
+{
+#ifdef NO_SIMD
+  return atan2(y, x);
+#else
+  const double morebits = 6.123233995736765886130e-17; // pi/2 = PIO2 + morebits
+  vdbl ax, ay, sign, swap, big, q, z, p, r;
+
+  sign = vset1(-0.0);
+  ax = vandnot(sign, x); ay = vandnot(sign, y);
+
+  // Reduce to atan(q), q = min/max in [0, 1] and further to |q| < 0.66
+  swap = vcmpgt(ay, ax);
+  q = vdiv(vmin(ax, ay), vmax(ax, ay));
+  big = vcmpgt(q, vset1(0.66));
+  q = vsel(big, vdiv(vsub(q, vset1(1.0)), vadd(q, vset1(1.0))), q);
+
+  z = vmul(q, q);
+  p = vset1(-8.750608600031904122785e-01);
+  p = vadd(vmul(p, z), vset1(-1.615753718733365076637e+01));
+  p = vadd(vmul(p, z), vset1(-7.500855792314704667340e+01));
+  p = vadd(vmul(p, z), vset1(-1.228866684490136173410e+02));
+  p = vadd(vmul(p, z), vset1(-6.485021904942025371773e+01));
+  r = vadd(z, vset1(2.485846490142306297962e+01));
+  r = vadd(vmul(r, z), vset1(1.650270098316988542046e+02));
+  r = vadd(vmul(r, z), vset1(4.328810604912902668951e+02));
+  r = vadd(vmul(r, z), vset1(4.853903996359136964868e+02));
+  r = vadd(vmul(r, z), vset1(1.945506571482613964425e+02));
+  r = vadd(q, vmul(vmul(q, z), vdiv(p, r)));
+  r = vadd(r, vand(big, vset1(M_PI/4.0 + 0.5*morebits)));
+
+  // Back to full range: swapped octant, negative x, sign of y
+  r = vsel(swap, vsub(vset1(M_PI/2.0 + morebits), r), r);
+  r = vsel(vcmpgt(vset1(0.0), x), vsub(vset1(M_PI + 2.0*morebits), r), r);
+  return vor(r, vand(sign, y));
+#endif
+} /* vatan2 */
+
+
+// ----------------------------------------------------------------------------
+// vexp
+// Exponential of vector x (|x| < 700, Taylor series to x^13 after reduction
+// to |r| < ln2/2, |error| < 1e-16)
+// ----------------------------------------------------------------------------
+static INLINE vdbl vexp(vdbl x)
+{
+#ifdef NO_SIMD
+  return exp(x);
+#else
+  static const double ifact[14] = { 1.0, 1.0, 1.0/2.0, 1.0/6.0, 1.0/24.0, 1.0/120.0,
+    1.0/720.0, 1.0/5040.0, 1.0/40320.0, 1.0/362880.0, 1.0/3628800.0, 1.0/39916800.0,
+    1.0/479001600.0, 1.0/6227020800.0 }; // 1/k!
+  const double magic = 6755399441055744.0; // 1.5*2^52
+  vdbl q, r, p;
+  vint iq;
+  int k;
+
+  // q = round(x/ln2), integer part stays in low mantissa bits of q+magic
+  q = vadd(vmul(x, vset1(1.0/M_LN2)), vset1(magic));
+  iq = vbits(q);
+  q = vsub(q, vset1(magic));
+
+  // Cody-Waite reduction to r in [-ln2/2, ln2/2]
+  r = vsub(x, vmul(q, vset1(6.93145751953125e-01)));
+  r = vsub(r, vmul(q, vset1(1.42860682030941723212e-06)));
+
+  // exp(r) = sum r^k/k!, k = 0..13
+  p = vset1(ifact[13]);
+  for (k = 12; k >= 0; k--) p = vadd(vmul(p, r), vset1(ifact[k]));
+
+  // Multiply by 2^q (exponent field 1023 + q)
+  return vmul(p, vdbls(vislli(viadd(iq, viset1(1023)), 52)));
+#endif
+} /* vexp */
+
+
+// ----------------------------------------------------------------------------
+// vlog
+// Natural logarithm of vector x (x > 0 normal, atanh series of (m-1)/(m+1)
+// for mantissa m in [sqrt(2)/2, sqrt(2)], |error| < 2e-16)
+// ----------------------------------------------------------------------------
+static INLINE vdbl vlog(vdbl x)
+{
+#ifdef NO_SIMD
+  return log(x);
+#else
+  const double two52 = 4503599627370496.0; // 2^52
+  vdbl e, m, big, f, z, p;
+
+  // x = m*2^e, exponent field converted through 2^52 + field
+  e = vor(vdbls(visrli(vbits(x), 52)), vset1(two52));
+  e = vsub(e, vset1(two52 + 1023.0));
+  m = vor(vandnot(vset1(INFINITY), x), vset1(1.0));
+  big = vcmpgt(m, vset1(M_SQRT2));
+  m = vsel(big, vmul(m, vset1(0.5)), m);
+  e = vadd(e, vand(big, vset1(1.0)));
+
+  // log(m) = 2*atanh(f) = 2*f*sum z^k/(2k+1), z = f^2, k = 0..11
+  f = vdiv(vsub(m, vset1(1.0)), vadd(m, vset1(1.0)));
+  z = vmul(f, f);
+  p = vset1(1.0/23.0);
+  p = vadd(vmul(p, z), vset1(1.0/21.0));
+  p = vadd(vmul(p, z), vset1(1.0/19.0));
+  p = vadd(vmul(p, z), vset1(1.0/17.0));
+  p = vadd(vmul(p, z), vset1(1.0/15.0));
+  p = vadd(vmul(p, z), vset1(1.0/13.0));
+  p = vadd(vmul(p, z), vset1(1.0/11.0));
+  p = vadd(vmul(p, z), vset1(1.0/9.0));
+  p = vadd(vmul(p, z), vset1(1.0/7.0));
+  p = vadd(vmul(p, z), vset1(1.0/5.0));
+  p = vadd(vmul(p, z), vset1(1.0/3.0));
+  p = vmul(vmul(vset1(2.0), f), vadd(vset1(1.0), vmul(p, z)));
+
+  // e*ln2 with ln2 split in two parts
+  p = vadd(p, vmul(e, vset1(1.42860682030941723212e-06)));
+  return vadd(p, vmul(e, vset1(6.93145751953125e-01)));
+#endif
+} /* vlog */
+
+
+// ----------------------------------------------------------------------------
+// vasinh
+// Inverse hyperbolic sine of vector x (log(|x| + sqrt(x^2 + 1)) with sign
+// of x, absolute error < 3e-16)
+// ----------------------------------------------------------------------------
+static INLINE vdbl vasinh(vdbl x)
+{
+#ifdef NO_SIMD
+  return asinh(x);
+#else
+  vdbl sign, ax;
+
+  sign = vset1(-0.0);
+  ax = vandnot(sign, x);
+  ax = vlog(vadd(ax, vsqrt(vadd(vmul(ax, ax), vset1(1.0)))));
+  return vor(ax, vand(sign, x));
+#endif
+} /* vasinh */
+
+
+// ----------------------------------------------------------------------------
+// varc
+// Meridian arc length for vector fi
+// (Clenshaw summation of sin(2k*fi) series, s and c are sin/cos of fi)
+// ----------------------------------------------------------------------------
+static INLINE vdbl varc(vdbl fi, vdbl s, vdbl c, const ELLIPSOID *el)
+{
+  vdbl s2, c2f, b1, b2, b3;
+
+  s2 = vmul(vset1(2.0), vmul(s, c));                    // sin(2fi)
+  c2f = vmul(vset1(2.0), vmul(vsub(c, s), vadd(c, s))); // 2*cos(2fi)
+  b2 = vset1(el->arc[5]);
+  b1 = vadd(vset1(el->arc[4]), vmul(c2f, b2));
+  b3 = b2; b2 = b1;
+  b1 = vsub(vadd(vset1(el->arc[3]), vmul(c2f, b2)), b3);
+  b3 = b2; b2 = b1;
+  b1 = vsub(vadd(vset1(el->arc[2]), vmul(c2f, b2)), b3);
+  b3 = b2; b2 = b1;
+  b1 = vsub(vadd(vset1(el->arc[1]), vmul(c2f, b2)), b3);
+  return vadd(vmul(vset1(el->arc[0]), fi), vmul(b1, s2));
+} /* varc */
+
+
+// ----------------------------------------------------------------------------
+// vfila2xy
+// Transverse Mercator projection of one vector of points
+// (same series as fila_ellips2xy, fi and la in radians, without heights)
+// ----------------------------------------------------------------------------
+static INLINE void vfila2xy(vdbl fi, vdbl la, const ELLIPSOID *el, const PROJ *pj,
+                            vdbl *x, vdbl *y)
+{
+  vdbl s, c, c2, t2, ni2, N, dl, dl2, u, L;
+  vdbl p, q, one;
+
+  vsincos(fi, &s, &c);
+  one = vset1(1.0);
+
+  L = varc(fi, s, c, el); // meridian arc length
+
+  c2 = vmul(c, c);
+  t2 = vdiv(vmul(s, s), c2);
+  ni2 = vmul(vset1(el->e2_), c2);
+  N = vdiv(vset1(el->c), vsqrt(vadd(one, ni2)));
+
+  dl = vsub(la, vset1(pj->lambda0));
+  dl2 = vmul(dl, dl);
+  u = vmul(c2, dl2);
+
+  // x = L + N*s*c*dl^2*(1/2 + u*(X4 + u*(X6 + u*X8)))
+  p = vmul(vsub(vset1(1385.0), vmul(t2, vsub(vset1(3111.0),
+        vmul(t2, vsub(vset1(543.0), t2))))), vset1(1.0/40320.0));
+  q = vsub(vadd(vsub(vset1(61.0), vmul(vset1(58.0), t2)), vmul(t2, t2)),
+        vmul(ni2, vsub(vmul(vset1(330.0), t2), vset1(270.0))));
+  p = vadd(vmul(q, vset1(1.0/720.0)), vmul(u, p));
+  q = vadd(vsub(vset1(5.0), t2), vmul(ni2, vadd(vset1(9.0), vmul(vset1(4.0), ni2))));
+  p = vadd(vmul(q, vset1(1.0/24.0)), vmul(u, p));
+  p = vadd(vset1(0.5), vmul(u, p));
+  *x = vadd(L, vmul(vmul(vmul(N, vmul(s, c)), dl2), p));
+
+  // y = N*c*dl*(1 + u*(Y3 + u*(Y5 + u*Y7)))
+  p = vmul(vsub(vset1(61.0), vmul(t2, vsub(vset1(479.0),
+        vmul(t2, vsub(vset1(179.0), t2))))), vset1(1.0/5040.0));
+  q = vsub(vadd(vsub(vset1(5.0), vmul(vset1(18.0), t2)), vmul(t2, t2)),
+        vmul(ni2, vsub(vmul(vset1(58.0), t2), vset1(14.0))));
+  p = vadd(vmul(q, vset1(1.0/120.0)), vmul(u, p));
+  q = vadd(vsub(one, t2), ni2);
+  p = vadd(vmul(q, vset1(1.0/6.0)), vmul(u, p));
+  p = vadd(one, vmul(u, p));
+  *y = vmul(vmul(vmul(N, c), dl), p);
+
+  // Convert from real to relative coordinates
+  *x = vadd(vmul(*x, vset1(pj->scale)), vset1(pj->false_northing));
+  *y = vadd(vmul(*y, vset1(pj->scale)), vset1(pj->false_easting));
+} /* vfila2xy */
+
+
+// ----------------------------------------------------------------------------
+// fila_ellips2xy_vec (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform n points from fi,la to GK/TM x,y coordinates on specified
+// ellipsoid with projection constants pj (output arrays can be the same as
+// input arrays)
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+static void fila_ellips2xy_v(const PROJ *pj, int n, const double *fi, const double *la,
+                             double *x, double *y, int oid)
+{
+  const ELLIPSOID *el = &ellips[oid];
+  double tfi[VLEN], tla[VLEN], tx[VLEN], ty[VLEN];
+  vdbl vfi, vla, vx, vy, d2r;
+  int ii, jj;
+
+  d2r = vset1(M_PI/180.0); // degrees to radians
+
+  for (ii = 0; ii + VLEN <= n; ii += VLEN) {
+    vfi = vmul(vload(&fi[ii]), d2r);
+    vla = vmul(vload(&la[ii]), d2r);
+    vfila2xy(vfi, vla, el, pj, &vx, &vy);
+    vstore(&x[ii], vx); vstore(&y[ii], vy);
+  }
+
+  if (ii < n) { // remaining points (less than VLEN)
+    for (jj = 0; jj < VLEN; jj++) {
+      tfi[jj] = fi[ii + jj < n ? ii + jj : n - 1];
+      tla[jj] = la[ii + jj < n ? ii + jj : n - 1];
+    }
+    vfi = vmul(vload(tfi), d2r);
+    vla = vmul(vload(tla), d2r);
+    vfila2xy(vfi, vla, el, pj, &vx, &vy);
+    vstore(tx, vx); vstore(ty, vy);
+    for (jj = 0; ii + jj < n; jj++) {
+      x[ii + jj] = tx[jj]; y[ii + jj] = ty[jj];
+    }
+  }
+} /* fila_ellips2xy_v */
+
+
+// ----------------------------------------------------------------------------
+// vxy2fila
+// Inverse Transverse Mercator projection of one vector of points
+// (same series as xy2fila_ellips, fi and la in radians, without heights)
+// ----------------------------------------------------------------------------
+static INLINE void vxy2fila(vdbl x, vdbl y, const ELLIPSOID *el, const PROJ *pj,
+                            vdbl *fi, vdbl *la)
+{
+  vdbl fi0, ab2, s, c, c2, t, t2, t4, t6, ni2, ni4, N, v, p, q, one;
+  int n;
+
+  // Convert from relative to real coordinates
+  x = vdiv(vsub(x, vset1(pj->false_northing)), vset1(pj->scale));
+  y = vdiv(vsub(y, vset1(pj->false_easting)), vset1(pj->scale));
+
+  // Footpoint latitude with fixed number of iterations (same in all lanes).
+  // Iteration fi0 += 2*(x - L(fi0))/(a+b) contracts the error by factor
+  // |1 - 2*M(fi)/(a+b)| < 0.0051 (M = meridian radius of curvature) for all
+  // latitudes, starting error of first estimate is < 0.006 rad. After 6
+  // iterations error is < 0.006*0.0051^6 < 1e-16 rad (below double precision).
+  ab2 = vset1(2.0/(el->a + el->b));
+  fi0 = vmul(x, ab2); // first estimate
+  for (n = 0; n < 6; n++) {
+    vsincos(fi0, &s, &c);
+    fi0 = vadd(fi0, vmul(vsub(x, varc(fi0, s, c, el)), ab2));
+  }
+
+  vsincos(fi0, &s, &c);
+  one = vset1(1.0);
+  c2 = vmul(c, c);
+  t = vdiv(s, c);
+  t2 = vmul(t, t); t4 = vmul(t2, t2); t6 = vmul(t4, t2);
+  ni2 = vmul(vset1(el->e2_), c2);
+  ni4 = vmul(ni2, ni2);
+  N = vdiv(vset1(el->c), vsqrt(vadd(one, ni2)));
+  v = vdiv(vmul(y, y), vmul(N, N)); // (y/N)^2
+
+  // fi = fi0 + t*v*(F2 + v*(F4 + v*(F6 + v*F8)))
+  p = vmul(vadd(vadd(vset1(1385.0), vmul(vset1(3633.0), t2)),
+        vadd(vmul(vset1(4095.0), t4), vmul(vset1(1575.0), t6))), vset1(1.0/40320.0));
+  q = vadd(vsub(vsub(vsub(vset1(-61.0), vmul(vset1(90.0), t2)), vmul(vset1(45.0), t4)),
+        vmul(vset1(107.0), ni2)),
+        vmul(ni2, vadd(vmul(vset1(162.0), t2), vmul(vset1(45.0), t4))));
+  p = vadd(vmul(q, vset1(1.0/720.0)), vmul(v, p));
+  q = vsub(vsub(vadd(vadd(vset1(5.0), vmul(vset1(3.0), t2)), vmul(vset1(6.0), ni2)),
+        vmul(vmul(vset1(6.0), t2), ni2)),
+        vmul(ni4, vadd(vset1(3.0), vmul(vset1(9.0), t2))));
+  p = vadd(vmul(q, vset1(1.0/24.0)), vmul(v, p));
+  p = vadd(vmul(vadd(one, ni2), vset1(-0.5)), vmul(v, p));
+  *fi = vadd(fi0, vmul(vmul(t, v), p));
+
+  // la = lambda0 + y/(N*c)*(1 + v*(G3 + v*(G5 + v*G7)))
+  p = vmul(vsub(vsub(vsub(vset1(-61.0), vmul(vset1(662.0), t2)), vmul(vset1(1320.0), t4)),
+        vmul(vset1(720.0), t6)), vset1(1.0/5040.0));
+  q = vadd(vadd(vadd(vset1(5.0), vmul(vset1(28.0), t2)), vmul(vset1(24.0), t4)),
+        vmul(ni2, vadd(vmul(vset1(8.0), t2), vset1(6.0))));
+  p = vadd(vmul(q, vset1(1.0/120.0)), vmul(v, p));
+  q = vsub(vsub(vmul(vset1(-2.0), t2), one), ni2);
+  p = vadd(vmul(q, vset1(1.0/6.0)), vmul(v, p));
+  p = vadd(one, vmul(v, p));
+  *la = vadd(vset1(pj->lambda0), vmul(vdiv(y, vmul(N, c)), p));
+} /* vxy2fila */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_ellips_vec (heights not calculated)
+// ----------------------------------------------------------------------------
+// Transform n points from GK/TM x,y to fi,la coordinates on specified
+// ellipsoid with projection constants pj (output arrays can be the same as
+// input arrays)
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+static void xy2fila_ellips_v(const PROJ *pj, int n, const double *x, const double *y,
+                             double *fi, double *la, int oid)
+{
+  const ELLIPSOID *el = &ellips[oid];
+  double tx[VLEN], ty[VLEN], tfi[VLEN], tla[VLEN];
+  vdbl vx, vy, vfi, vla, r2d;
+  int ii, jj;
+
+  r2d = vset1(180.0/M_PI); // radians to degrees
+
+  for (ii = 0; ii + VLEN <= n; ii += VLEN) {
+    vx = vload(&x[ii]); vy = vload(&y[ii]);
+    vxy2fila(vx, vy, el, pj, &vfi, &vla);
+    vstore(&fi[ii], vmul(vfi, r2d)); vstore(&la[ii], vmul(vla, r2d));
+  }
+
+  if (ii < n) { // remaining points (less than VLEN)
+    for (jj = 0; jj < VLEN; jj++) {
+      tx[jj] = x[ii + jj < n ? ii + jj : n - 1];
+      ty[jj] = y[ii + jj < n ? ii + jj : n - 1];
+    }
+    vxy2fila(vload(tx), vload(ty), el, pj, &vfi, &vla);
+    vstore(tfi, vmul(vfi, r2d)); vstore(tla, vmul(vla, r2d));
+    for (jj = 0; ii + jj < n; jj++) {
+      fi[ii + jj] = tfi[jj]; la[ii + jj] = tla[jj];
+    }
+  }
+} /* xy2fila_ellips_v */
+
+
+// ----------------------------------------------------------------------------
+// vsigma
+// sinh(e*atanh(e*s)) for vector s = sin(fi) (conformal latitude correction
+// of Krueger series; |e*s| < 0.082 and |e*atanh(e*s)| < 0.0068, so short
+// series are exact to double precision)
+// ----------------------------------------------------------------------------
+static INLINE vdbl vsigma(vdbl s, const ELLIPSOID *el)
+{
+  vdbl q, z, p;
+
+  // atanh(q) = q*sum z^k/(2k+1), z = q^2, k = 0..8
+  q = vmul(vset1(el->ke), s);
+  z = vmul(q, q);
+  p = vset1(1.0/17.0);
+  p = vadd(vmul(p, z), vset1(1.0/15.0));
+  p = vadd(vmul(p, z), vset1(1.0/13.0));
+  p = vadd(vmul(p, z), vset1(1.0/11.0));
+  p = vadd(vmul(p, z), vset1(1.0/9.0));
+  p = vadd(vmul(p, z), vset1(1.0/7.0));
+  p = vadd(vmul(p, z), vset1(1.0/5.0));
+  p = vadd(vmul(p, z), vset1(1.0/3.0));
+  q = vmul(vmul(vset1(el->ke), q), vadd(vset1(1.0), vmul(p, z)));
+
+  // sinh(q) = q*(1 + z/6 + z^2/120 + z^3/5040)
+  z = vmul(q, q);
+  p = vadd(vmul(z, vset1(1.0/5040.0)), vset1(1.0/120.0));
+  p = vadd(vmul(p, z), vset1(1.0/6.0));
+  return vadd(q, vmul(vmul(q, z), p));
+} /* vsigma */
+
+
+// ----------------------------------------------------------------------------
+// vkrueger_sum
+// Sum of c[j]*sin(2j*(xi + i*eta)), j = 1..6, for vectors xi, eta
+// (same complex Clenshaw recurrence as krueger_sum)
+// ----------------------------------------------------------------------------
+static INLINE void vkrueger_sum(const double *c, vdbl xi, vdbl eta, vdbl *sxi, vdbl *seta)
+{
+  vdbl s2, c2, E, iE, sh2, ch2, ar, ai, br, bi, b2r, b2i, b3r, b3i;
+  int k;
+
+  vsincos(vadd(xi, xi), &s2, &c2);
+  E = vexp(vadd(eta, eta));
+  iE = vdiv(vset1(1.0), E);
+  sh2 = vmul(vsub(E, iE), vset1(0.5));
+  ch2 = vmul(vadd(E, iE), vset1(0.5));
+
+  // a = 2*cos(2*zeta), b(k) = c[k] + a*b(k+1) - b(k+2)
+  ar = vmul(vset1(2.0), vmul(c2, ch2));
+  ai = vmul(vset1(-2.0), vmul(s2, sh2));
+  br = vset1(0.0); bi = br; b2r = br; b2i = br;
+  for (k = 6; k >= 1; k--) {
+    b3r = b2r; b3i = b2i; b2r = br; b2i = bi;
+    br = vsub(vadd(vset1(c[k]), vsub(vmul(ar, b2r), vmul(ai, b2i))), b3r);
+    bi = vsub(vadd(vmul(ar, b2i), vmul(ai, b2r)), b3i);
+  }
+
+  // sum = b(1)*sin(2*zeta)
+  *sxi = vsub(vmul(br, vmul(s2, ch2)), vmul(bi, vmul(c2, sh2)));
+  *seta = vadd(vmul(br, vmul(c2, sh2)), vmul(bi, vmul(s2, ch2)));
+} /* vkrueger_sum */
+
+
+// ----------------------------------------------------------------------------
+// vfila2xy_kr
+// Transverse Mercator projection of one vector of points with Krueger
+// n-series (same as fila2xy_krueger_rad_proj, fi and la in radians)
+// ----------------------------------------------------------------------------
+static INLINE void vfila2xy_kr(vdbl fi, vdbl la, const ELLIPSOID *el, const PROJ *pj,
+                               vdbl *x, vdbl *y)
+{
+  vdbl s, c, sl, cl, sig, taup, xip, etap, dxi, deta, one;
+
+  one = vset1(1.0);
+  vsincos(fi, &s, &c);
+  vsincos(vsub(la, vset1(pj->lambda0)), &sl, &cl);
+
+  // Conformal latitude (as tangent), tau = s/c and tau/sqrt(1 + tau^2) = s
+  sig = vsigma(s, el);
+  taup = vdiv(vsub(vmul(s, vsqrt(vadd(one, vmul(sig, sig)))), sig), c);
+
+  // Gauss-Schreiber TM, then Krueger series
+  xip = vatan2(taup, cl);
+  etap = vasinh(vdiv(sl, vsqrt(vadd(vmul(taup, taup), vmul(cl, cl)))));
+  vkrueger_sum(el->kalp, xip, etap, &dxi, &deta);
+
+  // Convert from real to relative coordinates
+  *x = vadd(vmul(vadd(xip, dxi), vset1(el->kA*pj->scale)), vset1(pj->false_northing));
+  *y = vadd(vmul(vadd(etap, deta), vset1(el->kA*pj->scale)), vset1(pj->false_easting));
+} /* vfila2xy_kr */
+
+
+// ----------------------------------------------------------------------------
+// fila2xy_krueger_v (heights not calculated)
+// ----------------------------------------------------------------------------
+// Same as fila_ellips2xy_v, but with Krueger n-series
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+static void fila2xy_krueger_v(const PROJ *pj, int n, const double *fi, const double *la,
+                              double *x, double *y, int oid)
+{
+  const ELLIPSOID *el = &ellips[oid];
+  double tfi[VLEN], tla[VLEN], tx[VLEN], ty[VLEN];
+  vdbl vfi, vla, vx, vy, d2r;
+  int ii, jj;
+
+  d2r = vset1(M_PI/180.0); // degrees to radians
+
+  for (ii = 0; ii + VLEN <= n; ii += VLEN) {
+    vfi = vmul(vload(&fi[ii]), d2r);
+    vla = vmul(vload(&la[ii]), d2r);
+    vfila2xy_kr(vfi, vla, el, pj, &vx, &vy);
+    vstore(&x[ii], vx); vstore(&y[ii], vy);
+  }
+
+  if (ii < n) { // remaining points (less than VLEN)
+    for (jj = 0; jj < VLEN; jj++) {
+      tfi[jj] = fi[ii + jj < n ? ii + jj : n - 1];
+      tla[jj] = la[ii + jj < n ? ii + jj : n - 1];
+    }
+    vfi = vmul(vload(tfi), d2r);
+    vla = vmul(vload(tla), d2r);
+    vfila2xy_kr(vfi, vla, el, pj, &vx, &vy);
+    vstore(tx, vx); vstore(ty, vy);
+    for (jj = 0; ii + jj < n; jj++) {
+      x[ii + jj] = tx[jj]; y[ii + jj] = ty[jj];
+    }
+  }
+} /* fila2xy_krueger_v */
+
+
+// ----------------------------------------------------------------------------
+// vxy2fila_kr
+// Inverse Transverse Mercator projection of one vector of points with
+// Krueger n-series (same as xy2fila_krueger_rad_proj, fi and la in radians)
+// ----------------------------------------------------------------------------
+static INLINE void vxy2fila_kr(vdbl x, vdbl y, const ELLIPSOID *el, const PROJ *pj,
+                               vdbl *fi, vdbl *la)
+{
+  vdbl xi, eta, dxi, deta, sx, cx, E, sh, taup, tau, tau1, r, r1, sig, e2m, one;
+  int n;
+
+  // Convert from relative to real coordinates
+  xi = vdiv(vsub(x, vset1(pj->false_northing)), vset1(pj->scale*el->kA));
+  eta = vdiv(vsub(y, vset1(pj->false_easting)), vset1(pj->scale*el->kA));
+
+  vkrueger_sum(el->kbet, xi, eta, &dxi, &deta);
+  vsincos(vsub(xi, dxi), &sx, &cx);
+  E = vexp(vsub(eta, deta));
+  sh = vmul(vsub(E, vdiv(vset1(1.0), E)), vset1(0.5)); // sinh(etap)
+  taup = vdiv(sx, vsqrt(vadd(vmul(sh, sh), vmul(cx, cx))));
+  *la = vadd(vset1(pj->lambda0), vatan2(sh, cx));
+
+  // Latitude from conformal latitude (Newton's method) with fixed number of
+  // iterations (same in all lanes); error of first estimate is < 0.007*tau
+  // and convergence is quadratic, so 3 iterations reach double precision
+  one = vset1(1.0);
+  e2m = vset1(1.0 - el->e2);
+  tau = vdiv(taup, e2m); // first estimate
+  for (n = 0; n < 3; n++) {
+    r = vsqrt(vadd(one, vmul(tau, tau)));
+    sig = vsigma(vdiv(tau, r), el);
+    tau1 = vsub(vmul(tau, vsqrt(vadd(one, vmul(sig, sig)))), vmul(sig, r));
+    r1 = vsqrt(vadd(one, vmul(tau1, tau1)));
+    tau = vadd(tau, vdiv(vmul(vsub(taup, tau1), vadd(one, vmul(e2m, vmul(tau, tau)))),
+                         vmul(vmul(r1, e2m), r)));
+  }
+  *fi = vatan2(tau, one);
+} /* vxy2fila_kr */
+
+
+// ----------------------------------------------------------------------------
+// xy2fila_krueger_v (heights not calculated)
+// ----------------------------------------------------------------------------
+// Same as xy2fila_ellips_v, but with Krueger n-series
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+static void xy2fila_krueger_v(const PROJ *pj, int n, const double *x, const double *y,
+                              double *fi, double *la, int oid)
+{
+  const ELLIPSOID *el = &ellips[oid];
+  double tx[VLEN], ty[VLEN], tfi[VLEN], tla[VLEN];
+  vdbl vx, vy, vfi, vla, r2d;
+  int ii, jj;
+
+  r2d = vset1(180.0/M_PI); // radians to degrees
+
+  for (ii = 0; ii + VLEN <= n; ii += VLEN) {
+    vx = vload(&x[ii]); vy = vload(&y[ii]);
+    vxy2fila_kr(vx, vy, el, pj, &vfi, &vla);
+    vstore(&fi[ii], vmul(vfi, r2d)); vstore(&la[ii], vmul(vla, r2d));
+  }
+
+  if (ii < n) { // remaining points (less than VLEN)
+    for (jj = 0; jj < VLEN; jj++) {
+      tx[jj] = x[ii + jj < n ? ii + jj : n - 1];
+      ty[jj] = y[ii + jj < n ? ii + jj : n - 1];
+    }
+    vxy2fila_kr(vload(tx), vload(ty), el, pj, &vfi, &vla);
+    vstore(tfi, vmul(vfi, r2d)); vstore(tla, vmul(vla, r2d));
+    for (jj = 0; ii + jj < n; jj++) {
+      fi[ii + jj] = tfi[jj]; la[ii + jj] = tla[jj];
+    }
+  }
+} /* xy2fila_krueger_v */
+
+
+// ----------------------------------------------------------------------------
+// vfila2fila
+// Transform one vector of points from fi,la,h (radians) on ellipsoid iel to
+// fi,la,h on ellipsoid oel via cart. X,Y,Z and Helmert transformation
+// (same as fila_ellips2xyz, xyz2xyz_helmert (H71) and xyz2fila_ellips (FI1))
+// sR: rotation matrix multiplied by scale (1 + s)
+// hout: 0 if transformed height is not needed (h is left unchanged)
+// ----------------------------------------------------------------------------
+static INLINE void vfila2fila(vdbl *fi, vdbl *la, vdbl *h, const ELLIPSOID *iel,
+                              const ELLIPSOID *oel, const double *sR, const double *dT,
+                              int hout)
+{
+  vdbl sf, cf, sl, cl, N, X, Y, Z, OX, OY, OZ, p, u, w, r, one;
+
+  one = vset1(1.0);
+
+  // fi,la,h to X,Y,Z on input ellipsoid
+  vsincos(*fi, &sf, &cf);
+  vsincos(*la, &sl, &cl);
+  N = vdiv(vset1(iel->a), vsqrt(vsub(one, vmul(vset1(iel->e2), vmul(sf, sf)))));
+  r = vmul(vadd(N, *h), cf);
+  X = vmul(r, cl);
+  Y = vmul(r, sl);
+  Z = vmul(vadd(vmul(vset1(iel->b2/iel->a2), N), *h), sf);
+
+  // Helmert transformation [OX;OY;OZ] = [dX;dY;dZ] + (1 + s)*R*[X;Y;Z]
+  OX = vadd(vset1(dT[0]), vadd(vadd(vmul(vset1(sR[0]), X), vmul(vset1(sR[1]), Y)), vmul(vset1(sR[2]), Z)));
+  OY = vadd(vset1(dT[1]), vadd(vadd(vmul(vset1(sR[3]), X), vmul(vset1(sR[4]), Y)), vmul(vset1(sR[5]), Z)));
+  OZ = vadd(vset1(dT[2]), vadd(vadd(vmul(vset1(sR[6]), X), vmul(vset1(sR[7]), Y)), vmul(vset1(sR[8]), Z)));
+
+  // X,Y,Z to fi,la,h on output ellipsoid (Bowring's algorithm)
+  // sin/cos of auxiliary angle O = atan2(Z*a, p*b) are taken directly from
+  // atan2 arguments, sin/cos of fi from arguments of the second atan2
+  p = vsqrt(vadd(vmul(OX, OX), vmul(OY, OY)));
+  u = vmul(OZ, vset1(oel->a));
+  w = vmul(p, vset1(oel->b));
+  r = vdiv(one, vsqrt(vadd(vmul(u, u), vmul(w, w))));
+  u = vmul(u, r); w = vmul(w, r); // sinO, cosO
+  u = vadd(OZ, vmul(vset1(oel->e2_*oel->b), vmul(u, vmul(u, u))));
+  w = vsub(p, vmul(vset1(oel->e2*oel->a), vmul(w, vmul(w, w))));
+  *fi = vatan2(u, w);
+  *la = vatan2(OY, OX);
+  if (!hout) return; // skip transformed height
+  r = vdiv(one, vsqrt(vadd(vmul(u, u), vmul(w, w))));
+  sf = vmul(u, r); cf = vmul(w, r);
+  N = vdiv(vset1(oel->a), vsqrt(vsub(one, vmul(vset1(oel->e2), vmul(sf, sf)))));
+  *h = vsub(vdiv(p, cf), N);
+} /* vfila2fila */
+
+
+// ----------------------------------------------------------------------------
+// fila_ellips2fila_helmert_vec
+// ----------------------------------------------------------------------------
+// Transform n points from fi,la,h on ellipsoid iid to fi,la,h on ellipsoid
+// oid using Helmert transformation h7 (output arrays can be the same as
+// input arrays, oh can be NULL if transformed heights are not needed)
+// ----------------------------------------------------------------------------
+// Ellipsoid: 0: bessel, 1: wgs84, 2: etrs89
+static void fila_ellips2fila_helmert_v(int n, const double *fi, const double *la,
+              const double *h, double *ofi, double *ola, double *oh,
+              HELMERT7 h7, int iid, int oid)
+{
+  const ELLIPSOID *iel = &ellips[iid], *oel = &ellips[oid];
+  double (*R)[3] = (double (*)[3])h7.R;
+  double sR[9], dT[3], dm1;
+  double tfi[VLEN], tla[VLEN], th[VLEN];
+  vdbl vfi, vla, vh, d2r, r2d;
+  int ii, jj;
+
+  // Scaled rotation matrix and translation
+  dm1 = 1.0 + h7.dm*1e-6;
+  for (ii = 0; ii < 3; ii++)
+    for (jj = 0; jj < 3; jj++)
+      sR[3*ii + jj] = dm1*R[ii][jj];
+  dT[0] = h7.dX; dT[1] = h7.dY; dT[2] = h7.dZ;
+
+  d2r = vset1(M_PI/180.0); // degrees to radians
+  r2d = vset1(180.0/M_PI); // radians to degrees
+
+  for (ii = 0; ii + VLEN <= n; ii += VLEN) {
+    vfi = vmul(vload(&fi[ii]), d2r);
+    vla = vmul(vload(&la[ii]), d2r);
+    vh = vload(&h[ii]);
+    if (oh != NULL) {
+      vfila2fila(&vfi, &vla, &vh, iel, oel, sR, dT, 1);
+      vstore(&oh[ii], vh);
+    }
+    else vfila2fila(&vfi, &vla, &vh, iel, oel, sR, dT, 0);
+    vstore(&ofi[ii], vmul(vfi, r2d)); vstore(&ola[ii], vmul(vla, r2d));
+  }
+
+  if (ii < n) { // remaining points (less than VLEN)
+    for (jj = 0; jj < VLEN; jj++) {
+      tfi[jj] = fi[ii + jj < n ? ii + jj : n - 1];
+      tla[jj] = la[ii + jj < n ? ii + jj : n - 1];
+      th[jj] = h[ii + jj < n ? ii + jj : n - 1];
+    }
+    vfi = vmul(vload(tfi), d2r);
+    vla = vmul(vload(tla), d2r);
+    vh = vload(th);
+    vfila2fila(&vfi, &vla, &vh, iel, oel, sR, dT, oh != NULL);
+    vstore(tfi, vmul(vfi, r2d)); vstore(tla, vmul(vla, r2d));
+    vstore(th, vh);
+    for (jj = 0; ii + jj < n; jj++) {
+      ofi[ii + jj] = tfi[jj]; ola[ii + jj] = tla[jj];
+      if (oh != NULL) oh[ii + jj] = th[jj];
+    }
+  }
+} /* fila_ellips2fila_helmert_v */
+
+
+// ----------------------------------------------------------------------------
+// vchebf
+// Sums of c_ij*T_i(u)*T_j(v) (i+j <= deg) for one vector of points in single
+// precision, for two sets of coefficients c0 and c1 (see geo_f32_init)
+// ----------------------------------------------------------------------------
+static INLINE void vchebf(vflt u, vflt v, int deg, const float *c0, const float *c1,
+                          vflt *s0, vflt *s1)
+{
+  vflt tu[GEO_F32_DEG+1], tv[GEO_F32_DEG+1], t, u2, v2;
+  int ii, jj, kk;
+
+  tu[0] = fset1(1.0f); tu[1] = u; tv[0] = tu[0]; tv[1] = v;
+  u2 = fadd(u, u); v2 = fadd(v, v);
+  for (ii = 2; ii <= deg; ii++) {
+    tu[ii] = fsub(fmul(u2, tu[ii-1]), tu[ii-2]);
+    tv[ii] = fsub(fmul(v2, tv[ii-1]), tv[ii-2]);
+  }
+  *s0 = fset1(c0[0]); *s1 = fset1(c1[0]);
+  for (jj = 1, kk = 1; jj <= deg; jj++) // terms ordered by total degree jj
+    for (ii = 0; ii <= jj; ii++, kk++) {
+      t = fmul(tu[ii], tv[jj - ii]);
+      *s0 = fadd(*s0, fmul(fset1(c0[kk]), t));
+      *s1 = fadd(*s1, fmul(fset1(c1[kk]), t));
+    }
+} /* vchebf */
+
+
+// ----------------------------------------------------------------------------
+// cheb_f32_v
+// ----------------------------------------------------------------------------
+// Evaluate single precision approximation for n points u,v (scaled to -1..1)
+// to ou, ov (coefficients c0, c1 of total degree deg, max. GEO_F32_DEG)
+// ----------------------------------------------------------------------------
+static void cheb_f32_v(int n, int deg, const float *c0, const float *c1,
+                       const float *u, const float *v, float *ou, float *ov)
+{
+  float tu[FLEN], tv[FLEN];
+  vflt s0, s1;
+  int ii, jj;
+
+  for (ii = 0; ii + FLEN <= n; ii += FLEN) {
+    vchebf(fload(&u[ii]), fload(&v[ii]), deg, c0, c1, &s0, &s1);
+    fstore(&ou[ii], s0); fstore(&ov[ii], s1);
+  }
+
+  if (ii < n) { // remaining points (less than FLEN)
+    for (jj = 0; jj < FLEN; jj++) {
+      tu[jj] = u[ii + jj < n ? ii + jj : n - 1];
+      tv[jj] = v[ii + jj < n ? ii + jj : n - 1];
+    }
+    vchebf(fload(tu), fload(tv), deg, c0, c1, &s0, &s1);
+    fstore(tu, s0); fstore(tv, s1);
+    for (jj = 0; ii + jj < n; jj++) {
+      ou[ii + jj] = tu[jj]; ov[ii + jj] = tv[jj];
+    }
+  }
+} /* cheb_f32_v */
+
+
+// ----------------------------------------------------------------------------
+// cheb_v
+// ----------------------------------------------------------------------------
+// Evaluate values of Chebyshev approximation ch selected by mask (bit per
+// value) for n points u,v (scaled to -1..1) to val[value*n + point].
+// Products T_i(u)*T_j(v) are calculated once per vector and shared by all
+// values; terms are ordered by total degree, so each value sums only the
+// first terms up to its own degree (see geo_cheb_fit).
+// ----------------------------------------------------------------------------
+static void cheb_v(const GEO_CHEB *ch, unsigned mask, int n, const double *u, const double *v,
+                   double *val)
+{
+  double tu[VLEN], tv[VLEN];
+  vdbl pu[GEO_CHEB_MAXDEG+1], pv[GEO_CHEB_MAXDEG+1], t[GEO_CHEB_NCOEF];
+  vdbl u2, v2, s0, s1, s2, s3;
+  const double *c;
+  int ii, jj, kk, ll, nt, deg = ch->deg;
+
+  for (ii = 0; ii < n; ii += VLEN) {
+    if (ii + VLEN <= n) {
+      pu[1] = vload(&u[ii]); pv[1] = vload(&v[ii]);
+    } else { // remaining points (less than VLEN)
+      for (jj = 0; jj < VLEN; jj++) {
+        tu[jj] = u[ii + jj < n ? ii + jj : n - 1];
+        tv[jj] = v[ii + jj < n ? ii + jj : n - 1];
+      }
+      pu[1] = vload(tu); pv[1] = vload(tv);
+    }
+
+    pu[0] = vset1(1.0); pv[0] = pu[0];
+    u2 = vadd(pu[1], pu[1]); v2 = vadd(pv[1], pv[1]);
+    for (jj = 2; jj <= deg; jj++) {
+      pu[jj] = vsub(vmul(u2, pu[jj-1]), pu[jj-2]);
+      pv[jj] = vsub(vmul(v2, pv[jj-1]), pv[jj-2]);
+    }
+    for (jj = 1, nt = 1; jj <= deg; jj++) // terms ordered by total degree jj
+      for (kk = 0; kk <= jj; kk++) t[nt++] = vmul(pu[kk], pv[jj - kk]);
+
+    for (kk = 0; kk < ch->nc; kk++) {
+      if (!((mask >> kk) & 1)) continue;
+      c = ch->c[kk]; nt = (ch->vdeg[kk] + 1)*(ch->vdeg[kk] + 2)/2;
+      // 4 partial sums to break dependency chain
+      s0 = vset1(c[0]); s1 = s2 = s3 = vset1(0.0);
+      for (ll = 1; ll + 3 < nt; ll += 4) {
+        s0 = vadd(s0, vmul(vset1(c[ll]), t[ll]));
+        s1 = vadd(s1, vmul(vset1(c[ll+1]), t[ll+1]));
+        s2 = vadd(s2, vmul(vset1(c[ll+2]), t[ll+2]));
+        s3 = vadd(s3, vmul(vset1(c[ll+3]), t[ll+3]));
+      }
+      for (; ll < nt; ll++) s0 = vadd(s0, vmul(vset1(c[ll]), t[ll]));
+      s0 = vadd(vadd(s0, s1), vadd(s2, s3));
+      if (ii + VLEN <= n)
+        vstore(&val[kk*n + ii], s0);
+      else {
+        vstore(tu, s0);
+        for (jj = 0; ii + jj < n; jj++) val[kk*n + ii + jj] = tu[jj];
+      }
+    }
+  }
+} /* cheb_v */
+
+
+// ----------------------------------------------------------------------------
+// geoid_height_v
+// ----------------------------------------------------------------------------
+// Geoid heights Ng for n points fi,la from bilinear coefficients of cells of
+// geoid model g (see geoid_cell_coef). Points outside model get index of
+// cell 0 (all coefficients 0), so there are no branches per point, only
+// coefficients are looked up when points of a vector are not all in the same
+// cell as previous ones (spatially sorted input). Coefficients of the last
+// cells with even and odd index are kept, so a vector across the border of
+// two neighbouring cells is blended from them and each cell is calculated
+// from nodes only once per run of points.
+// Cell index is rounded as with xtrunc() in geoid_height(), so points on
+// nodes get the same cell.
+// ----------------------------------------------------------------------------
+#define GEOID_EPS 0.00000000000001 // as in xtrunc()
+
+#ifndef NO_SIMD
+typedef struct geoid_cells { // coefficients of last even and odd cell
+  int k[2];        // cell indexes (ix*(ny-1) + iy, -1: none)
+  double cf[2][4]; // coefficients (see geoid_cell_coef)
+} GEOID_CELLS;
+
+// Coefficients of cell k (ix,iy), calculated if not kept in cc
+static INLINE const double *geoid_cell(const GEO_GEOID *g, GEOID_CELLS *cc, int k, int ix, int iy)
+{
+  int s = k & 1;
+
+  if (cc->k[s] != k) {
+    cc->k[s] = k;
+    geoid_cell_coef(g, ix, iy, cc->cf[s]);
+  }
+  return cc->cf[s];
+} /* geoid_cell */
+#endif
+
+static void geoid_height_v(const GEO_GEOID *g, int n, const double *fi, const double *la,
+                           double *Ng)
+{
+#ifdef NO_SIMD
+  double cf[4], xi, yi, u, v;
+  int ii, ix, iy, k, klast = -1;
+
+  for (ii = 0; ii < n; ii++) {
+    xi = (fi[ii] - g->fimin)/g->dfi; yi = (la[ii] - g->lamin)/g->dla;
+    if (!(fi[ii] >= g->fimin && fi[ii] <= g->fimax && la[ii] >= g->lamin && la[ii] <= g->lamax
+          && xi + GEOID_EPS < g->nx - 1 && yi + GEOID_EPS < g->ny - 1)) {
+      Ng[ii] = 0.0; continue;
+    }
+    ix = (int)(xi + GEOID_EPS); iy = (int)(yi + GEOID_EPS);
+    u = xi - ix; v = yi - iy;
+    k = ix*(g->ny - 1) + iy;
+    if (k != klast) {
+      geoid_cell_coef(g, ix, iy, cf);
+      klast = k;
+    }
+    Ng[ii] = cf[0] + u*cf[1] + v*(cf[2] + u*cf[3]);
+  }
+#else
+  GEOID_CELLS cc = { { -1, -1 } };
+  double tfi[VLEN], tla[VLEN], tk[VLEN], tx[VLEN], ty[VLEN], tc[4][VLEN];
+  const double *c0, *c1;
+  vdbl fimin, fimax, lamin, lamax, dfi, dla, cx, cy, eps;
+  vdbl vfi, vla, xi, yi, fx, fy, ok, kd, k0, k1, m, a, b, c, d, r;
+  vidx k;
+  int ii, jj, kf, kl, klast = -1;
+
+  fimin = vset1(g->fimin); fimax = vset1(g->fimax); dfi = vset1(g->dfi);
+  lamin = vset1(g->lamin); lamax = vset1(g->lamax); dla = vset1(g->dla);
+  cx = vset1(g->nx - 1); cy = vset1(g->ny - 1);
+  eps = vset1(GEOID_EPS);
+  a = b = c = d = vset1(0.0);
+
+  for (ii = 0; ii < n; ii += VLEN) {
+    if (ii + VLEN <= n) {
+      vfi = vload(&fi[ii]); vla = vload(&la[ii]);
+    } else { // remaining points (less than VLEN)
+      for (jj = 0; jj < VLEN; jj++) {
+        tfi[jj] = fi[ii + jj < n ? ii + jj : n - 1];
+        tla[jj] = la[ii + jj < n ? ii + jj : n - 1];
+      }
+      vfi = vload(tfi); vla = vload(tla);
+    }
+
+    xi = vdiv(vsub(vfi, fimin), dfi); yi = vdiv(vsub(vla, lamin), dla);
+    ok = vand(vand(vcmpge(vfi, fimin), vcmpge(fimax, vfi)),
+              vand(vcmpge(vla, lamin), vcmpge(lamax, vla)));
+    ok = vand(ok, vand(vcmpgt(cx, vadd(xi, eps)), vcmpgt(cy, vadd(yi, eps))));
+    xi = vand(ok, xi); yi = vand(ok, yi); // cell 0 outside model
+    fx = vfromidx(vtoidx(vadd(xi, eps))); fy = vfromidx(vtoidx(vadd(yi, eps)));
+    kd = vadd(vmul(fx, cy), fy);
+    k = vtoidx(kd);
+
+    if (!vidxeq(k, klast)) {
+      // Cells of first and last point, other points are usually in one of them
+      vstore(tk, kd); vstore(tx, fx); vstore(ty, fy);
+      kf = (int)tk[0]; kl = (int)tk[VLEN-1];
+      k0 = vset1(tk[0]); k1 = vset1(tk[VLEN-1]);
+      m = vand(vcmpge(kd, k0), vcmpge(k0, kd));
+      if (((kf ^ kl) & 1 || kf == kl) && vidxeq(vtoidx(vsub(kd, vsel(m, k0, k1))), 0)) {
+        c0 = geoid_cell(g, &cc, kf, (int)tx[0], (int)ty[0]);
+        c1 = geoid_cell(g, &cc, kl, (int)tx[VLEN-1], (int)ty[VLEN-1]);
+        a = vsel(m, vset1(c0[0]), vset1(c1[0])); b = vsel(m, vset1(c0[1]), vset1(c1[1]));
+        c = vsel(m, vset1(c0[2]), vset1(c1[2])); d = vsel(m, vset1(c0[3]), vset1(c1[3]));
+      } else { // more than two cells
+        for (jj = 0; jj < VLEN; jj++) {
+          c0 = geoid_cell(g, &cc, (int)tk[jj], (int)tx[jj], (int)ty[jj]);
+          tc[0][jj] = c0[0]; tc[1][jj] = c0[1]; tc[2][jj] = c0[2]; tc[3][jj] = c0[3];
+        }
+        a = vload(tc[0]); b = vload(tc[1]); c = vload(tc[2]); d = vload(tc[3]);
+      }
+      klast = vidx0(k);
+      if (!vidxeq(k, klast)) klast = -1; // not all in the same cell
+    }
+
+    xi = vsub(xi, fx); yi = vsub(yi, fy); // u, v
+    r = vadd(vadd(a, vmul(xi, b)), vmul(yi, vadd(c, vmul(xi, d))));
+    if (ii + VLEN <= n)
+      vstore(&Ng[ii], r);
+    else {
+      vstore(tfi, r);
+      for (jj = 0; ii + jj < n; jj++) Ng[ii + jj] = tfi[jj];
+    }
+  }
+#endif
+} /* geoid_height_v */
+
+
+const GEO_SIMD VKERNELS = { VNAME, VLEN, fila_ellips2xy_v, xy2fila_ellips_v,
+                            fila_ellips2fila_helmert_v, cheb_f32_v, geoid_height_v, cheb_v,
+                            fila2xy_krueger_v, xy2fila_krueger_v };
+
+#ifndef GEO_SIMD_VARIANT
+// Kernels for other instruction sets (geo_simd.c compiled with other flags)
+#ifdef GEO_SIMD_AVX2
+extern const GEO_SIMD geo_simd_avx2;
+#endif
+#ifdef GEO_SIMD_AVX512
+extern const GEO_SIMD geo_simd_avx512;
+#endif
+
+static const GEO_SIMD *simd = NULL; // selected kernels
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT; // default selection
+
+// ----------------------------------------------------------------------------
+// simd_best
+// Widest vectorized kernels supported by CPU (checked with cpuid)
+// ----------------------------------------------------------------------------
+static const GEO_SIMD *simd_best()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+#ifdef GEO_SIMD_AVX512
+  if (__builtin_cpu_supports("avx512f")) return &geo_simd_avx512;
+#endif
+#ifdef GEO_SIMD_AVX2
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return &geo_simd_avx2;
+#endif
+#endif
+  return &geo_simd_base;
+} /* simd_best */
+
+
+// ----------------------------------------------------------------------------
+// simd_default
+// Select widest kernels if geo_simd_init() wasn't called (run only once,
+// through pthread_once, so worker threads may be the first callers)
+// ----------------------------------------------------------------------------
+static void simd_default()
+{
+  if (simd == NULL) simd = simd_best();
+} /* simd_default */
+
+
+// ----------------------------------------------------------------------------
+// geo_simd_init
+// ----------------------------------------------------------------------------
+// Select vectorized kernels: the widest instruction set supported by CPU
+// (AVX-512, AVX2 with FMA, checked with cpuid) or, if repro is set, SSE2
+// vector kernels built with the same flags as the rest of the program.
+// Wider kernels use fused multiply-add, so their results can differ in the
+// last bits; SSE2 kernels give the same results on all systems.
+// Must be called before conversions are started in threads; otherwise the
+// widest kernels are selected once at first conversion.
+// Returns number of points processed together.
+// ----------------------------------------------------------------------------
+int geo_simd_init(int repro)
+{
+  simd = repro ? &geo_simd_base : simd_best();
+  return simd->width;
+} /* geo_simd_init */
+
+
+// ----------------------------------------------------------------------------
+// fila_ellips2xy_vec, xy2fila_ellips_vec, fila_ellips2fila_helmert_vec,
+// cheb_f32_vec, cheb_vec
+// ----------------------------------------------------------------------------
+// Dispatch to kernels selected by geo_simd_init() (projection for Slovenia)
+// ----------------------------------------------------------------------------
+void fila_ellips2xy_vec(int n, const double *fi, const double *la,
+                        double *x, double *y, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->fila2xy(&tm, n, fi, la, x, y, oid);
+} /* fila_ellips2xy_vec */
+
+void xy2fila_ellips_vec(int n, const double *x, const double *y,
+                        double *fi, double *la, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->xy2fila(&tm, n, x, y, fi, la, oid);
+} /* xy2fila_ellips_vec */
+
+void fila_ellips2fila_helmert_vec(int n, const double *fi, const double *la,
+       const double *h, double *ofi, double *ola, double *oh,
+       HELMERT7 h7, int iid, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->helmert(n, fi, la, h, ofi, ola, oh, h7, iid, oid);
+} /* fila_ellips2fila_helmert_vec */
+
+void cheb_f32_vec(int n, int deg, const float *c0, const float *c1,
+                  const float *u, const float *v, float *ou, float *ov)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->chebf(n, deg, c0, c1, u, v, ou, ov);
+} /* cheb_f32_vec */
+
+void cheb_vec(const GEO_CHEB *ch, unsigned mask, int n, const double *u, const double *v,
+              double *val)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->cheb(ch, mask, n, u, v, val);
+} /* cheb_vec */
+
+
+// ----------------------------------------------------------------------------
+// fila_ellips2xy_proj_vec, xy2fila_ellips_proj_vec
+// ----------------------------------------------------------------------------
+// Same as fila_ellips2xy_vec() and xy2fila_ellips_vec(), but with projection
+// constants pj (e.g. GK zone from gkproj[])
+// ----------------------------------------------------------------------------
+void fila_ellips2xy_proj_vec(const PROJ *pj, int n, const double *fi, const double *la,
+                             double *x, double *y, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->fila2xy(pj, n, fi, la, x, y, oid);
+} /* fila_ellips2xy_proj_vec */
+
+void xy2fila_ellips_proj_vec(const PROJ *pj, int n, const double *x, const double *y,
+                             double *fi, double *la, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->xy2fila(pj, n, x, y, fi, la, oid);
+} /* xy2fila_ellips_proj_vec */
+
+
+// ----------------------------------------------------------------------------
+// fila2xy_krueger_proj_vec, xy2fila_krueger_proj_vec
+// ----------------------------------------------------------------------------
+// Same as fila_ellips2xy_proj_vec() and xy2fila_ellips_proj_vec(), but with
+// Krueger n-series (as fila2xy_krueger_proj() and xy2fila_krueger_proj())
+// ----------------------------------------------------------------------------
+void fila2xy_krueger_proj_vec(const PROJ *pj, int n, const double *fi, const double *la,
+                              double *x, double *y, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->krfila2xy(pj, n, fi, la, x, y, oid);
+} /* fila2xy_krueger_proj_vec */
+
+void xy2fila_krueger_proj_vec(const PROJ *pj, int n, const double *x, const double *y,
+                              double *fi, double *la, int oid)
+{
+  pthread_once(&simd_once, simd_default);
+  simd->krxy2fila(pj, n, x, y, fi, la, oid);
+} /* xy2fila_krueger_proj_vec */
+
+
+// ----------------------------------------------------------------------------
+// geoid_height_vec
+// ----------------------------------------------------------------------------
+// Geoid heights Ng of geoid model gid for n points fi,la (same as
+// geoid_height, but with bilinear coefficients of cells, see geoid_cell_coef)
+// ----------------------------------------------------------------------------
+void geoid_height_vec(int n, const double *fi, const double *la, double *Ng, int gid)
+{
+  const GEO_GEOID *g = &geoids[gid];
+
+  pthread_once(&simd_once, simd_default);
+  if (g->val == NULL) { // no geoid model (bessel)
+    memset(Ng, 0, n*sizeof(double));
+    return;
+  }
+  simd->geoid(g, n, fi, la, Ng);
+} /* geoid_height_vec */
+
+
+// ----------------------------------------------------------------------------
+// geo_simd_width, geo_simd_name
+// ----------------------------------------------------------------------------
+// Returns number of points processed together by selected vectorized
+// kernels and name of their instruction set
+// ----------------------------------------------------------------------------
+int geo_simd_width()
+{
+  pthread_once(&simd_once, simd_default);
+  return simd->width;
+} /* geo_simd_width */
+
+const char *geo_simd_name()
+{
+  pthread_once(&simd_once, simd_default);
+  return simd->name;
+} /* geo_simd_name */
+#endif // GEO_SIMD_VARIANT
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,163 @@
+// GK - Converter between Gauss-Krueger/TM and WGS84 coordinates for Slovenia
+// Copyright (c) 2014-2019 Matjaz Rihtar <matjaz@eunet.si>
+// All rights reserved.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published
+// by the Free Software Foundation, either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see http://www.gnu.org/licenses/
+//
+// gk-bench.cxx: Compare compile-time specialized converters (geo.hpp)
+//               with run-time dispatched batch conversion (geo.c)
+//
+#include "common.h"
+#include "geo.hpp"
+
+extern int gid_wgs; // selected geoid on WGS 84 (in geo.c)
+extern int hsel;    // output height calculation (in geo.c)
+
+static int n = 200000;
+static double *fi, *la, *h, *tmx, *tmy, *gkx, *gky, *ox, *oy, *oh, *cx, *cy, *ch;
+static double *px, *py, *ph;
+
+
+// ----------------------------------------------------------------------------
+// elapsed
+// Returns nanoseconds per point since start
+// ----------------------------------------------------------------------------
+static double elapsed(struct timespec *start, int np)
+{
+  struct timespec stop;
+
+  clock_gettime(CLOCK_REALTIME, &stop);
+  return ((stop.tv_sec - start->tv_sec)*(double)NANOSEC
+         + (stop.tv_nsec - start->tv_nsec))/np;
+} /* elapsed */
+
+
+// ----------------------------------------------------------------------------
+// run
+// Convert all points with scalar routines, with geo_convert_batch and with
+// specialized converter (arrays and single points), print speed of all four
+// and max. difference between converter and batch results
+// ----------------------------------------------------------------------------
+template <geo::From F, geo::To T, geo::Height H, int tr>
+static int run(const char *name)
+{
+  const geo::Converter<F, T, H> conv(gid_wgs);
+  GEOGRA fl, ofl; GEOUTM xy, oxy;
+  const double *ix, *iy;
+  double tsc, tc, tcxx, tpt, dxy, dh, dif;
+  struct timespec start;
+  int ii;
+
+  if (F == geo::From::ETRS89) { ix = fi; iy = la; }
+  else if (F == geo::From::D96TM) { ix = tmx; iy = tmy; }
+  else { ix = gkx; iy = gky; }
+
+  hsel = static_cast<int>(H); geo_ctx_default_update();
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) {
+    fl.fi = ix[ii]; fl.la = iy[ii]; fl.h = h[ii];
+    xy.x = ix[ii]; xy.y = iy[ii]; xy.H = h[ii];
+    switch (tr) {
+      case 1: tmxy2fila_wgs(xy, &ofl); ox[ii] = ofl.fi; break;
+      case 2: fila_wgs2tmxy(fl, &oxy); ox[ii] = oxy.x; break;
+      case 3: gkxy2fila_wgs(xy, &ofl); ox[ii] = ofl.fi; break;
+      case 4: fila_wgs2gkxy(fl, &oxy); ox[ii] = oxy.x; break;
+      case 5: gkxy2tmxy(xy, &oxy); ox[ii] = oxy.x; break;
+      case 6: tmxy2gkxy(xy, &oxy); ox[ii] = oxy.x; break;
+    }
+  }
+  tsc = elapsed(&start, n);
+
+  clock_gettime(CLOCK_REALTIME, &start);
+  geo_convert_batch(tr, n, ix, iy, h, cx, cy, ch, NULL);
+  tc = elapsed(&start, n);
+
+  clock_gettime(CLOCK_REALTIME, &start);
+  conv(n, ix, iy, h, ox, oy, oh);
+  tcxx = elapsed(&start, n);
+
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++)
+    conv(ix[ii], iy[ii], h[ii], px[ii], py[ii], ph[ii]);
+  tpt = elapsed(&start, n);
+
+  dxy = 0.0; dh = 0.0;
+  for (ii = 0; ii < n; ii++) {
+    dif = xfmax(fabs(ox[ii] - cx[ii]), fabs(oy[ii] - cy[ii]));
+    dif = xfmax(dif, xfmax(fabs(px[ii] - cx[ii]), fabs(py[ii] - cy[ii])));
+    if (dif > dxy) dxy = dif;
+    dif = xfmax(fabs(oh[ii] - ch[ii]), fabs(ph[ii] - ch[ii]));
+    if (dif > dh) dh = dif;
+  }
+  printf("-t %d %-27s: %6.1f ns/point, batch: %6.1f, converter: %6.1f, single points: %6.1f ns/point, max. difference %.1e, %.1e\n",
+         tr, name, tsc, tc, tcxx, tpt, dxy, dh);
+  return dxy > 1e-8 || dh > 1e-8;
+} /* run */
+
+
+// ----------------------------------------------------------------------------
+// main
+// ----------------------------------------------------------------------------
+int main()
+{
+  using geo::From; using geo::To; using geo::Height;
+  char *errtxt;
+  int ii, err;
+
+  fi = (double *)malloc(16*n*sizeof(double));
+  if (fi == NULL) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      fprintf(stderr, "malloc(bench): %s\n", errtxt); free(errtxt);
+    } else
+      fprintf(stderr, "malloc(bench): Can't allocate memory\n");
+    return 3;
+  }
+  la = fi + n; h = la + n; tmx = h + n; tmy = tmx + n; gkx = tmy + n;
+  gky = gkx + n; ox = gky + n; oy = ox + n; oh = oy + n;
+  cx = oh + n; cy = cx + n; ch = cy + n;
+  px = ch + n; py = px + n; ph = py + n;
+
+  ellipsoid_init();
+  params_init();
+  gid_wgs = 1; // slo2000
+
+  // Points on grid completely inside Slovenia
+  for (ii = 0; ii < n; ii++) {
+    fi[ii] = 45.676 + (ii/500)*(46.368 - 45.676)/400.0;
+    la[ii] = 13.920 + (ii%500)*(15.235 - 13.920)/500.0;
+    h[ii] = 300.0;
+  }
+  hsel = -1;
+  geo_convert_batch(2, n, fi, la, h, tmx, tmy, oh, NULL);
+  geo_convert_batch(4, n, fi, la, h, gkx, gky, oh, NULL);
+
+  printf("---------- Benchmark (%d points)\n", n);
+  err = geo::check_constants();
+  if (err != 0)
+    printf("%d constants of geo.hpp differ from geo.c\n", err);
+  err |= run<From::D96TM, To::ETRS89, Height::Default, 1>("d96tm->etrs89");
+  err |= run<From::ETRS89, To::D96TM, Height::Default, 2>("etrs89->d96tm");
+  err |= run<From::D48GK, To::ETRS89, Height::Default, 3>("d48gk->etrs89");
+  err |= run<From::D48GK, To::ETRS89, Height::Geoid, 3>("d48gk->etrs89 (geoid)");
+  err |= run<From::ETRS89, To::D48GK, Height::Default, 4>("etrs89->d48gk");
+  err |= run<From::ETRS89, To::D48GK, Height::Copied, 4>("etrs89->d48gk (copied)");
+  err |= run<From::D48GK, To::D96TM, Height::Default, 5>("d48gk->d96tm");
+  err |= run<From::D48GK, To::D96TM, Height::Transformed, 5>("d48gk->d96tm (transformed)");
+  err |= run<From::D96TM, To::D48GK, Height::Default, 6>("d96tm->d48gk");
+  err |= run<From::D96TM, To::D48GK, Height::Geoid, 6>("d96tm->d48gk (geoid)");
+
+  free(fi);
+  return err;
+} /* main */
@@ -32,6 +32,11 @@ int rev;     // reverse xy/fila
 
 extern int gid_wgs; // selected geoid on WGS 84 (in geo.c, via cmd line)
 extern int hsel;    // output height calculation (in geo.c, via cmd line)
+extern int tmsel;   // TM projection series (in geo.c, via cmd line)
+extern double gtol; // interpolation grid tolerance (in geo.c, via cmd line)
+extern int csel;    // Chebyshev approximation (in geo.c, via cmd line)
+extern int nthr;    // number of threads (in geo.c, via cmd line)
+extern int zsel;    // multi-zone GK coordinates (in geo.c, via cmd line)
 
 #ifdef _WIN32
 #ifdef __MINGW32__
@@ -65,6 +70,15 @@ void usage(int ver_only)
   fprintf(stderr, "  -hg               calculate output height from geoid model (default)\n");
   fprintf(stderr, "  -g slo|egm        select geoid model (Slo2000 or EGM2008)\n");
   fprintf(stderr, "                    default: Slo2000\n");
+  fprintf(stderr, "  -gf <file>        use selected geoid model from binary file\n");
+  fprintf(stderr, "  -ps               use tan-power series for TM projection (default)\n");
+  fprintf(stderr, "  -pk               use Krueger n-series for TM projection\n");
+  fprintf(stderr, "  -grid <tol>       use interpolation grid with sampled tolerance <tol> m\n");
+  fprintf(stderr, "  -cheb             use Chebyshev approximation (transformations 1, 3-6)\n");
+  fprintf(stderr, "  -gkz              d48gk xy in all GK zones (zone number in front of y,\n");
+  fprintf(stderr, "                    e.g. 6500000; transformations 3-6)\n");
+  fprintf(stderr, "  --reproducible    use SSE2 vector kernels without FMA (same results on all systems)\n");
+  fprintf(stderr, "  -j <n>            convert with <n> threads (0: all CPUs, default: 1)\n");
   fprintf(stderr, "  -t <n>            select transformation:\n");
   fprintf(stderr, "                     1: xy   (d96tm)  --> fila (etrs89), hg?, default\n");
   fprintf(stderr, "                     2: fila (etrs89) --> xy   (d96tm),  hg\n");
@@ -76,6 +90,8 @@ void usage(int ver_only)
   fprintf(stderr, "                     8: xy   (d96tm)  --> xy   (d48gk),  hc, affine trans.\n");
   fprintf(stderr, "                     9: xy   (d48gk)  --> fila (etrs89), hg, affine trans.\n");
   fprintf(stderr, "                    10: fila (etrs89) --> xy   (d48gk),  hg, affine trans.\n");
+  fprintf(stderr, "                    11: fila (etrs89) --> fila (etrs89), h --> H (geoid only)\n");
+  fprintf(stderr, "                    12: fila (etrs89) --> fila (etrs89), H --> h (geoid only)\n");
   fprintf(stderr, "  -r                reverse parsing order of xy/fila\n");
   fprintf(stderr, "                    (warning is displayed if y < 200000 or la > 17.0)\n");
   fprintf(stderr, "  <inpname>         parse and convert input data from <inpname>\n");
@@ -96,8 +112,8 @@ int main(int argc, char *argv[])
 #endif
   int ii, ac, opt;
   char *s, *av[MAXC], *errtxt;
-  char geoid[MAXS+1];
-  int value, warn;
+  char geoid[MAXS+1], gfile[MAXS+1];
+  int value, warn, repro;
   char inpname[MAXS+1], outname[MAXS+1], prjname[MAXS+1];
   static GEOGRA ifl, ofl; static GEOUTM ixy, oxy;
   struct timespec start, stop;
@@ -130,8 +146,15 @@ int main(int argc, char *argv[])
   tr = 1;      // default transformation: xy (d96tm) --> fila (etrs89)
   rev = 0;     // don't reverse xy/fila
   geoid[0] = '\0';
+  gfile[0] = '\0'; // compiled-in geoid model
   gid_wgs = 1; // slo2000
   hsel = -1;   // default height processing (use internal recommendations)
+  tmsel = 0;   // tan-power series
+  gtol = 0.0;  // exact conversion (no interpolation grid)
+  csel = 0;    // exact conversion (no Chebyshev approximation)
+  nthr = 1;    // single thread
+  zsel = 0;    // GK zone 5 only (Slovenia)
+  repro = 0;   // fastest vectorized kernels
 
   // Parse command line
   ac = 0; opt = 1;
@@ -150,12 +173,18 @@ int main(int argc, char *argv[])
         else goto usage;
         continue;
       }
+      else if (strcasecmp(argv[ii], "-gf") == 0) { // geoid model file
+        ii++; if (ii >= argc) goto usage;
+        xstrncpy(gfile, argv[ii], MAXS);
+        if (strlen(gfile) == 0) goto usage;
+        continue;
+      }
       else if (strcasecmp(argv[ii], "-t") == 0) { // transformation
         ii++; if (ii >= argc) goto usage;
         if (strlen(argv[ii]) == 0) goto usage;
         errno = 0; value = strtol(argv[ii], &s, 10);
         if (errno || *s) goto usage;
-        if (value < 1 || value > 10) goto usage;
+        if (value < 1 || value > 12) goto usage;
         tr = value;
         continue;
       }
@@ -171,6 +200,42 @@ int main(int argc, char *argv[])
         hsel = 2;
         continue;
       }
+      else if (strcasecmp(argv[ii], "-ps") == 0) { // tan-power series
+        tmsel = 0;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-pk") == 0) { // Krueger n-series
+        tmsel = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-grid") == 0) { // interpolation grid
+        ii++; if (ii >= argc) goto usage;
+        if (strlen(argv[ii]) == 0) goto usage;
+        errno = 0; gtol = strtod(argv[ii], &s);
+        if (errno || *s) goto usage;
+        if (gtol <= 0.0) goto usage;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-cheb") == 0) { // Chebyshev approximation
+        csel = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-gkz") == 0) { // multi-zone GK
+        zsel = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-j") == 0) { // number of threads
+        ii++; if (ii >= argc) goto usage;
+        if (strlen(argv[ii]) == 0) goto usage;
+        errno = 0; nthr = strtol(argv[ii], &s, 10);
+        if (errno || *s) goto usage;
+        if (nthr < 0) goto usage;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "--reproducible") == 0) { // SSE2 vector kernels only
+        repro = 1;
+        continue;
+      }
       else if (strcasecmp(argv[ii], "--") == 0) { // end of options
         opt = 0;
         continue;
@@ -211,6 +276,8 @@ usage:      usage(0);
   // geo.c initialization
   ellipsoid_init();
   params_init();
+  geo_simd_init(repro);
+  if (gfile[0] != '\0' && geoid_load_file(gid_wgs, gfile, NULL) != 0) exit(2);
 
   if (ac < 2) goto usage;
 
@@ -29,9 +29,17 @@ int debug;
 int tr;      // transformation
 int rev;     // reverse xy/fila
 int wdms;    // write DMS
+int rtrip;   // round-trip verification
 
 extern int gid_wgs; // selected geoid on WGS 84 (in geo.c, via cmd line)
 extern int hsel;    // output height calculation (in geo.c, via cmd line)
+extern int tmsel;   // TM projection series (in geo.c, via cmd line)
+extern double gtol; // interpolation grid tolerance (in geo.c, via cmd line)
+extern double jtol; // linearization cache tolerance (in geo.c, via cmd line)
+extern int csel;    // Chebyshev approximation (in geo.c, via cmd line)
+extern int nthr;    // number of threads (in geo.c, via cmd line)
+extern int zsel;    // multi-zone GK coordinates (in geo.c, via cmd line)
+extern PROJ tm;     // TM projection constants for Slovenia (in geo.c)
 
 #ifdef _WIN32
 #ifdef __MINGW32__
@@ -164,7 +172,8 @@ void reftest()
 #if 1
   printf("---------- Conversion D48/GK --> BESSEL (loop)\n");
   printf("<-- x: %.3f, y: %.3f, H: %.3f\n", d48ref.x, d48ref.y, d48ref.H);
-  xy2fila_ellips_loop(d48ref, &fl, 0);
+  if (!xy2fila_ellips_loop(d48ref, &fl, 0))
+    fprintf(stderr, "xy2fila_ellips_loop: not converged\n");
   if (hsel == 1) fl.h = fl.h - fl.Ng;
   deg2dms(fl.fi, &lat); deg2dms(fl.la, &lon);
   printf("--> fi: %.10f,   la: %.10f,  h: %.3f (no geoid)\n", fl.fi, fl.la, fl.h);
@@ -173,7 +182,8 @@ void reftest()
 
   printf("---------- result --> D48/GK (loop, inverse)\n");
   printf("<-- fi: %.10f, la: %.10f, h: %.3f (no geoid)\n", fl.fi, fl.la, fl.h);
-  fila_ellips2xy_loop(fl, &xy, 0);
+  if (!fila_ellips2xy_loop(fl, &xy, 0))
+    fprintf(stderr, "fila_ellips2xy_loop: not converged\n");
   if (hsel == 1) xy.H = xy.H + xy.Ng;
   printf("--> x: %.3f, y: %.3f, H: %.3f (no geoid)\n", xy.x, xy.y, xy.H);
 #endif
@@ -236,6 +246,439 @@ void reftest()
 } /* reftest */
 
 
+// ----------------------------------------------------------------------------
+// vectest
+// Compare vectorized kernels with scalar routines over GK zone 5 (Slovenia)
+// ----------------------------------------------------------------------------
+int vectest()
+{
+  GEOGRA fl, ofl; GEOUTM xy; GEOCEN xyz, oxyz;
+  double fi[64], la[64], h[64], x[64], y[64];
+  double dif, maxdif, maxdh, tol;
+  int ii, jj, oid, gid;
+  extern GKLM gkzones[]; // in geo.c
+  extern HELMERT7 slo7, slo7inv; // in geo.c
+
+  tol = 0.0001; // 0.1 mm
+  printf("---------- Vectorized kernels (%s, %d points in parallel)\n",
+         geo_simd_name(), geo_simd_width());
+
+  for (oid = 0; oid <= 1; oid++) {
+    maxdif = 0.0;
+    for (ii = 0; ii <= 150; ii++) {
+      for (jj = 0; jj < 64; jj++) {
+        fi[jj] = gkzones[5].fimin + ii*(gkzones[5].fimax - gkzones[5].fimin)/150.0;
+        la[jj] = gkzones[5].lamin + jj*(gkzones[5].lamax - gkzones[5].lamin)/63.0;
+      }
+      fila_ellips2xy_vec(64, fi, la, x, y, oid);
+      for (jj = 0; jj < 64; jj++) {
+        fl.fi = fi[jj]; fl.la = la[jj]; fl.h = 0.0;
+        fila_ellips2xy(fl, &xy, oid);
+        dif = xfmax(fabs(xy.x - x[jj]), fabs(xy.y - y[jj]));
+        if (dif > maxdif) maxdif = dif;
+      }
+    }
+    printf("fila_ellips2xy_vec(%s): max. difference %.3e m\n",
+           oid == 0 ? "bessel" : "wgs84", maxdif);
+    if (maxdif > tol) return 1;
+  }
+
+  tol = 1e-9; // degrees
+  for (oid = 0; oid <= 1; oid++) {
+    maxdif = 0.0;
+    for (ii = 0; ii <= 150; ii++) {
+      for (jj = 0; jj < 64; jj++) {
+        x[jj] = gkzones[5].xmin + ii*(gkzones[5].xmax - gkzones[5].xmin)/150.0;
+        y[jj] = gkzones[5].ymin + jj*(gkzones[5].ymax - gkzones[5].ymin)/63.0;
+      }
+      xy2fila_ellips_vec(64, x, y, fi, la, oid);
+      for (jj = 0; jj < 64; jj++) {
+        xy.x = x[jj]; xy.y = y[jj]; xy.H = 0.0;
+        xy2fila_ellips(xy, &fl, oid);
+        dif = xfmax(fabs(fl.fi - fi[jj]), fabs(fl.la - la[jj]));
+        if (dif > maxdif) maxdif = dif;
+      }
+    }
+    printf("xy2fila_ellips_vec(%s): max. difference %.3e deg\n",
+           oid == 0 ? "bessel" : "wgs84", maxdif);
+    if (maxdif > tol) return 1;
+  }
+
+  for (oid = 0; oid <= 1; oid++) { // source ellipsoid
+    maxdif = 0.0; maxdh = 0.0;
+    for (ii = 0; ii <= 150; ii++) {
+      for (jj = 0; jj < 64; jj++) {
+        fi[jj] = gkzones[5].fimin + ii*(gkzones[5].fimax - gkzones[5].fimin)/150.0;
+        la[jj] = gkzones[5].lamin + jj*(gkzones[5].lamax - gkzones[5].lamin)/63.0;
+        h[jj] = 10.0*jj;
+      }
+      fila_ellips2fila_helmert_vec(64, fi, la, h, x, y, h, oid == 0 ? slo7 : slo7inv, oid, 1 - oid);
+      for (jj = 0; jj < 64; jj++) {
+        fl.fi = fi[jj]; fl.la = la[jj]; fl.h = 10.0*jj;
+        fila_ellips2xyz(fl, &xyz, oid);
+        xyz2xyz_helmert(xyz, &oxyz, oid == 0 ? slo7 : slo7inv);
+        xyz2fila_ellips(oxyz, &ofl, 1 - oid);
+        dif = xfmax(fabs(ofl.fi - x[jj]), fabs(ofl.la - y[jj]));
+        if (dif > maxdif) maxdif = dif;
+        dif = fabs(ofl.h - h[jj]);
+        if (dif > maxdh) maxdh = dif;
+      }
+    }
+    printf("fila_ellips2fila_helmert_vec(%s): max. difference %.3e deg, %.3e m\n",
+           oid == 0 ? "bessel" : "wgs84", maxdif, maxdh);
+    if (maxdif > tol || maxdh > 0.0001) return 1;
+  }
+
+  tol = 1e-9; // m
+  for (gid = 1; gid <= 2; gid++) { // geoid model (area of model and beyond)
+    maxdh = 0.0;
+    for (ii = 0; ii <= 150; ii++) {
+      for (jj = 0; jj < 64; jj++) {
+        fi[jj] = 45.2 + ii*1.9/150.0;
+        la[jj] = 13.2 + jj*3.6/63.0;
+        h[jj] = 10.0*jj;
+      }
+      geo_geoid_batch(gid, -1, 64, fi, la, h, x);
+      geo_geoid_batch(gid, 1, 64, fi, la, h, y);
+      for (jj = 0; jj < 64; jj++) {
+        dif = xfmax(fabs(h[jj] - geoid_height(fi[jj], la[jj], gid) - x[jj]),
+                    fabs(h[jj] + geoid_height(fi[jj], la[jj], gid) - y[jj]));
+        if (dif > maxdh) maxdh = dif;
+      }
+    }
+    printf("geo_geoid_batch(%s): max. difference %.3e m\n",
+           gid == 1 ? "slo2000" : "egm2008", maxdh);
+    if (maxdh > tol) return 1;
+  }
+  return 0;
+} /* vectest */
+
+
+// ----------------------------------------------------------------------------
+// elapsed
+// Returns nanoseconds per point since start
+// ----------------------------------------------------------------------------
+double elapsed(struct timespec *start, int n)
+{
+  struct timespec stop;
+
+  clock_gettime(CLOCK_REALTIME, &stop);
+  return ((stop.tv_sec - start->tv_sec)*(double)NANOSEC
+         + (stop.tv_nsec - start->tv_nsec))/n;
+} /* elapsed */
+
+
+// ----------------------------------------------------------------------------
+// benchmark
+// Measure speed (ns/point) of scalar and batch conversion routines
+// ----------------------------------------------------------------------------
+int benchmark()
+{
+  GEOGRA fl, ofl; GEOUTM xy, oxy;
+  double *fi, *la, *h, *tmx, *tmy, *gkx, *gky, *ox, *oy, *oh;
+  double *ix, *iy, tsc, tbt, tl1, tl2, sum, dif, maxdif;
+  struct timespec start;
+  char *errtxt;
+  int ii, jj, n, t, last_tri;
+
+  n = 200000;
+  fi = (double *)malloc(10*n*sizeof(double));
+  if (fi == NULL) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      fprintf(stderr, "malloc(bench): %s\n", errtxt); free(errtxt);
+    } else
+      fprintf(stderr, "malloc(bench): Can't allocate memory\n");
+    return 3;
+  }
+  la = fi + n; h = la + n; tmx = h + n; tmy = tmx + n;
+  gkx = tmy + n; gky = gkx + n; ox = gky + n; oy = ox + n; oh = oy + n;
+
+  // Points on grid completely inside Slovenia
+  for (ii = 0; ii < n; ii++) {
+    fi[ii] = 45.676 + (ii/500)*(46.368 - 45.676)/400.0;
+    la[ii] = 13.920 + (ii%500)*(15.235 - 13.920)/500.0;
+    h[ii] = 300.0;
+  }
+  geo_convert_batch(2, n, fi, la, h, tmx, tmy, oh, NULL);
+  geo_convert_batch(4, n, fi, la, h, gkx, gky, oh, NULL);
+
+  printf("---------- Benchmark (%d points, %s, %d points in parallel)\n",
+         n, geo_simd_name(), geo_simd_width());
+  // Meridian arc length: Clenshaw (L4) vs. term by term L1 and L2 series
+  // on the same latitudes (sums keep the loops from being optimized away)
+  for (ii = 0; ii < n; ii++) ox[ii] = fi[ii]*M_PI/180.0;
+  sum = 0.0;
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) sum += arc_length(ox[ii], 1);
+  tsc = elapsed(&start, n);
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) sum += arc_length_sum(ox[ii], 1, 1);
+  tl1 = elapsed(&start, n);
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) sum += arc_length_sum(ox[ii], 1, 2);
+  tl2 = elapsed(&start, n);
+  maxdif = 0.0;
+  for (ii = 0; ii < n; ii++) {
+    dif = fabs(arc_length(ox[ii], 1) - arc_length_sum(ox[ii], 1, 1));
+    if (dif > maxdif) maxdif = dif;
+  }
+  printf("arc_length: Clenshaw (L4): %6.1f ns/point, L1: %6.1f ns/point, L2: %6.1f ns/point\n",
+         tsc, tl1, tl2);
+  printf("            max. L4-L1 difference: %.3e m (checksum %.6e)\n", maxdif, sum);
+
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) {
+    fl.fi = fi[ii]; fl.la = la[ii]; fl.h = h[ii];
+    fila_ellips2xy(fl, &xy, 1);
+    ox[ii] = xy.x;
+  }
+  tsc = elapsed(&start, n);
+  clock_gettime(CLOCK_REALTIME, &start);
+  fila_ellips2xy_vec(n, fi, la, ox, oy, 1);
+  tbt = elapsed(&start, n);
+  printf("fila_ellips2xy: %8.1f ns/point, vectorized: %8.1f ns/point\n", tsc, tbt);
+
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) {
+    xy.x = tmx[ii]; xy.y = tmy[ii]; xy.H = h[ii];
+    xy2fila_ellips(xy, &fl, 1);
+    ox[ii] = fl.fi;
+  }
+  tsc = elapsed(&start, n);
+  clock_gettime(CLOCK_REALTIME, &start);
+  xy2fila_ellips_vec(n, tmx, tmy, ox, oy, 1);
+  tbt = elapsed(&start, n);
+  printf("xy2fila_ellips: %8.1f ns/point, vectorized: %8.1f ns/point\n", tsc, tbt);
+
+  t = tmsel; tmsel = 1; // Krueger n-series
+  geo_ctx_default_update();
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) {
+    fl.fi = fi[ii]; fl.la = la[ii]; fl.h = h[ii];
+    fila_ellips2xy(fl, &xy, 1);
+    ox[ii] = xy.x;
+  }
+  tsc = elapsed(&start, n);
+  clock_gettime(CLOCK_REALTIME, &start);
+  fila2xy_krueger_proj_vec(&tm, n, fi, la, ox, oy, 1);
+  tbt = elapsed(&start, n);
+  printf("Krueger n-series: fila_ellips2xy: %8.1f ns/point, vectorized: %8.1f ns/point\n", tsc, tbt);
+  clock_gettime(CLOCK_REALTIME, &start);
+  for (ii = 0; ii < n; ii++) {
+    xy.x = tmx[ii]; xy.y = tmy[ii]; xy.H = h[ii];
+    xy2fila_ellips(xy, &fl, 1);
+    ox[ii] = fl.fi;
+  }
+  tsc = elapsed(&start, n);
+  clock_gettime(CLOCK_REALTIME, &start);
+  xy2fila_krueger_proj_vec(&tm, n, tmx, tmy, ox, oy, 1);
+  tbt = elapsed(&start, n);
+  tmsel = t;
+  geo_ctx_default_update();
+  printf("Krueger n-series: xy2fila_ellips: %8.1f ns/point, vectorized: %8.1f ns/point\n", tsc, tbt);
+
+  for (t = 1; t <= 12; t++) {
+    if (t == 2 || t == 4 || t >= 10) { ix = fi; iy = la; }      // etrs89
+    else if (t == 1 || t == 6 || t == 8) { ix = tmx; iy = tmy; } // d96tm
+    else { ix = gkx; iy = gky; }                                 // d48gk
+    last_tri = -1;
+    memset(&ofl, 0, sizeof(GEOGRA)); memset(&oxy, 0, sizeof(GEOUTM));
+
+    clock_gettime(CLOCK_REALTIME, &start);
+    for (ii = 0; ii < n; ii++) {
+      fl.fi = ix[ii]; fl.la = iy[ii]; fl.h = h[ii];
+      xy.x = ix[ii]; xy.y = iy[ii]; xy.H = h[ii];
+      switch (t) {
+        case 1: tmxy2fila_wgs(xy, &ofl); break;
+        case 2: fila_wgs2tmxy(fl, &oxy); break;
+        case 3: gkxy2fila_wgs(xy, &ofl); break;
+        case 4: fila_wgs2gkxy(fl, &oxy); break;
+        case 5: gkxy2tmxy(xy, &oxy); break;
+        case 6: tmxy2gkxy(xy, &oxy); break;
+        case 7: gkxy2tmxy_aft(xy, &oxy, &last_tri); break;
+        case 8: tmxy2gkxy_aft(xy, &oxy, &last_tri); break;
+        case 9: gkxy2fila_wgs_aft(xy, &ofl, &last_tri); break;
+        case 10: fila_wgs2gkxy_aft(fl, &oxy, &last_tri); break;
+        case 11: ofl.h = fl.h - geoid_height(fl.fi, fl.la, gid_wgs); break;
+        case 12: ofl.h = fl.h + geoid_height(fl.fi, fl.la, gid_wgs); break;
+      }
+      ox[ii] = oxy.x + ofl.fi + ofl.h;
+    }
+    tsc = elapsed(&start, n);
+
+    clock_gettime(CLOCK_REALTIME, &start);
+    jj = geo_convert_batch(t, n, ix, iy, h, ox, oy, oh, NULL);
+    tbt = elapsed(&start, n);
+    printf("-t %-2d: %8.1f ns/point, batch: %8.1f ns/point (%d converted)\n", t, tsc, tbt, jj);
+  }
+
+  free(fi);
+  return 0;
+} /* benchmark */
+
+
+// ----------------------------------------------------------------------------
+// chebtest
+// Compare Chebyshev approximation (see geo_cheb.h) with exact conversion
+// inside Slovenia (deviation over the whole area of geoid model is measured
+// by geo_cheb_fit). Returns 0 if OK or 1 if tolerance is exceeded.
+// ----------------------------------------------------------------------------
+int chebtest()
+{
+  GEO_CTX ctx; GEO_PLAN plan;
+  double *fi, *la, *h, *tmx, *tmy, *gkx, *gky, *ix, *iy, *ox, *oy, *oh, *cx, *cy, *ch;
+  double dx, dy, dif, maxdif, maxdh, te, tc, tol;
+  struct timespec start;
+  char *errtxt;
+  int ii, n, t;
+  extern GEO_CHEB geo_cheb[]; // in geo.c
+
+  n = 200000;
+  fi = (double *)malloc(13*n*sizeof(double));
+  if (fi == NULL) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      fprintf(stderr, "malloc(chebtest): %s\n", errtxt); free(errtxt);
+    } else
+      fprintf(stderr, "malloc(chebtest): Can't allocate memory\n");
+    return 3;
+  }
+  la = fi + n; h = la + n; tmx = h + n; tmy = tmx + n; gkx = tmy + n; gky = gkx + n;
+  ox = gky + n; oy = ox + n; oh = oy + n; cx = oh + n; cy = cx + n; ch = cy + n;
+
+  // Points on grid completely inside Slovenia (geoid model has holes
+  // outside, where geoid height jumps)
+  for (ii = 0; ii < n; ii++) {
+    fi[ii] = 45.676 + (ii/500)*(46.368 - 45.676)/400.0;
+    la[ii] = 13.920 + (ii%500)*(15.235 - 13.920)/500.0;
+    h[ii] = (ii%2801)*1.0;
+  }
+  geo_convert_batch(2, n, fi, la, h, tmx, tmy, oh, NULL);
+  geo_convert_batch(4, n, fi, la, h, gkx, gky, oh, NULL);
+
+  tol = 0.001; // 1 mm
+  printf("---------- Chebyshev approximation (%d points)\n", n);
+  geo_ctx_init(&ctx);
+  for (t = 1; t <= 6; t++) {
+    if (t == 2 || t == 4) { ix = fi; iy = la; }      // etrs89
+    else if (t == 1 || t == 6) { ix = tmx; iy = tmy; } // d96tm
+    else { ix = gkx; iy = gky; }                     // d48gk
+
+    ctx.csel = 0; geo_plan_init(&plan, t, &ctx);
+    clock_gettime(CLOCK_REALTIME, &start);
+    geo_plan_run(&plan, n, ix, iy, h, ox, oy, oh, NULL);
+    te = elapsed(&start, n);
+    ctx.csel = 1; geo_plan_init(&plan, t, &ctx);
+    if (plan.cheb == NULL) { // exact conversion is faster
+      printf("-t %d: approximation not used, exact: %6.1f ns/point\n", t, te);
+      continue;
+    }
+    clock_gettime(CLOCK_REALTIME, &start);
+    geo_plan_run(&plan, n, ix, iy, h, cx, cy, ch, NULL);
+    tc = elapsed(&start, n);
+
+    maxdif = 0.0; maxdh = 0.0;
+    for (ii = 0; ii < n; ii++) {
+      dx = cx[ii] - ox[ii]; dy = cy[ii] - oy[ii];
+      if (t == 1 || t == 3) { // degrees to m (approx.)
+        dx *= 111320.0; dy *= 111320.0*cos(ox[ii]*M_PI/180.0);
+      }
+      dif = sqrt(dx*dx + dy*dy);
+      if (dif > maxdif) maxdif = dif;
+      dif = fabs(ch[ii] - oh[ii]);
+      if (dif > maxdh) maxdh = dif;
+    }
+    printf("-t %d: degree %d, max. difference %.3e m, %.3e m (fit: %.3e m), exact: %6.1f ns/point, approx.: %6.1f ns/point\n",
+           t, geo_cheb[t-1].deg, maxdif, maxdh, geo_cheb[t-1].maxerr, te, tc);
+    if (!(maxdif <= tol && maxdh <= tol)) { free(fi); return 1; }
+  }
+
+  free(fi);
+  return 0;
+} /* chebtest */
+
+
+// ----------------------------------------------------------------------------
+// f32test
+// Compare single precision local approximation (see geo_f32_init) with exact
+// conversion in 10 km tiles inside Slovenia and measure conversion speed.
+// Returns 0 if OK or 1 if tolerance (1 cm) is exceeded.
+// ----------------------------------------------------------------------------
+int f32test()
+{
+  GEO_CTX ctx; GEO_PLAN plan; GEO_F32 f;
+  double *ix, *iy, *h, *ox, *oy, *oh, *fx, *fy;
+  double fi0, la0, x0, y0, h0, dx, dy, dif, maxdif, maxfit, te, tf, tol, r;
+  struct timespec start;
+  char *errtxt;
+  int ii, jj, n, nt, t;
+
+  n = 4096; // points per tile
+  ix = (double *)malloc(8*n*sizeof(double));
+  if (ix == NULL) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      fprintf(stderr, "malloc(f32test): %s\n", errtxt); free(errtxt);
+    } else
+      fprintf(stderr, "malloc(f32test): Can't allocate memory\n");
+    return 3;
+  }
+  iy = ix + n; h = iy + n; ox = h + n; oy = ox + n; oh = oy + n; fx = oh + n; fy = fx + n;
+
+  tol = 0.01; r = 10000.0; // 1 cm within 10 km from origin
+  h0 = 300.0;
+  for (ii = 0; ii < n; ii++) h[ii] = h0;
+  printf("---------- Single precision approximation (%d tiles, %d points per tile, %s)\n",
+         20, n, geo_simd_name());
+  geo_ctx_init(&ctx); ctx.hsel = 1; // heights are not converted
+  for (t = 1; t <= 6; t++) {
+    geo_plan_init(&plan, t, &ctx);
+    maxdif = 0.0; maxfit = 0.0; te = 0.0; tf = 0.0;
+    for (nt = 0; nt < 20; nt++) {
+      // Tile origins on 5x4 grid inside Slovenia
+      fi0 = 45.75 + (nt/5)*(46.30 - 45.75)/3.0;
+      la0 = 14.00 + (nt%5)*(15.15 - 14.00)/4.0;
+      if (plan.ifila) { x0 = fi0; y0 = la0; }
+      else geo_convert_batch((t == 1 || t == 6) ? 2 : 4, 1, &fi0, &la0, &h0, &x0, &y0, &dif, NULL);
+      geo_f32_init(&f, &plan, x0, y0, r, h0);
+      if (f.maxerr > maxfit) maxfit = f.maxerr;
+
+      // Points spread over the tile (in m from origin)
+      for (ii = 0; ii < n; ii++) {
+        dx = ((ii*37)%n)*(2.0*r/n) - r; dy = (ii%64)*(2.0*r/63) - r;
+        if (plan.ifila) {
+          dx /= 111320.0; dy /= 111320.0*cos(fi0*M_PI/180.0);
+        }
+        ix[ii] = x0 + dx; iy[ii] = y0 + dy;
+      }
+
+      clock_gettime(CLOCK_REALTIME, &start);
+      geo_plan_run(&plan, n, ix, iy, h, ox, oy, oh, NULL);
+      te += elapsed(&start, n);
+      clock_gettime(CLOCK_REALTIME, &start);
+      geo_f32_run(&f, n, ix, iy, fx, fy);
+      tf += elapsed(&start, n);
+
+      for (jj = 0; jj < n; jj++) {
+        dx = fx[jj] - ox[jj]; dy = fy[jj] - oy[jj];
+        if (plan.ofila) { // degrees to m (approx.)
+          dx *= 111320.0; dy *= 111320.0*cos(ox[jj]*M_PI/180.0);
+        }
+        dif = sqrt(dx*dx + dy*dy);
+        if (!(dif <= maxdif)) maxdif = dif; // also NaN
+      }
+    }
+    printf("-t %d: max. difference %.3e m (fit: %.3e m), exact: %6.1f ns/point, single: %6.1f ns/point\n",
+           t, maxdif, maxfit, te/20, tf/20);
+    if (!(maxdif <= tol)) { free(ix); return 1; }
+  }
+
+  free(ix);
+  return 0;
+} /* f32test */
+
+
 // ----------------------------------------------------------------------------
 // gendata_xy
 // ----------------------------------------------------------------------------
@@ -366,6 +809,87 @@ void gendata_fila()
 } /* gendata_fila */
 
 
+// ----------------------------------------------------------------------------
+// gencheb
+// Fit Chebyshev approximations of transformations 1-6 with total degree deg
+// (0: lowest degree close to best, see geo_cheb_fit) and write them as
+// C source (geo_cheb.h) to stdout
+// ----------------------------------------------------------------------------
+int gencheb(int deg)
+{
+  GEO_CHEB ch;
+  int ii, jj, kk, t;
+
+  printf("// GK - Converter between Gauss-Krueger/TM and WGS84 coordinates for Slovenia\n");
+  printf("// Copyright (c) 2014-2019 Matjaz Rihtar <matjaz@eunet.si>\n");
+  printf("// All rights reserved.\n");
+  printf("//\n");
+  printf("// This program is free software: you can redistribute it and/or modify\n");
+  printf("// it under the terms of the GNU Lesser General Public License as published\n");
+  printf("// by the Free Software Foundation, either version 2.1 of the License, or\n");
+  printf("// (at your option) any later version.\n");
+  printf("//\n");
+  printf("// This program is distributed in the hope that it will be useful,\n");
+  printf("// but WITHOUT ANY WARRANTY; without even the implied warranty of\n");
+  printf("// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the\n");
+  printf("// GNU Lesser General Public License for more details.\n");
+  printf("//\n");
+  printf("// You should have received a copy of the GNU Lesser General Public License\n");
+  printf("// along with this program; if not, see http://www.gnu.org/licenses/\n");
+  printf("//\n");
+  printf("// geo_cheb.h: Chebyshev approximation of transformations 1-6 for Slovenia\n");
+  printf("// (generated with gk-slo -gc, don't edit)\n");
+  printf("//\n");
+  printf("GEO_CHEB geo_cheb[6] = {\n");
+  for (t = 1; t <= 6; t++) {
+    if (geo_cheb_fit(&ch, t, deg) != 0) {
+      fprintf(stderr, "Can't fit Chebyshev approximation for transformation %d\n", t);
+      return 1;
+    }
+    printf("{%d, %d, %d, {", ch.tr, ch.deg, ch.nc);
+    for (kk = 0; kk < 8; kk++) printf("%d%s", ch.vdeg[kk], kk < 7 ? ", " : "");
+    printf("}, %.17g, %.17g, %.17g, %.17g, %.3e, { // max. deviation %.3e m\n",
+           ch.x0, ch.y0, ch.sx, ch.sy, ch.maxerr, ch.maxerr);
+    for (kk = 0; kk < ch.nc; kk++) {
+      printf("  {");
+      for (ii = 0, jj = (ch.vdeg[kk] + 1)*(ch.vdeg[kk] + 2)/2; ii < jj; ii++)
+        printf("%.17g%s%s", ch.c[kk][ii], ii < jj - 1 ? "," : "",
+               (ii%4 == 3 && ii < jj - 1) ? "\n   " : "");
+      printf("}%s\n", kk < ch.nc - 1 ? "," : "");
+    }
+    printf("}}%s\n", t < 6 ? "," : "");
+  }
+  printf("};\n");
+  return 0;
+} /* gencheb */
+
+
+// ----------------------------------------------------------------------------
+// savegeoid
+// Write selected geoid model (compiled-in or loaded) to binary file
+// ----------------------------------------------------------------------------
+int savegeoid(const char *fname)
+{
+  char *errtxt;
+  int rc;
+
+  rc = geoid_save(gid_wgs, fname);
+  if (rc == -1) {
+    errtxt = xstrerror();
+    if (errtxt != NULL) {
+      fprintf(stderr, "%s: %s\n", fname, errtxt); free(errtxt);
+    } else
+      fprintf(stderr, "%s: Can't write geoid model file\n", fname);
+    return 2;
+  }
+  else if (rc != 0) {
+    fprintf(stderr, "No geoid model\n");
+    return 1;
+  }
+  return 0;
+} /* savegeoid */
+
+
 // ----------------------------------------------------------------------------
 // usage
 // ----------------------------------------------------------------------------
@@ -377,6 +901,11 @@ void usage(int ver_only)
   fprintf(stderr, "Usage: %s [<options>] [<inpname> ...]\n", prog);
   fprintf(stderr, "  -d                enable debug output\n");
   fprintf(stderr, "  -x                print reference test and exit\n");
+  fprintf(stderr, "  -xv               compare vectorized kernels with scalar routines and exit\n");
+  fprintf(stderr, "  -xc               compare Chebyshev approximation with exact conversion and exit\n");
+  fprintf(stderr, "  -xf               compare single precision approximation with exact conversion and exit\n");
+  fprintf(stderr, "  -gc               generate Chebyshev approximation (geo_cheb.h) and exit\n");
+  fprintf(stderr, "  -b                measure conversion speed (ns/point) and exit\n");
   fprintf(stderr, "  -gd <n>           generate data (inside Slovenia) and exit\n");
   fprintf(stderr, "                    1: generate xy   (d96tm)  data\n");
   fprintf(stderr, "                    2: generate fila (etrs89) data\n");
@@ -386,7 +915,21 @@ void usage(int ver_only)
   fprintf(stderr, "  -hg               calculate output height from geoid model (default)\n");
   fprintf(stderr, "  -g slo|egm        select geoid model (Slo2000 or EGM2008)\n");
   fprintf(stderr, "                    default: Slo2000\n");
+  fprintf(stderr, "  -gf <file>        use selected geoid model from binary file\n");
+  fprintf(stderr, "  -wg <file>        write selected geoid model to binary file and exit\n");
+  fprintf(stderr, "                    (loaded with -gf <file> first, if given)\n");
+  fprintf(stderr, "  -ps               use tan-power series for TM projection (default)\n");
+  fprintf(stderr, "  -pk               use Krueger n-series for TM projection\n");
+  fprintf(stderr, "  -grid <tol>       use interpolation grid with sampled tolerance <tol> m\n");
+  fprintf(stderr, "  -lin <tol>        use verified linear maps of 50 m cells with tolerance <tol> m\n");
+  fprintf(stderr, "  -cheb             use Chebyshev approximation (transformations 1, 3-6)\n");
+  fprintf(stderr, "  -gkz              d48gk xy in all GK zones (zone number in front of y,\n");
+  fprintf(stderr, "                    e.g. 6500000; transformations 3-6)\n");
   fprintf(stderr, "  -dms              display fila in DMS format after height\n");
+  fprintf(stderr, "  --reproducible    use SSE2 vector kernels without FMA (same results on all systems)\n");
+  fprintf(stderr, "  -j <n>            convert with <n> threads (0: all CPUs, default: 1)\n");
+  fprintf(stderr, "  -rt               verify conversion by exact inverse transformation\n");
+  fprintf(stderr, "                    (max. horizontal deviation is displayed at the end)\n");
   fprintf(stderr, "  -t <n>            select transformation:\n");
   fprintf(stderr, "                     1: xy   (d96tm)  --> fila (etrs89), hg?, default\n");
   fprintf(stderr, "                     2: fila (etrs89) --> xy   (d96tm),  hg\n");
@@ -398,6 +941,8 @@ void usage(int ver_only)
   fprintf(stderr, "                     8: xy   (d96tm)  --> xy   (d48gk),  hc, affine trans.\n");
   fprintf(stderr, "                     9: xy   (d48gk)  --> fila (etrs89), hg, affine trans.\n");
   fprintf(stderr, "                    10: fila (etrs89) --> xy   (d48gk),  hg, affine trans.\n");
+  fprintf(stderr, "                    11: fila (etrs89) --> fila (etrs89), h --> H (geoid only)\n");
+  fprintf(stderr, "                    12: fila (etrs89) --> fila (etrs89), H --> h (geoid only)\n");
   fprintf(stderr, "  -r                reverse parsing order of xy/fila\n");
   fprintf(stderr, "                    (warning is displayed if y < 200000 or la > 17.0)\n");
   fprintf(stderr, "  <inpname>         parse and convert input data from <inpname>\n");
@@ -424,8 +969,8 @@ int main(int argc, char *argv[])
 #endif
   int ii, ac, opt;
   char *s, *av[MAXC], *errtxt;
-  char geoid[MAXS+1];
-  int value, test, gd;
+  char geoid[MAXS+1], gfile[MAXS+1], wfile[MAXS+1];
+  int value, test, gd, repro;
   char outname[MAXS+1];
   int inpf, outf;
   FILE *out;
@@ -449,12 +994,22 @@ int main(int argc, char *argv[])
   tr = 1;      // default transformation: xy (d96tm) --> fila (etrs89)
   rev = 0;     // don't reverse xy/fila
   wdms = 0;    // don't write DMS
+  rtrip = 0;   // no round-trip verification
   geoid[0] = '\0';
+  gfile[0] = '\0'; // compiled-in geoid model
+  wfile[0] = '\0'; // don't write geoid model
   gid_wgs = 1; // slo2000
   inpf = 1;    // stdin
   outf = 1;    // stdout
   outname[0] = '\0';
   hsel = -1;   // default height processing (use internal recommendations)
+  tmsel = 0;   // tan-power series
+  gtol = 0.0;  // exact conversion (no interpolation grid)
+  jtol = 0.0;  // exact conversion (no linearization)
+  csel = 0;    // exact conversion (no Chebyshev approximation)
+  nthr = 1;    // single thread
+  zsel = 0;    // GK zone 5 only (Slovenia)
+  repro = 0;   // fastest vectorized kernels
 
   // Parse command line
   ac = 0; opt = 1;
@@ -473,12 +1028,25 @@ int main(int argc, char *argv[])
         else goto usage;
         continue;
       }
+      else if (strcasecmp(argv[ii], "-gf") == 0) { // geoid model file
+        ii++; if (ii >= argc) goto usage;
+        xstrncpy(gfile, argv[ii], MAXS);
+        if (strlen(gfile) == 0) goto usage;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-wg") == 0) { // write geoid model file
+        ii++; if (ii >= argc) goto usage;
+        xstrncpy(wfile, argv[ii], MAXS);
+        if (strlen(wfile) == 0) goto usage;
+        test = 7;
+        continue;
+      }
       else if (strcasecmp(argv[ii], "-t") == 0) { // transformation
         ii++; if (ii >= argc) goto usage;
         if (strlen(argv[ii]) == 0) goto usage;
         errno = 0; value = strtol(argv[ii], &s, 10);
         if (errno || *s) goto usage;
-        if (value < 1 || value > 10) goto usage;
+        if (value < 1 || value > 12) goto usage;
         tr = value;
         continue;
       }
@@ -512,10 +1080,74 @@ int main(int argc, char *argv[])
         hsel = 2;
         continue;
       }
+      else if (strcasecmp(argv[ii], "-ps") == 0) { // tan-power series
+        tmsel = 0;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-pk") == 0) { // Krueger n-series
+        tmsel = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-grid") == 0) { // interpolation grid
+        ii++; if (ii >= argc) goto usage;
+        if (strlen(argv[ii]) == 0) goto usage;
+        errno = 0; gtol = strtod(argv[ii], &s);
+        if (errno || *s) goto usage;
+        if (gtol <= 0.0) goto usage;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-rt") == 0) { // round-trip verification
+        rtrip = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-lin") == 0) { // linearization cache
+        ii++; if (ii >= argc) goto usage;
+        if (strlen(argv[ii]) == 0) goto usage;
+        errno = 0; jtol = strtod(argv[ii], &s);
+        if (errno || *s) goto usage;
+        if (jtol <= 0.0) goto usage;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-xv") == 0) { // vectorized kernels test
+        test = 2;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-xc") == 0) { // Chebyshev approximation test
+        test = 4;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-xf") == 0) { // single precision approximation test
+        test = 6;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-gc") == 0) { // generate Chebyshev approximation
+        test = 5;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-cheb") == 0) { // Chebyshev approximation
+        csel = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-gkz") == 0) { // multi-zone GK
+        zsel = 1;
+        continue;
+      }
+      else if (strcasecmp(argv[ii], "-j") == 0) { // number of threads
+        ii++; if (ii >= argc) goto usage;
+        if (strlen(argv[ii]) == 0) goto usage;
+        errno = 0; nthr = strtol(argv[ii], &s, 10);
+        if (errno || *s) goto usage;
+        if (nthr < 0) goto usage;
+        continue;
+      }
       else if (strcasecmp(argv[ii], "-dms") == 0) { // write DMS
         wdms = 1;
         continue;
       }
+      else if (strcasecmp(argv[ii], "--reproducible") == 0) { // SSE2 vector kernels only
+        repro = 1;
+        continue;
+      }
       else if (strcasecmp(argv[ii], "--") == 0) { // end of options
         opt = 0;
         continue;
@@ -532,6 +1164,9 @@ int main(int argc, char *argv[])
           case 'x': // test
             test = 1;
             break;
+          case 'b': // benchmark
+            test = 3;
+            break;
           case 'v': // version
             usage(1); // show version only
             exit(0);
@@ -559,8 +1194,34 @@ usage:      usage(0);
   // geo.c initialization
   ellipsoid_init();
   params_init();
+  geo_simd_init(repro);
+
+  if (test == 7 && strcmp(wfile, gfile) == 0) {
+    fprintf(stderr, "%s: Can't write geoid model to the file it is loaded from\n", wfile);
+    exit(2);
+  }
+  if (gfile[0] != '\0' && geoid_load_file(gid_wgs, gfile, NULL) != 0) exit(2);
+
+  if (test == 7) {
+    exit(savegeoid(wfile));
+  }
 
-  if (test) {
+  if (test == 6) {
+    exit(f32test());
+  }
+  else if (test == 5) {
+    exit(gencheb(0));
+  }
+  else if (test == 4) {
+    exit(chebtest());
+  }
+  else if (test == 3) {
+    exit(benchmark());
+  }
+  else if (test == 2) {
+    exit(vectest());
+  }
+  else if (test) {
     reftest();
     exit(0);
   }
@@ -69,6 +69,7 @@ int debug;
 int tr;      // transformation
 int rev;     // reverse xy/fila
 int wdms;    // write DMS
+int rtrip;   // round-trip verification (not used in GUI)
 
 extern int gid_wgs; // selected geoid on WGS 84 (in geo.c)
 extern int hsel;    // output height calculation (in geo.c)
@@ -122,6 +123,7 @@ int convert_shp_file(TCHAR *inpurl, TCHAR *outurl, TCHAR *msg); // in conv.c
 
 // FLTK callback function prototypes
 void open_cb(Fl_Widget *w, void *p);
+void geoidfile_cb(Fl_Widget *w, void *p);
 void quit_cb(Fl_Widget *w, void *p);
 void help_cb(Fl_Widget *w, void *p);
 void clear_cb(Fl_Widget *w, void *p);
@@ -131,7 +133,8 @@ void ftchoice_cb(Fl_Widget *w, void *p);
 // FLTK global variables
 Fl_Menu_Item menubar_entries[] = {
   {"&File", 0, 0, 0, FL_SUBMENU},
-    {"&Open", FL_ALT+'o',  open_cb, 0, FL_MENU_DIVIDER},
+    {"&Open", FL_ALT+'o',  open_cb, 0},
+    {"Load &geoid model", 0, geoidfile_cb, 0, FL_MENU_DIVIDER},
     {"&Quit", FL_ALT+'q',  quit_cb},
     {0},
   {"&Edit", 0, 0, 0, FL_SUBMENU},
@@ -1031,6 +1034,58 @@ void open_cb(Fl_Widget *w, void *p)
 } /* open_cb */
 
 
+// ----------------------------------------------------------------------------
+// geoidfile_cb
+// Use selected geoid model from binary file (see gk-slo -wg) instead of
+// compiled-in model
+// ----------------------------------------------------------------------------
+void geoidfile_cb(Fl_Widget *w, void *p)
+{
+  Fl_Native_File_Chooser *nfc;
+  char line[MAXS+1], *msg, *s, *msgp;
+  int busy;
+
+  pthread_mutex_lock(&tn_mutex);
+  busy = tn > 0;
+  pthread_mutex_unlock(&tn_mutex);
+  if (busy) { // model can't be replaced while files are converted
+    fl_alert("Can't load geoid model while converting files");
+    return;
+  }
+
+  nfc = new Fl_Native_File_Chooser();
+  nfc->title("Select geoid model");
+  nfc->type(Fl_Native_File_Chooser::BROWSE_FILE);
+  nfc->filter("Geoid Models\t*.geoid\n"
+              "All Files\t*\n");
+
+  switch (nfc->show()) {
+    case -1: xlog("geoidfile_cb: error = %s\n", nfc->errmsg()); break;
+    case  1: xlog("geoidfile_cb: cancel\n"); break;
+    default:
+      xlog("geoidfile_cb: selected = %s, gid_wgs = %d\n", nfc->filename(), gid_wgs);
+      msg = new char[MAXL+1]; *msg = '\0';
+      if (geoid_load_file(gid_wgs, nfc->filename(), msg) == 0)
+        snprintf(line, MAXS, "Using geoid model %s\n", nfc->filename());
+      else
+        line[0] = '\0';
+
+      tab1->show(); // switch to drag & drop area tab
+      if (line[0] != '\0') { brow->add(line); brow->bottomline(brow->size()); }
+      s = xstrtok_r(msg, "\r\n", &msgp);
+      while (s != NULL) {
+        xlog("%s\n", s);
+        snprintf(line, MAXS, "@C1%s", s); // write errors in red
+        brow->add(line); brow->bottomline(brow->size());
+        s = xstrtok_r(NULL, "\r\n", &msgp);
+      }
+      delete msg;
+      break;
+  }
+  delete nfc;
+} /* geoidfile_cb */
+
+
 // ----------------------------------------------------------------------------
 // quit_cb
 // ----------------------------------------------------------------------------
@@ -1209,6 +1264,7 @@ void geoid_cb(Fl_Widget *w, void *p)
     case 1: gid_wgs = 2; break; // EGM 2008
     default: break;
   }
+  geo_ctx_default_update();
   xlog("geoid_cb: button = %s, gid_wgs = %d\n", b->label(), gid_wgs);
 } /* geoid_cb */
 
@@ -1238,6 +1294,7 @@ void height_cb(Fl_Widget *w, void *p)
     case 3: hsel =  1; break; // Copy unchanged to output
     default: break;
   }
+  geo_ctx_default_update();
   xlog("height_cb: button = %s, hsel = %d\n", b->label(), hsel);
 } /* height_cb */
 
@@ -1483,6 +1540,7 @@ int main(int argc, char *argv[])
   tr = 1;      // default transformation: xy (d96tm) --> fila (etrs89)
   rev = 0;     // don't reverse xy/fila
   wdms = 0;    // don't write DMS
+  rtrip = 0;   // no round-trip verification
   gid_wgs = 1; // default geoid: slo2000
   hsel = -1;   // no default height processing (use internal recommendations)
   ft = 1;      // file type: XYZ